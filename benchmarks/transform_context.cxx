@@ -0,0 +1,155 @@
+/*
+ * Copyright (C) 2026 xmlwrapp contributors
+ * All Rights Reserved
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name of the Author nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ * USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * This program measures the throughput of many small transformations done
+ * with the same stylesheet, which is dominated by the per-transformation
+ * overhead. It compares creating a new libxslt transformation context for
+ * every transformation, which is what xslt::stylesheet used to do, with
+ * xslt::stylesheet::transform(), which reuses the contexts.
+ *
+ * Usage: transform_context [input size in KB] [number of transformations]
+ */
+
+// xmlwrapp include
+#include <xsltwrapp/xsltwrapp.h>
+
+// libxml2 and libxslt includes
+#include <libxml/parser.h>
+#include <libxslt/xsltInternals.h>
+#include <libxslt/transform.h>
+
+// standard includes
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+namespace
+{
+
+const char *stylesheet_text =
+    "<xsl:stylesheet version='1.0'"
+    "                xmlns:xsl='http://www.w3.org/1999/XSL/Transform'>"
+    "<xsl:output method='xml'/>"
+    "<xsl:param name='currency' select=\"'EUR'\"/>"
+    "<xsl:template match='/'>"
+    "  <prices currency='{$currency}'>"
+    "    <xsl:apply-templates select='catalog/item'/>"
+    "  </prices>"
+    "</xsl:template>"
+    "<xsl:template match='item'>"
+    "  <price id='{@id}'><xsl:value-of select='@price * 1.2'/></price>"
+    "</xsl:template>"
+    "</xsl:stylesheet>";
+
+
+std::string make_document(std::size_t size)
+{
+    std::string data("<catalog>\n");
+
+    for (unsigned long i = 0; data.size() < size; ++i)
+    {
+        std::ostringstream item;
+        item << "  <item id=\"" << i << "\" price=\"" << i % 1000 << "\">"
+             << "<name>Item number " << i << "</name>"
+             << "</item>\n";
+        data += item.str();
+    }
+
+    data += "</catalog>\n";
+    return data;
+}
+
+
+double per_second(std::clock_t start, int count)
+{
+    const double seconds = static_cast<double>(std::clock() - start) / CLOCKS_PER_SEC;
+    return seconds > 0 ? count / seconds : 0;
+}
+
+} // anonymous namespace
+
+
+int main(int argc, char *argv[])
+{
+    const std::size_t size_kb = argc > 1 ? std::atoi(argv[1]) : 2;
+    const int count = argc > 2 ? std::atoi(argv[2]) : 20000;
+
+    xslt::init init;
+
+    const std::string data = make_document(size_kb * 1024);
+    const std::size_t style_size = std::strlen(stylesheet_text);
+
+    // libxslt takes ownership of the stylesheet document
+    xmlDocPtr input_doc = xmlReadMemory(data.c_str(), data.size(), 0, 0, 0);
+    xmlDocPtr style_doc = xmlReadMemory(stylesheet_text, style_size, 0, 0, 0);
+    xsltStylesheetPtr raw_style = style_doc ? xsltParseStylesheetDoc(style_doc) : 0;
+
+    xml::tree_parser parser(data.c_str(), data.size());
+    xml::tree_parser style_parser(stylesheet_text, style_size);
+    if (!input_doc || !raw_style || !parser || !style_parser)
+    {
+        std::cerr << argv[0] << ": error parsing the generated documents\n";
+        return 1;
+    }
+
+    const xslt::stylesheet style(style_parser.get_document());
+    const xml::document& input = parser.get_document();
+
+    std::cout << "input size: " << data.size() << " bytes, "
+              << count << " transformations\n";
+
+    std::clock_t start = std::clock();
+    for (int i = 0; i < count; ++i)
+    {
+        xsltTransformContextPtr ctxt = xsltNewTransformContext(raw_style, input_doc);
+        xmlDocPtr result =
+            xsltApplyStylesheetUser(raw_style, input_doc, NULL, NULL, NULL, ctxt);
+        xsltFreeTransformContext(ctxt);
+        xmlFreeDoc(result);
+    }
+    std::cout << "new context per transformation:  "
+              << per_second(start, count) << " transformations/s\n";
+
+    start = std::clock();
+    for (int i = 0; i < count; ++i)
+        style.transform(input);
+    std::cout << "xslt::stylesheet::transform():   "
+              << per_second(start, count) << " transformations/s\n";
+
+    xsltFreeStylesheet(raw_style);
+    xmlFreeDoc(input_doc);
+    return 0;
+}
@@ -65,6 +65,25 @@ namespace impl
         T &t_;
     };
 
+    // helper for xml::node::remove_if()
+    struct XMLWRAPP_API cbfo_node_predicate
+            : public std::unary_function<xml::node, bool>
+    {
+        virtual ~cbfo_node_predicate() {}
+        virtual bool operator()(const xml::node& n) = 0;
+    };
+
+    template<typename T>
+    struct predicate_callback : public cbfo_node_predicate
+    {
+        predicate_callback(T& t) : t_(t) {}
+
+        bool operator()(const xml::node& n)
+            { return t_(n); }
+
+        T &t_;
+    };
+
 } // namespace impl
 
 } // namespace xml
@@ -56,7 +56,6 @@ class node;
 
 namespace impl
 {
-class ait_impl;
 struct node_impl;
 }
 
@@ -103,7 +102,20 @@ public:
 
     ~attributes();
 
+    /**
+        Controls whether find() falls back to default attribute values
+        declared in the document's DTD.
+
+        @since 0.7.0
+     */
+    enum default_values
+    {
+        use_dtd_defaults,   ///< Return DTD default if the attribute is missing
+        ignore_dtd_defaults ///< Only return attributes present on the node
+    };
+
     // forward declarations
+    class iterator;
     class const_iterator;
 
     /**
@@ -123,6 +135,10 @@ public:
         /**
             Get the value of this attribute.
 
+            The returned pointer points directly into the document tree if
+            the value is plain text and is only valid until the attribute is
+            modified or removed.
+
             @return The value for this attribute.
          */
         const char* get_value() const;
@@ -130,18 +146,21 @@ public:
     private:
         void *node_;
         void *prop_;
-        std::string name_;
-        mutable std::string value_;
+        bool fake_;     // prop_ is a DTD attribute declaration
+        mutable void *value_;   // only accessed by impl::cache_string()
 
         attr();
         attr(const attr& other);
         attr& operator=(const attr& other);
+        ~attr();
         void swap(attr& other);
 
-        void set_data(void *node, void *prop);
-        void set_data(const char *name, const char *value, bool);
+        void set_data(void *node, void *prop, bool fake);
 
-        friend class impl::ait_impl;
+        friend class iterator;
+        friend class const_iterator;
+        friend bool XMLWRAPP_API operator==(const iterator& lhs, const iterator& rhs);
+        friend bool XMLWRAPP_API operator==(const const_iterator& lhs, const const_iterator& rhs);
     };
 
     /**
@@ -174,10 +193,9 @@ public:
         friend bool XMLWRAPP_API operator!=(const iterator& lhs, const iterator& rhs);
 
     private:
-        impl::ait_impl *pimpl_;
+        mutable attr attr_;
 
-        iterator(void *node, void *prop);
-        iterator(const char *name, const char *value, bool);
+        iterator(void *node, void *prop, bool fake = false);
         void swap(iterator& other);
         void* get_raw_attr();
 
@@ -216,16 +234,81 @@ public:
         friend bool XMLWRAPP_API operator!= (const const_iterator &lhs, const const_iterator &rhs);
 
     private:
-        impl::ait_impl *pimpl_;
+        mutable attr attr_;
 
-        const_iterator(void *node, void *prop);
-        const_iterator(const char *name, const char *value, bool);
+        const_iterator(void *node, void *prop, bool fake = false);
         void swap(const_iterator &other);
         void* get_raw_attr();
 
         friend class attributes;
     };
 
+    /**
+        The xml::attributes::name_set class holds a fixed list of attribute
+        names prepared for looking them all up at once with
+        xml::attributes::find(const name_set&, iterator*). Create it once and
+        reuse it for every element you need to process.
+
+        A name may be added more than once, in which case all of its entries
+        receive the same result.
+
+        A const name_set may be used by several threads at once. It remembers
+        the names as stored in the dictionary of the last document it was
+        used with, which keeps that dictionary in memory until the name_set
+        is used with another document or destroyed.
+
+        @since 0.7.0
+     */
+    class XMLWRAPP_API name_set
+    {
+    public:
+        /**
+            Create an empty name_set. Use add() to fill it.
+         */
+        name_set();
+
+        /**
+            Create a name_set from an array of names.
+
+            @param names Array of attribute names.
+            @param count Number of entries in @a names.
+         */
+        name_set(const char * const *names, size_type count);
+
+        name_set(const name_set& other);
+        name_set& operator=(const name_set& other);
+        void swap(name_set& other);
+        ~name_set();
+
+        /**
+            Add another name to the set.
+
+            @param name The attribute name to add.
+            @return The index at which results for this name will be stored.
+         */
+        size_type add(const char *name);
+
+        /**
+            Get the number of names in this set.
+
+            @return The number of names.
+         */
+        size_type size() const;
+
+        /**
+            Get the name stored at the given index.
+
+            @param index Index of the name, less than size().
+            @return The name.
+         */
+        const char* get_name(size_type index) const;
+
+    private:
+        struct pimpl; pimpl *pimpl_;
+
+        friend class attributes;
+    };
+
     /**
         Get an iterator that points to the first attribute.
 
@@ -275,12 +358,13 @@ public:
         This is, of course, if there was a DTD parsed with the XML document.
 
         @param name The name of the attribute to find.
+        @param defaults Pass ignore_dtd_defaults to not search the DTD.
         @return An iterator that points to the attribute with the given name.
         @return If the attribute was not found, find will return end().
         @see xml::attributes::iterator
         @see xml::attributes::attr
      */
-    iterator find(const char *name);
+    iterator find(const char *name, default_values defaults = use_dtd_defaults);
 
     /**
         Find the attribute with the given name. If the attribute is not found
@@ -288,12 +372,48 @@ public:
         This is, of course, if there was a DTD parsed with the XML document.
 
         @param name The name of the attribute to find.
+        @param defaults Pass ignore_dtd_defaults to not search the DTD.
         @return A const_iterator that points to the attribute with the given name.
         @return If the attribute was not found, find will return end().
         @see xml::attributes::const_iterator
         @see xml::attributes::attr
      */
-    const_iterator find(const char *name) const;
+    const_iterator find(const char *name,
+                        default_values defaults = use_dtd_defaults) const;
+
+    /**
+        Find several attributes at once. This is equivalent to calling
+        find(const char*) for every name in @a names, but the attribute list
+        is only traversed once and the DTD, if any, is only consulted once
+        for all the names that were not found on the node itself.
+
+        @param names The names of the attributes to find.
+        @param results Array of at least names.size() iterators. The entry
+                       with the same index as the name is set to point to
+                       the attribute, or to end() if it was not found.
+        @param defaults Pass ignore_dtd_defaults to not search the DTD.
+        @return The number of entries of @a names that were found.
+        @since 0.7.0
+     */
+    size_type find(const name_set& names, iterator *results,
+                   default_values defaults = use_dtd_defaults);
+
+    /**
+        Find several attributes at once. This is equivalent to calling
+        find(const char*) const for every name in @a names, but the attribute
+        list is only traversed once and the DTD, if any, is only consulted
+        once for all the names that were not found on the node itself.
+
+        @param names The names of the attributes to find.
+        @param results Array of at least names.size() const_iterators. The
+                       entry with the same index as the name is set to point
+                       to the attribute, or to end() if it was not found.
+        @param defaults Pass ignore_dtd_defaults to not search the DTD.
+        @return The number of entries of @a names that were found.
+        @since 0.7.0
+     */
+    size_type find(const name_set& names, const_iterator *results,
+                   default_values defaults = use_dtd_defaults) const;
 
     /**
         Erase the attribute that is pointed to by the given iterator. This
@@ -340,6 +460,12 @@ private:
 
     void set_data (void *node);
     void* get_data();
+
+    // common implementation of both find(const name_set&) overloads
+    template<typename Iterator>
+    size_type find_names(const name_set& names, Iterator *results,
+                         default_values defaults) const;
+
     friend struct impl::node_impl;
     friend class node;
 };
@@ -54,6 +54,8 @@ namespace xslt
 {
 
 class stylesheet;
+class pipeline;
+class document_loader;
 namespace impl
 {
 class result;
@@ -430,6 +432,39 @@ public:
      */
     bool save_to_file(const char *filename, int compression_level = 0) const;
 
+    /**
+        Convert the XML document tree into XML text data using several
+        threads and place it into the given string. The result is exactly
+        the same as with save_to_string().
+
+        The children of the root node are split into contiguous ranges and
+        each range is converted by its own thread. If this is not possible,
+        e.g. because the root node has less than two children, or the
+        document uses an encoding other than UTF-8, ASCII or one of the
+        ISO-8859 encodings, the document is converted in the calling thread.
+
+        @param s The string to place the XML text data.
+        @param thread_count The maximum number of threads to use, 0 means
+                            one thread per processor.
+     */
+    void save_to_string_parallel(std::string& s, unsigned thread_count = 0) const;
+
+    /**
+        Convert the XML document tree into XML text data using several
+        threads and save it into the given file. The file contents are
+        exactly the same as with save_to_file() without compression.
+
+        The document is converted as described for save_to_string_parallel()
+        and the converted pieces are written to the file at once.
+
+        @param filename The name of the file to place the XML text data into.
+        @param thread_count The maximum number of threads to use, 0 means
+                            one thread per processor.
+        @return True if the data was saved successfully.
+        @return False otherwise.
+     */
+    bool save_to_file_parallel(const char *filename, unsigned thread_count = 0) const;
+
     /**
         Convert the XML document tree into XML text data and then insert it
         into the given stream.
@@ -450,7 +485,10 @@ private:
     void* release_doc_data();
 
     friend class tree_parser;
+    friend class node;
     friend class xslt::stylesheet;
+    friend class xslt::pipeline;
+    friend class xslt::document_loader;
 };
 
 } // namespace xml
@@ -0,0 +1,156 @@
+/*
+ * Copyright (C) 2026 xmlwrapp contributors
+ * All Rights Reserved
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name of the Author nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ * USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+
+/**
+    @file
+
+    This file contains the definition of the xml::error_capture class.
+ */
+
+#ifndef _xmlwrapp_errors_h_
+#define _xmlwrapp_errors_h_
+
+// xmlwrapp includes
+#include "xmlwrapp/init.h"
+#include "xmlwrapp/export.h"
+
+// standard includes
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace xml
+{
+
+/**
+    The xml::error_capture class gives access to the errors recently reported
+    by libxml2 and libxslt in the current thread.
+
+    Most errors are reported by xmlwrapp itself, e.g. by xml::tree_parser or
+    xslt::stylesheet, but some of them, such as XPath errors or the errors
+    in the documents loaded indirectly, are not associated with any xmlwrapp
+    object. All of them are kept in a ring buffer, separate for each thread,
+    which keeps only the most recent errors and can be examined after any
+    call to xmlwrapp.
+
+    Nothing is done unless an error happens, and recording one only copies
+    the message already formatted by libxml2, so this doesn't slow down the
+    programs which never look at the errors.
+
+    The errors reported by libxslt outside of the transformations, e.g. when
+    compiling a stylesheet, only have a message: their code and line are 0.
+ */
+class XMLWRAPP_API error_capture
+{
+public:
+    /// The severity of an error.
+    enum level_type
+    {
+        level_warning = 1,  ///< A warning, the operation succeeded.
+        level_error = 2,    ///< A recoverable error.
+        level_fatal = 3     ///< A fatal error, the operation failed.
+    };
+
+    /// A single error reported by libxml2 or libxslt.
+    struct error_info
+    {
+        /// The libxml2 error code, one of xmlParserErrors values.
+        int code;
+
+        /// The part of libxml2 reporting the error, one of xmlErrorDomain values.
+        int domain;
+
+        /// The severity of the error.
+        level_type level;
+
+        /// The file in which the error occurred, empty if not known.
+        std::string file;
+
+        /// The line number in the file or 0 if not known.
+        int line;
+
+        /// The error message, without the trailing new line.
+        std::string message;
+    };
+
+    /// The type of the list of errors returned by get_errors().
+    typedef std::vector<error_info> errors_type;
+
+    /// The number of errors kept by default.
+    static const std::size_t default_capacity = 32;
+
+    /**
+        Get the errors kept for the current thread, from the oldest to the
+        most recent one.
+
+        @return The list of errors, empty if there were none.
+     */
+    static errors_type get_errors();
+
+    /**
+        Get the total number of errors reported in the current thread,
+        including those that are no longer kept. Comparing the values
+        returned before and after a call tells how many errors it caused.
+
+        @return The number of errors.
+     */
+    static unsigned long get_total();
+
+    /// Forget all the errors kept for the current thread.
+    static void clear();
+
+    /**
+        Set the number of errors kept for the current thread. If it's less
+        than the number of errors currently kept, the oldest ones are
+        forgotten.
+
+        @param capacity The number of errors or 0 to not keep any (they are
+                        still counted by get_total()).
+     */
+    static void set_capacity(std::size_t capacity);
+
+    /**
+        Get the number of errors kept for the current thread.
+
+        @return The maximal number of errors kept.
+     */
+    static std::size_t get_capacity();
+
+private:
+    // xml::error_capture only has static members
+    error_capture();
+}; // end xml::error_capture class
+
+} // namespace xml
+
+#endif // _xmlwrapp_errors_h_
@@ -53,7 +53,23 @@ namespace xml
     you start any threads or use any other part of xmlwrapp. The member
     functions may alter global and/or static variables and affect the behavior
     of subsequently created classes (and the parser in particular).
-    In other words, this class is not thread safe.
+
+    Creating and destroying xml::init objects is thread safe: the library is
+    initialized when the first one is created and shut down when the last one
+    is destroyed, even if this happens in different threads.
+
+    By default, every source file including xmlwrapp headers creates a static
+    xml::init object, so the library is initialized when the program starts.
+    If @c XMLWRAPP_LAZY_INIT is defined before including them, this object is
+    not created and the library is initialized only when it's used for the
+    first time instead, e.g. by parsing a document. The library initialized
+    in this way is never shut down.
+
+    This is an opt-in for applications: xmlwrapp itself is built without
+    @c XMLWRAPP_LAZY_INIT by default and so still initializes the library
+    when it's loaded. To avoid this, xmlwrapp must be built with this macro
+    defined too, e.g. by passing @c CPPFLAGS=-DXMLWRAPP_LAZY_INIT to its
+    configure script.
 
     @note In xmlwrapp versions prior to 0.6.0, this class was used to initialize
           the library and exactly one instance had to be created before first
@@ -114,15 +130,12 @@ public:
 private:
     init(const init&);
     init& operator=(const init&);
-
-    void init_library();
-    void shutdown_library();
-
-    static int ms_counter;
 };
 
 } // namespace xml
 
+#ifndef XMLWRAPP_LAZY_INIT
+
 // use a "nifty counter" to ensure that any source file that uses xmlwrapp
 // will initialize the library prior to its first use
 namespace
@@ -130,4 +143,6 @@ namespace
     xml::init g_xmlwrapp_initializer;
 }
 
+#endif // !XMLWRAPP_LAZY_INIT
+
 #endif // _xmlwrapp_init_h_
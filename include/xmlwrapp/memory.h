@@ -0,0 +1,160 @@
+/*
+ * Copyright (C) 2026 xmlwrapp contributors
+ * All Rights Reserved
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name of the Author nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ * USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+
+/**
+    @file
+
+    This file contains the definition of the xml::memory class.
+ */
+
+#ifndef _xmlwrapp_memory_h_
+#define _xmlwrapp_memory_h_
+
+// xmlwrapp includes
+#include "xmlwrapp/init.h"
+#include "xmlwrapp/export.h"
+
+// standard includes
+#include <cstddef>
+
+namespace xml
+{
+
+/**
+    The xml::memory class controls how the memory used by libxml2, libxslt
+    and xmlwrapp itself is allocated and can report how much of it is used
+    by each thread.
+
+    The allocator can only be changed and the statistics enabled before the
+    memory is allocated for the first time, i.e. before the library is
+    initialized. As the library is initialized when the program starts by
+    default, this requires building both xmlwrapp and the program with
+    @c XMLWRAPP_LAZY_INIT defined (see xml::init) and calling the
+    xml::memory functions before any other use of xmlwrapp.
+    Also, libxml2 must not have been used by any other code before.
+
+    By default, neither is done and xml::memory has no overhead at all.
+ */
+class XMLWRAPP_API memory
+{
+public:
+    /**
+        The functions used for allocating memory. They have the same
+        semantics as the standard malloc(), realloc() and free() functions
+        and must be safe to call from several threads at once.
+     */
+    struct allocator
+    {
+        void* (*allocate)(std::size_t size);
+        void* (*reallocate)(void *ptr, std::size_t size);
+        void (*deallocate)(void *ptr);
+    };
+
+    /**
+        The memory usage of a single thread.
+
+        The memory freed by another thread than the one which allocated it
+        is counted by the thread freeing it, so current_bytes may even be
+        negative for the threads which mostly free the memory allocated
+        elsewhere.
+     */
+    struct statistics
+    {
+        /**
+            The number of allocations. A reallocation counts as both an
+            allocation and a deallocation.
+         */
+        unsigned long allocations;
+
+        /// The number of deallocations.
+        unsigned long deallocations;
+
+        /// The total number of bytes allocated.
+        unsigned long allocated_bytes;
+
+        /// The number of bytes allocated and not freed yet.
+        long current_bytes;
+
+        /// The highest value of current_bytes since the last reset.
+        long peak_bytes;
+    };
+
+    /**
+        Use the given functions for all the memory allocations. This must be
+        done before the library is initialized.
+
+        @param alloc The allocation functions, all of which must be set.
+        @exception xml::exception If the memory was already allocated.
+     */
+    static void set_allocator(const allocator& alloc);
+
+    /**
+        Enable collecting the statistics of memory usage. This must be done
+        before the library is initialized.
+
+        Each block allocated by libxml2 is then prefixed by a small header
+        containing its size, as libxml2 doesn't pass it when freeing it.
+
+        @exception xml::exception If the memory was already allocated.
+     */
+    static void enable_statistics();
+
+    /**
+        Check if the statistics of memory usage are collected.
+
+        @return True if enable_statistics() was called.
+     */
+    static bool statistics_enabled();
+
+    /**
+        Get the memory usage of the current thread.
+
+        @return The statistics, all zero unless statistics_enabled().
+     */
+    static statistics get_statistics();
+
+    /**
+        Reset the statistics of the current thread. The number of bytes
+        currently allocated is kept and the peak usage is set to it, the
+        other counters are set to 0.
+     */
+    static void reset_statistics();
+
+private:
+    // xml::memory only has static members
+    memory();
+}; // end xml::memory class
+
+} // namespace xml
+
+#endif // _xmlwrapp_memory_h_
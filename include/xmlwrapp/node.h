@@ -51,6 +51,13 @@
 #include <cstddef>
 #include <iosfwd>
 #include <string>
+#include <vector>
+
+// forward declaration
+namespace xslt
+{
+class extension_call;
+}
 
 namespace xml
 {
@@ -164,6 +171,105 @@ public:
         const char *t;
     };
 
+    /**
+        The xml::node::sort_keys class describes how to sort child elements
+        by the values of their attributes using
+        xml::node::sort(const char*, const sort_keys&).
+
+        Nodes are ordered by the first key; nodes with equal first keys are
+        ordered by the second one and so on. A node without the attribute
+        (and without a default value for it in the DTD) sorts before all
+        nodes that have it.
+
+        @code
+        xml::node::sort_keys keys("price", xml::node::sort_keys::number);
+        keys.add("title");
+        catalog.sort("book", keys);
+        @endcode
+
+        @since 0.7.0
+     */
+    class XMLWRAPP_API sort_keys
+    {
+    public:
+        /// How the attribute values are compared
+        enum key_type
+        {
+            string, ///< Compare values as strings, byte by byte
+            number  ///< Compare values as numbers; non-numbers count as missing
+        };
+
+        /// Sort direction of a key
+        enum key_order
+        {
+            ascending,  ///< Smallest values first
+            descending  ///< Largest values first
+        };
+
+        /**
+            Create an empty list of keys. Use add() to fill it.
+         */
+        sort_keys();
+
+        /**
+            Create a list of keys containing a single key.
+
+            @param attr_name Name of the attribute to sort by.
+            @param type How to compare the attribute values.
+            @param order The sort direction.
+         */
+        explicit sort_keys(const char *attr_name,
+                           key_type type = string,
+                           key_order order = ascending);
+
+        sort_keys(const sort_keys& other);
+        sort_keys& operator=(const sort_keys& other);
+        void swap(sort_keys& other);
+        ~sort_keys();
+
+        /**
+            Add another key, used for nodes that compare equal using all the
+            keys added before it.
+
+            @param attr_name Name of the attribute to sort by.
+            @param type How to compare the attribute values.
+            @param order The sort direction.
+         */
+        void add(const char *attr_name,
+                 key_type type = string,
+                 key_order order = ascending);
+
+        /**
+            Get the number of keys.
+
+            @return The number of keys.
+         */
+        size_type size() const;
+
+        /**
+            Request a stable sort, i.e. one that preserves the relative
+            order of nodes with equal keys. The default is false.
+
+            @param flag True to use stable sort.
+         */
+        void set_stable(bool flag);
+
+        /**
+            Sort using several threads when there are at least the given
+            number of nodes to sort. The default is 0, which means to never
+            use more than the calling thread.
+
+            @param min_nodes The minimal number of nodes to sort in
+                             parallel, or 0 to disable parallel sorting.
+         */
+        void set_parallel_threshold(size_type min_nodes);
+
+    private:
+        struct pimpl; pimpl *pimpl_;
+
+        friend class node;
+    };
+
     /**
         Construct a new blank xml::node.
      */
@@ -323,6 +429,9 @@ public:
         This function may change in the future to return std::string.
         Feedback is welcome.
 
+        The returned string remains valid until the node or its children are
+        modified.
+
         @return The content or 0.
      */
     const char* get_content() const;
@@ -733,6 +842,84 @@ public:
      */
     iterator insert(const iterator& position, const node& n);
 
+    /**
+        Insert copies of all nodes in the given range as children of this
+        node. The new nodes will be inserted before the node pointed to by
+        the given iterator, in the same order as they appear in the range.
+
+        All the copies are made before any of them is inserted, so the
+        range may contain children of this node too. Text nodes are merged
+        with adjacent text nodes, as when inserting a single node.
+
+        This is a convenience function: every node is still copied just as
+        by insert(const iterator&, const node&), it's not faster than
+        inserting the nodes one by one. Use adopt_from() to move nodes
+        without copying them.
+
+        @param position An iterator that points to the location where the new nodes should be inserted (before it).
+        @param first The first node to insert.
+        @param last An iterator that points one past the last node to insert.
+        @return An iterator that points to the first inserted node, or
+                @a position if the range is empty.
+        @since 0.7.0
+     */
+    template <typename InputIterator>
+    iterator insert(const iterator& position, InputIterator first, InputIterator last)
+    {
+        std::vector<void*> nodes;
+        for ( ; first != last; ++first)
+            nodes.push_back(raw_node(*first));
+        return insert_range(position, nodes);
+    }
+
+    /**
+        Add copies of all nodes in the given range, e.g. a standard container
+        of xml::node objects or a xml::nodes_view, at the end of the child
+        list of this node.
+
+        @param range Any object with begin() and end() methods returning
+                     iterators over xml::node objects.
+        @since 0.7.0
+     */
+    template <typename Range>
+    void append(const Range& range)
+        { insert(end(), range.begin(), range.end()); }
+
+    /**
+        Move a node, together with all its children, from another document
+        to the end of the child list of this node. Unlike insert(), the node
+        is not copied: it is unlinked from the source document and relinked
+        here, with its namespaces and strings fixed up to belong to this
+        node's document. This invalidates any iterators pointing to the
+        moved node in the source document.
+
+        If this node is not part of any document, the moved node is copied
+        and the original is erased from the source document.
+
+        @param source The document containing the node to move.
+        @param child An iterator that points to the node to move. It must not
+                     be the root node of @a source or an ancestor of this node.
+        @return An iterator that points to the moved node. If a text node is
+                moved next to another text node, they are merged and the
+                iterator points to the merged node.
+        @since 0.7.0
+     */
+    iterator adopt_from(document& source, const iterator& child);
+
+    /**
+        Move a node, together with all its children, from another document
+        into the child list of this node, before the node pointed to by the
+        given iterator. See adopt_from(document&, const iterator&) for
+        details.
+
+        @param position An iterator that points to the location where the moved node should be inserted (before it).
+        @param source The document containing the node to move.
+        @param child An iterator that points to the node to move.
+        @return An iterator that points to the moved node.
+        @since 0.7.0
+     */
+    iterator adopt_from(const iterator& position, document& source, const iterator& child);
+
     /**
         Replace the node pointed to by the given iterator with another node.
         The old node will be removed, including all its children, and
@@ -779,6 +966,27 @@ public:
      */
     size_type erase(const char *name);
 
+    /**
+        Erase all children nodes for which the given predicate returns true.
+        All the children are checked in a single pass, including those
+        that are not elements. This will invalidate any iterators that point
+        to the nodes to be erased, or any pointers or references to those
+        nodes.
+
+        The predicate is called with a xml::node object that refers to the
+        child being checked and is reused for all of them, so it must not
+        keep references to it. If the predicate throws an exception, the
+        nodes checked before it remain erased.
+
+        @param pred The unary function object called with a const
+                    xml::node reference.
+        @return The number of nodes removed.
+        @since 0.7.0
+     */
+    template <typename T>
+    size_type remove_if(T pred)
+        { impl::predicate_callback<T> cb(pred); return remove_if_fo(cb); }
+
     /**
         Erases all children nodes.
 
@@ -799,11 +1007,33 @@ public:
      */
     void sort(const char *node_name, const char *attr_name);
 
+    /**
+        Sort all the children nodes of this node using the values of one or
+        more of their attributes. Only nodes that are of
+        xml::node::type_element will be sorted, and they must have the given
+        node_name. The sorted nodes are placed after all the other children.
+
+        The attribute values are read only once for every node, so this is
+        much faster than sorting with a comparison function object that
+        reads them itself.
+
+        @param node_name The name of the nodes to sort.
+        @param keys The attributes to sort on and how to sort.
+        @since 0.7.0
+     */
+    void sort(const char *node_name, const sort_keys& keys);
+
     /**
         Sort all the children nodes of this node using the given comparison
         function object. All element type nodes will be considered for
         sorting.
 
+        The function object is called with xml::node objects referring to
+        the children being sorted. The same two objects are reused for all
+        comparisons, so the function object must not keep references to
+        them. If it throws an exception, the children are left in their
+        original order.
+
         @param compare The binary function object to call in order to sort all child nodes.
      */
     template <typename T> void sort (T compare)
@@ -837,12 +1067,17 @@ private:
     void* release_node_data();
 
     void sort_fo(impl::cbfo_node_compare &fo);
+    size_type remove_if_fo(impl::cbfo_node_predicate &pred);
+
+    static void* raw_node(const node& n);
+    iterator insert_range(const iterator& position, const std::vector<void*>& nodes);
 
     friend class tree_parser;
     friend class impl::node_iterator;
     friend class document;
     friend struct impl::doc_impl;
     friend struct impl::node_cmp;
+    friend class xslt::extension_call;
 };
 
 } // namespace xml
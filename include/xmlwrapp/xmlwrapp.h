@@ -42,5 +42,7 @@
 #include "xmlwrapp/tree_parser.h"
 #include "xmlwrapp/event_parser.h"
 #include "xmlwrapp/exception.h"
+#include "xmlwrapp/errors.h"
+#include "xmlwrapp/memory.h"
 
 #endif // _xmlwrapp_xmlwrapp_h_
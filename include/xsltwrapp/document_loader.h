@@ -0,0 +1,132 @@
+/*
+ * Copyright (C) 2001-2003 Peter J Jones (pjones@pmade.org)
+ * All Rights Reserved
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name of the Author nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ * USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+
+/**
+    @file
+
+    This file contains the definition of the xslt::document_loader class.
+ */
+
+#ifndef _xsltwrapp_document_loader_h_
+#define _xsltwrapp_document_loader_h_
+
+// xmlwrapp includes
+#include "xsltwrapp/init.h"
+#include "xmlwrapp/document.h"
+#include "xmlwrapp/export.h"
+
+// standard includes
+#include <cstddef>
+
+namespace xslt
+{
+
+class stylesheet;
+
+/**
+    The xslt::document_loader class keeps the documents loaded by the XPath
+    document() function parsed in memory, so that they can be reused by all
+    the transformations done by the stylesheets using this loader, instead of
+    being parsed again by every transformation.
+
+    Local files are parsed when they are requested for the first time and are
+    loaded again if they are modified later. Documents that don't exist as
+    files, or that are built in memory, can be added to the loader using
+    preload() under any URI.
+
+    The cached documents are never modified, so they can be shared by any
+    number of threads. However libxslt needs to modify the loaded documents
+    when the stylesheet uses xsl:strip-space, so the transformations using such
+    stylesheets get a copy of the cached document instead.
+
+    @see xslt::stylesheet::set_document_loader()
+ */
+class XSLTWRAPP_API document_loader
+{
+public:
+    struct pimpl;
+
+    /// Create an empty loader.
+    document_loader();
+
+    /**
+        Clean up after an xslt::document_loader. The loader must not be
+        destroyed while any stylesheet still uses it.
+     */
+    ~document_loader();
+
+    /**
+        Make the document() function return (a document equal to) the given
+        document for the given URI, instead of loading it. Any document
+        previously cached for this URI is replaced.
+
+        Notice that relative URIs used with document() are resolved against
+        the base URI of the stylesheet first, so the URI given here must be
+        the resolved, i.e. usually absolute, one.
+
+        @param uri The URI of the document.
+        @param doc The document to use, it is copied by this function.
+     */
+    void preload(const char *uri, const xml::document& doc);
+
+    /**
+        Remove the document with the given URI from the loader.
+
+        @param uri The URI of the document.
+        @return True if the document was removed, false if it wasn't found.
+     */
+    bool remove(const char *uri);
+
+    /// Remove all documents from the loader.
+    void clear();
+
+    /**
+        Get the number of documents currently held by the loader.
+
+        @return The number of loaded and preloaded documents.
+     */
+    std::size_t size() const;
+
+private:
+    pimpl *pimpl_;
+
+    friend class stylesheet;
+
+    // an xslt::document_loader cannot be copied or assigned to.
+    document_loader(const document_loader&);
+    document_loader& operator=(const document_loader&);
+}; // end xslt::document_loader class
+
+} // end xslt namespace
+
+#endif // _xsltwrapp_document_loader_h_
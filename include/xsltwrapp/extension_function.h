@@ -0,0 +1,228 @@
+/*
+ * Copyright (C) 2001-2003 Peter J Jones (pjones@pmade.org)
+ * All Rights Reserved
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name of the Author nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ * USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+
+/**
+    @file
+
+    This file contains the definition of the xslt::extension_function and
+    xslt::extension_call classes.
+ */
+
+#ifndef _xsltwrapp_extension_function_h_
+#define _xsltwrapp_extension_function_h_
+
+// xmlwrapp includes
+#include "xsltwrapp/init.h"
+#include "xmlwrapp/node.h"
+#include "xmlwrapp/export.h"
+
+// standard includes
+#include <cstddef>
+#include <string>
+
+namespace xslt
+{
+
+/**
+    The xslt::extension_call class gives an extension function access to
+    the arguments it was called with and lets it set its result.
+
+    The arguments are taken from libxslt as they are and are only converted
+    to the requested type when they are accessed. Just like in XPath, any
+    argument can be converted to a string, a number or a boolean.
+
+    If the function doesn't set any result, it returns an empty string.
+ */
+class XSLTWRAPP_API extension_call
+{
+public:
+    struct pimpl;
+
+    /// The type of an argument, as it was given to the function.
+    enum value_type
+    {
+        type_node_set,      ///< A node set or a result tree fragment.
+        type_boolean,       ///< A boolean.
+        type_number,        ///< A number.
+        type_string,        ///< A string.
+        type_other          ///< Any other type, e.g. from another extension.
+    };
+
+    /**
+        Get the number of arguments the function was called with.
+
+        @return The number of arguments.
+     */
+    std::size_t size() const;
+
+    /**
+        Get the type of the given argument.
+
+        @param arg The index of the argument.
+        @return The type of the argument.
+     */
+    value_type get_type(std::size_t arg) const;
+
+    /**
+        Get the given argument converted to a string, as the XPath string()
+        function does.
+
+        @param arg The index of the argument.
+        @return The string value of the argument.
+        @exception xml::exception if there is no such argument.
+     */
+    std::string get_string(std::size_t arg) const;
+
+    /**
+        Get the given argument converted to a number, as the XPath number()
+        function does.
+
+        @param arg The index of the argument.
+        @return The numeric value of the argument, NaN if it isn't a number.
+        @exception xml::exception if there is no such argument.
+     */
+    double get_number(std::size_t arg) const;
+
+    /**
+        Get the given argument converted to a boolean, as the XPath boolean()
+        function does.
+
+        @param arg The index of the argument.
+        @return The boolean value of the argument.
+        @exception xml::exception if there is no such argument.
+     */
+    bool get_boolean(std::size_t arg) const;
+
+    /**
+        Get the number of nodes in the given node set argument.
+
+        @param arg The index of the argument.
+        @return The number of nodes, 0 if the argument is not a node set.
+        @exception xml::exception if there is no such argument.
+     */
+    std::size_t get_node_count(std::size_t arg) const;
+
+    /**
+        Get the string value of a node in the given node set argument.
+
+        @param arg The index of the argument.
+        @param index The index of the node in the node set, in document
+                     order.
+        @return The string value of the node.
+        @exception xml::exception if there is no such argument or node.
+     */
+    std::string get_node_string(std::size_t arg, std::size_t index) const;
+
+    /**
+        Return the given string from the function.
+
+        @param value The result of the function.
+     */
+    void return_string(const std::string& value);
+
+    /**
+        Return the given number from the function.
+
+        @param value The result of the function.
+     */
+    void return_number(double value);
+
+    /**
+        Return the given boolean from the function.
+
+        @param value The result of the function.
+     */
+    void return_boolean(bool value);
+
+    /**
+        Add a copy of the given node, with all of its children, to the node
+        set returned from the function. This can be called several times to
+        return several nodes.
+
+        @param n The node to copy.
+     */
+    void add_result_node(const xml::node& n);
+
+    /**
+        Add a node from the given node set argument to the node set returned
+        from the function. The node is not copied, so this is the way to
+        return a subset of the nodes the function was given.
+
+        @param arg The index of the node set argument.
+        @param index The index of the node in the node set, in document
+                     order.
+        @exception xml::exception if there is no such argument or node.
+     */
+    void add_result_node(std::size_t arg, std::size_t index);
+
+private:
+    pimpl *pimpl_;
+
+    explicit extension_call(pimpl *impl) : pimpl_(impl) { }
+
+    // an xslt::extension_call cannot be copied or assigned to.
+    extension_call(const extension_call&);
+    extension_call& operator=(const extension_call&);
+
+    friend struct pimpl;
+}; // end xslt::extension_call class
+
+
+/**
+    The xslt::extension_function class is the base class for XPath
+    extension functions implemented in C++. Derive from it, override
+    execute() and register an instance with
+    xslt::stylesheet::register_function() to make it callable from the
+    stylesheet.
+
+    If the stylesheet is used by several threads at once, execute() may be
+    called concurrently too.
+ */
+class XSLTWRAPP_API extension_function
+{
+public:
+    virtual ~extension_function() { }
+
+    /**
+        Override this member function to implement the extension function.
+        Throwing an exception from it makes the transformation fail with
+        the exception message as the error message.
+
+        @param call The arguments of the function and its result.
+     */
+    virtual void execute(extension_call& call) = 0;
+}; // end xslt::extension_function class
+
+} // end xslt namespace
+
+#endif // _xsltwrapp_extension_function_h_
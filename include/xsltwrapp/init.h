@@ -52,8 +52,12 @@ namespace xslt
 
     If you want to use any of the xslt::init member functions, do so before
     you start any threads or use any other part of xsltwrapp. The member
-    functions may alter global and/or static variables. In other words, this
-    class is not thread safe.
+    functions may alter global and/or static variables.
+
+    Like xml::init, xslt::init objects may be created and destroyed in any
+    thread and @c XMLWRAPP_LAZY_INIT can be defined, both when building
+    xmlwrapp and the application, to initialize libxslt only when the first
+    stylesheet is created.
 
     @note In xmlwrapp versions prior to 0.6.0, this class was used to initialize
           the library and exactly one instance had to be created before first
@@ -63,6 +67,22 @@ namespace xslt
 class XSLTWRAPP_API init : public xml::init
 {
 public:
+    /// The EXSLT modules that can be made available to the stylesheets.
+    enum exslt_module
+    {
+        exslt_none      = 0,
+        exslt_common    = 0x0001, ///< http://exslt.org/common
+        exslt_math      = 0x0002, ///< http://exslt.org/math
+        exslt_sets      = 0x0004, ///< http://exslt.org/sets
+        exslt_functions = 0x0008, ///< http://exslt.org/functions
+        exslt_strings   = 0x0010, ///< http://exslt.org/strings
+        exslt_dates     = 0x0020, ///< http://exslt.org/dates-and-times
+        exslt_dynamic   = 0x0040, ///< http://exslt.org/dynamic
+        exslt_saxon     = 0x0080, ///< http://icl.com/saxon
+        exslt_crypto    = 0x0100, ///< http://exslt.org/crypto
+        exslt_all       = 0x01ff
+    };
+
     init();
     ~init();
 
@@ -75,17 +95,36 @@ public:
      */
     static void process_xincludes(bool flag);
 
+    /**
+        This function selects the EXSLT modules available to the stylesheets.
+        The modules are registered with libxslt when the first stylesheet is
+        created, so this should be called before creating any of them.
+        Modules that were already registered can't be removed. The default
+        is exslt_all.
+
+        @param modules Combination of exslt_module values.
+     */
+    static void exslt_modules(int modules);
+
+    /**
+        This function controls whether the EXSLT modules selected by
+        exslt_modules() are all registered when the first stylesheet is
+        created or each of them only when a stylesheet declaring its
+        namespace, possibly in an imported or included file, is created for
+        the first time. The default is false.
+
+        @param flag True to register the modules only when they're used.
+     */
+    static void exslt_on_demand(bool flag);
+
 private:
     init(const init&);
     init& operator=(const init&);
-
-    void init_library();
-    void shutdown_library();
-
-    static int ms_counter;
 }; // end xslt::init class
 
 
+#ifndef XMLWRAPP_LAZY_INIT
+
 // use a "nifty counter" to ensure that any source file that uses xsltwrapp
 // will initialize the library prior to its first use
 namespace
@@ -93,6 +132,8 @@ namespace
 xslt::init g_xsltwrapp_initializer;
 }
 
+#endif // !XMLWRAPP_LAZY_INIT
+
 } // end xslt namespace
 
 #endif // _xsltwrapp_init_h_
@@ -0,0 +1,164 @@
+/*
+ * Copyright (C) 2001-2003 Peter J Jones (pjones@pmade.org)
+ * All Rights Reserved
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name of the Author nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ * USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+
+/**
+    @file
+
+    This file contains the definition of the xslt::params class.
+ */
+
+#ifndef _xsltwrapp_params_h_
+#define _xsltwrapp_params_h_
+
+// xmlwrapp includes
+#include "xsltwrapp/init.h"
+#include "xmlwrapp/export.h"
+
+// standard includes
+#include <cstddef>
+#include <map>
+#include <string>
+
+namespace xslt
+{
+
+/**
+    The xslt::params class holds a set of parameters for a transformation
+    in a form which can be passed to libxslt directly. Unlike
+    xslt::stylesheet::param_type, which has to be converted every time it
+    is used, it is prepared once and can then be reused for any number of
+    transformations, including concurrent ones.
+
+    Parameter values are either XPath expressions, evaluated by the
+    stylesheet, or plain strings, which are passed to the stylesheet as
+    they are without any XPath evaluation. XPath expressions consisting of
+    just a string literal, e.g. @c 'value', are stored as plain strings too.
+ */
+class XSLTWRAPP_API params
+{
+public:
+    struct pimpl;
+
+    /// Create an empty parameter set.
+    params();
+
+    /**
+        Create a parameter set with the XPath expressions from the given
+        map.
+
+        @param p Map of parameter names and XPath expressions.
+        @exception xml::exception if some expression is invalid.
+     */
+    explicit params(const std::map<std::string, std::string>& p);
+
+    /**
+        Create a copy of another parameter set.
+
+        @param other The parameter set to copy.
+     */
+    params(const params& other);
+
+    /**
+        Replace the contents of this parameter set with a copy of another.
+
+        @param other The parameter set to copy.
+        @return A reference to this parameter set.
+     */
+    params& operator=(const params& other);
+
+    /**
+        Swap this parameter set with another one.
+
+        @param other The parameter set to swap with.
+     */
+    void swap(params& other);
+
+    /// Clean up after an xslt::params.
+    ~params();
+
+    /**
+        Set the value of the given parameter to an XPath expression, which
+        will be evaluated by the stylesheet. Any previous value of the
+        parameter is replaced.
+
+        @param name The name of the parameter.
+        @param expr The XPath expression, e.g. @c "42" or @c "'text'".
+        @exception xml::exception if the expression is invalid.
+     */
+    void set(const char *name, const char *expr);
+
+    /**
+        Set the value of the given parameter to a string, which will be
+        passed to the stylesheet as it is. This is faster than using set()
+        and doesn't require quoting the value. Any previous value of the
+        parameter is replaced.
+
+        @param name The name of the parameter.
+        @param value The string value of the parameter.
+     */
+    void set_string(const char *name, const char *value);
+
+    /**
+        Remove the given parameter.
+
+        @param name The name of the parameter.
+     */
+    void erase(const char *name);
+
+    /// Remove all parameters.
+    void clear();
+
+    /**
+        Get the number of parameters.
+
+        @return The number of parameters in this set.
+     */
+    std::size_t size() const;
+
+    /**
+        Check if there are no parameters.
+
+        @return True if this set is empty.
+     */
+    bool empty() const;
+
+private:
+    pimpl *pimpl_;
+
+    friend class stylesheet;
+    friend class pipeline;
+}; // end xslt::params class
+
+} // end xslt namespace
+
+#endif // _xsltwrapp_params_h_
@@ -0,0 +1,150 @@
+/*
+ * Copyright (C) 2001-2003 Peter J Jones (pjones@pmade.org)
+ * All Rights Reserved
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name of the Author nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ * USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+
+/**
+    @file
+
+    This file contains the definition of the xslt::pipeline class.
+ */
+
+#ifndef _xsltwrapp_pipeline_h_
+#define _xsltwrapp_pipeline_h_
+
+// xmlwrapp includes
+#include "xsltwrapp/init.h"
+#include "xsltwrapp/params.h"
+#include "xsltwrapp/stylesheet.h"
+#include "xsltwrapp/transform_result.h"
+#include "xmlwrapp/document.h"
+#include "xmlwrapp/export.h"
+
+// standard includes
+#include <cstddef>
+#include <iosfwd>
+#include <vector>
+
+namespace xslt
+{
+
+/**
+    The xslt::pipeline class applies several stylesheets in sequence, each
+    of them to the result of the previous one.
+
+    The result tree of every stage is given to the next stage directly,
+    without being serialized and parsed again, and is freed as soon as the
+    next stage is done with it. Only the output settings (xsl:output) of
+    the last stylesheet matter for the final result.
+
+    The pipeline doesn't copy the stylesheets, they must exist for as long
+    as it is used. Like xslt::stylesheet::transform(), running the pipeline
+    doesn't modify it nor the stylesheets, so it can be used by several
+    threads at once.
+ */
+class XSLTWRAPP_API pipeline
+{
+public:
+    struct pimpl;
+
+    /// Create an empty pipeline.
+    pipeline();
+
+    /// Clean up after an xslt::pipeline.
+    ~pipeline();
+
+    /**
+        Append a stage applying the given stylesheet without parameters.
+
+        @param style The stylesheet to apply.
+     */
+    void add_stage(const stylesheet& style);
+
+    /**
+        Append a stage applying the given stylesheet with the given
+        parameters.
+
+        @param style The stylesheet to apply.
+        @param with_params Override xsl:param elements of this stylesheet
+                           using the given parameters.
+     */
+    void add_stage(const stylesheet& style, const params& with_params);
+
+    /**
+        Get the number of stages.
+
+        @return The number of stylesheets in the pipeline.
+     */
+    std::size_t size() const;
+
+    /**
+        Run the given document through all the stages of the pipeline.
+
+        If some stage fails, the remaining stages are not run and the error
+        message of the result indicates which stage failed.
+
+        @param doc The XML document to transform.
+        @param stage_times If not NULL, filled with the time, in seconds,
+                           taken by each of the stages that were run.
+        @return The result of the last stage.
+     */
+    transform_result run(const xml::document& doc,
+                         std::vector<double> *stage_times = 0) const;
+
+    /**
+        Run the given document through all the stages of the pipeline and
+        write the serialized result of the last one directly to the given
+        stream, as xslt::stylesheet::transform_to() does.
+
+        @param doc The XML document to transform.
+        @param stream The stream to write the output to.
+        @param stage_times If not NULL, filled with the time, in seconds,
+                           taken by each of the stages that were run. The
+                           time of the last stage includes writing the
+                           output.
+        @return The result of the pipeline, which never contains the result
+                document.
+     */
+    transform_result run_to(const xml::document& doc,
+                            std::ostream& stream,
+                            std::vector<double> *stage_times = 0) const;
+
+private:
+    pimpl *pimpl_;
+
+    // an xslt::pipeline cannot be copied or assigned to.
+    pipeline(const pipeline&);
+    pipeline& operator=(const pipeline&);
+}; // end xslt::pipeline class
+
+} // end xslt namespace
+
+#endif // _xsltwrapp_pipeline_h_
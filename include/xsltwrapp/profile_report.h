@@ -0,0 +1,155 @@
+/*
+ * Copyright (C) 2001-2003 Peter J Jones (pjones@pmade.org)
+ * All Rights Reserved
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name of the Author nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ * USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+
+/**
+    @file
+
+    This file contains the definition of the xslt::profile_report class.
+ */
+
+#ifndef _xsltwrapp_profile_report_h_
+#define _xsltwrapp_profile_report_h_
+
+// xmlwrapp includes
+#include "xsltwrapp/init.h"
+#include "xmlwrapp/export.h"
+
+// standard includes
+#include <string>
+#include <vector>
+
+namespace xslt
+{
+
+/**
+    The xslt::profile_report class holds the profiling information gathered
+    by libxslt during a single transformation: how many times each template
+    of the stylesheet was called and how much time was spent in it.
+
+    It is filled by the xslt::stylesheet member functions taking it as
+    argument.
+ */
+class XSLTWRAPP_API profile_report
+{
+public:
+    struct pimpl;
+
+    /// Profiling information about a single template.
+    struct template_info
+    {
+        /// The name of the template, empty if it doesn't have any.
+        std::string name;
+
+        /// The match pattern of the template, empty if it doesn't have any.
+        std::string match;
+
+        /// The mode of the template, empty if it doesn't have any.
+        std::string mode;
+
+        /// The number of times the template was instantiated.
+        unsigned long calls;
+
+        /**
+            The time, in seconds, spent in the template itself, excluding
+            the time spent in the templates it called.
+         */
+        double self_time;
+
+        /**
+            The time, in seconds, spent in the template including the
+            templates it called.
+
+            libxslt only measures the exclusive time, so this is an estimate
+            computed by attributing the time of each template to its callers
+            in proportion to the number of calls they made, as gprof does.
+            The time of recursive calls is counted only once.
+         */
+        double total_time;
+    };
+
+    /// The type of the list of templates returned by get_templates().
+    typedef std::vector<template_info> templates_type;
+
+    /// Create an empty report.
+    profile_report();
+
+    /**
+        Create a copy of another report.
+
+        @param other The report to copy.
+     */
+    profile_report(const profile_report& other);
+
+    /**
+        Replace the contents of this report with a copy of another one.
+
+        @param other The report to copy.
+        @return A reference to this report.
+     */
+    profile_report& operator=(const profile_report& other);
+
+    /**
+        Swap this report with another one.
+
+        @param other The report to swap with.
+     */
+    void swap(profile_report& other);
+
+    /// Clean up after an xslt::profile_report.
+    ~profile_report();
+
+    /**
+        Get the information about all templates that were called at least
+        once, sorted by decreasing self time.
+
+        @return The list of templates.
+     */
+    const templates_type& get_templates() const;
+
+    /**
+        Get the total duration of the transformation, including the time
+        spent outside of any template.
+
+        @return The duration in seconds.
+     */
+    double get_total_time() const;
+
+private:
+    pimpl *pimpl_;
+
+    friend class stylesheet;
+}; // end xslt::profile_report class
+
+} // end xslt namespace
+
+#endif // _xsltwrapp_profile_report_h_
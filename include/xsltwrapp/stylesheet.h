@@ -41,12 +41,20 @@
 
 // xmlwrapp includes
 #include "xsltwrapp/init.h"
+#include "xsltwrapp/document_loader.h"
+#include "xsltwrapp/extension_function.h"
+#include "xsltwrapp/params.h"
+#include "xsltwrapp/profile_report.h"
+#include "xsltwrapp/transform_limits.h"
+#include "xsltwrapp/transform_result.h"
 #include "xmlwrapp/document.h"
 #include "xmlwrapp/export.h"
 
 // standard includes
+#include <iosfwd>
 #include <map>
 #include <string>
+#include <vector>
 
 namespace xslt
 {
@@ -55,6 +63,12 @@ namespace xslt
     The xslt::stylesheet class is used to hold information about an XSLT
     stylesheet. You can use it to load in a stylesheet and then use that
     stylesheet to transform an XML document to something else.
+
+    The transform() member functions only read the stylesheet, so a single
+    stylesheet may be used by several threads at once, as long as each of
+    them transforms its own input document. The apply() member functions
+    store the last error message and result document in the stylesheet
+    object and so must not be used concurrently.
  */
 class XSLTWRAPP_API stylesheet
 {
@@ -110,6 +124,36 @@ public:
      */
     bool apply(const xml::document& doc, xml::document& result, const param_type& with_params);
 
+    /**
+        Apply this stylesheet to the given XML document. The result document
+        is placed in the second document parameter.
+
+        @param doc The XML document to transform.
+        @param result The result tree after applying this stylesheet.
+        @param with_params Override xsl:param elements using the given parameters
+        @return True if the transformation was successful and the results placed in result.
+        @return False if there was an error, result is not modified.
+     */
+    bool apply(const xml::document& doc, xml::document& result, const params& with_params);
+
+    /**
+        Apply this stylesheet to the given XML document with libxslt
+        profiling enabled. The result document is placed in the second
+        document parameter and the profiling information in the report.
+
+        Profiling slows down the transformation and only one profiled
+        transformation using the same stylesheet can run at any time, the
+        others wait until it finishes.
+
+        @param doc The XML document to transform.
+        @param result The result tree after applying this stylesheet.
+        @param report Filled with the profiling information, even if the
+                      transformation failed.
+        @return True if the transformation was successful and the results placed in result.
+        @return False if there was an error, result is not modified.
+     */
+    bool apply(const xml::document& doc, xml::document& result, profile_report& report);
+
     /**
         Apply this stylesheet to the given XML document. The results document
         is returned. If there is an error during transformation, this
@@ -139,6 +183,300 @@ public:
      */
     xml::document& apply(const xml::document& doc, const param_type& with_params);
 
+    /**
+        Apply this stylesheet to the given XML document. The results document
+        is returned. If there is an error during transformation, this
+        function will throw a xml::exception exception.
+
+        Each time you call this member function, the xml::document object
+        that was returned from the last call becomes invalid. That is, of
+        course, unless you copied it first.
+
+        @param doc The XML document to transform.
+        @param with_params Override xsl:param elements using the given parameters
+        @return A reference to the result tree.
+     */
+    xml::document& apply(const xml::document& doc, const params& with_params);
+
+    /**
+        Apply this stylesheet to the given XML document and return both the
+        result document and any errors in a new xslt::transform_result
+        object. This function doesn't modify the stylesheet and can be
+        called from several threads at once.
+
+        libxslt annotates the input document while transforming it, so
+        the same input document must not be transformed by several threads
+        at the same time.
+
+        @param doc The XML document to transform.
+        @return The result of the transformation.
+     */
+    transform_result transform(const xml::document& doc) const;
+
+    /**
+        Apply this stylesheet to the given XML document and return both the
+        result document and any errors in a new xslt::transform_result
+        object. This function doesn't modify the stylesheet and can be
+        called from several threads at once.
+
+        @param doc The XML document to transform.
+        @param with_params Override xsl:param elements using the given key/value map
+        @return The result of the transformation.
+     */
+    transform_result transform(const xml::document& doc,
+                               const param_type& with_params) const;
+
+    /**
+        Apply this stylesheet to the given XML document and return both the
+        result document and any errors in a new xslt::transform_result
+        object. This function doesn't modify the stylesheet and can be
+        called from several threads at once, even with the same parameters.
+
+        @param doc The XML document to transform.
+        @param with_params Override xsl:param elements using the given parameters
+        @return The result of the transformation.
+     */
+    transform_result transform(const xml::document& doc,
+                               const params& with_params) const;
+
+    /**
+        Apply this stylesheet to the given XML document with libxslt
+        profiling enabled and return the result of the transformation.
+
+        This function can be called from several threads at once, but the
+        profiled transformations using the same stylesheet are done one at a
+        time. Transformations without profiling are not affected.
+
+        @param doc The XML document to transform.
+        @param with_params Override xsl:param elements using the given parameters
+        @param report Filled with the profiling information, even if the
+                      transformation failed.
+        @return The result of the transformation.
+     */
+    transform_result transform(const xml::document& doc,
+                               const params& with_params,
+                               profile_report& report) const;
+
+    /**
+        Apply this stylesheet to the given XML document without letting the
+        transformation exceed the given limits and return the result of the
+        transformation. If any of the limits is exceeded, the transformation
+        is stopped and xslt::transform_result::get_error_type() indicates
+        which one it was.
+
+        @param doc The XML document to transform.
+        @param with_params Override xsl:param elements using the given parameters
+        @param limits The limits of the resources the transformation may use.
+        @return The result of the transformation.
+     */
+    transform_result transform(const xml::document& doc,
+                               const params& with_params,
+                               const transform_limits& limits) const;
+
+    /**
+        Apply this stylesheet to all the given XML documents using several
+        threads. Each document is transformed independently and a failure
+        to transform some of them doesn't prevent the others from being
+        transformed.
+
+        If the same document occurs several times in the batch, it is
+        transformed only once and all the corresponding results refer to
+        the same result document.
+
+        @param docs The XML documents to transform.
+        @param with_params Override xsl:param elements using the given parameters
+        @param thread_count The number of threads to use, 0 means to use
+                            one thread per processor.
+        @return The results of the transformations, in the same order as
+                the input documents.
+     */
+    std::vector<transform_result>
+    transform_batch(const std::vector<xml::document>& docs,
+                    const params& with_params,
+                    unsigned thread_count = 0) const;
+
+    /**
+        Parse all the given XML files and apply this stylesheet to them
+        using several threads. A failure to parse or transform some file
+        is reported in its result and doesn't prevent the other files from
+        being transformed.
+
+        Only the result documents are kept in memory, the input documents
+        are freed as soon as they are transformed.
+
+        @param filenames The names of the XML files to transform.
+        @param with_params Override xsl:param elements using the given parameters
+        @param thread_count The number of threads to use, 0 means to use
+                            one thread per processor.
+        @return The results of the transformations, in the same order as
+                the file names.
+     */
+    std::vector<transform_result>
+    transform_batch(const std::vector<std::string>& filenames,
+                    const params& with_params,
+                    unsigned thread_count = 0) const;
+
+    /**
+        Apply this stylesheet to the given XML document and write the
+        serialized result, as specified by the xsl:output element of the
+        stylesheet, directly to the given stream. This avoids building the
+        whole output in memory, as saving the result document to a string
+        would.
+
+        Like transform(), this function can be called from several threads
+        at once.
+
+        @param doc The XML document to transform.
+        @param stream The stream to write the output to.
+        @param keep_result If false, the result tree is freed as soon as
+                           it's written and the returned object contains
+                           an empty document.
+        @return The result of the transformation. It is unsuccessful if
+                either the transformation or writing the output failed.
+     */
+    transform_result transform_to(const xml::document& doc,
+                                  std::ostream& stream,
+                                  bool keep_result = false) const;
+
+    /**
+        Apply this stylesheet to the given XML document and write the
+        serialized result directly to the given stream.
+
+        @param doc The XML document to transform.
+        @param stream The stream to write the output to.
+        @param with_params Override xsl:param elements using the given key/value map
+        @param keep_result If false, the result tree is freed as soon as
+                           it's written and the returned object contains
+                           an empty document.
+        @return The result of the transformation.
+     */
+    transform_result transform_to(const xml::document& doc,
+                                  std::ostream& stream,
+                                  const param_type& with_params,
+                                  bool keep_result = false) const;
+
+    /**
+        Apply this stylesheet to the given XML document and write the
+        serialized result directly to the given stream.
+
+        @param doc The XML document to transform.
+        @param stream The stream to write the output to.
+        @param with_params Override xsl:param elements using the given parameters
+        @param keep_result If false, the result tree is freed as soon as
+                           it's written and the returned object contains
+                           an empty document.
+        @return The result of the transformation.
+     */
+    transform_result transform_to(const xml::document& doc,
+                                  std::ostream& stream,
+                                  const params& with_params,
+                                  bool keep_result = false) const;
+
+    /**
+        Apply this stylesheet to the given XML document without letting the
+        transformation exceed the given limits and write the serialized
+        result directly to the given stream. Notice that some output may
+        already have been written when a limit is exceeded.
+
+        @param doc The XML document to transform.
+        @param stream The stream to write the output to.
+        @param with_params Override xsl:param elements using the given parameters
+        @param limits The limits of the resources the transformation may use.
+        @param keep_result If false, the result tree is freed as soon as
+                           it's written and the returned object contains
+                           an empty document.
+        @return The result of the transformation.
+     */
+    transform_result transform_to(const xml::document& doc,
+                                  std::ostream& stream,
+                                  const params& with_params,
+                                  const transform_limits& limits,
+                                  bool keep_result = false) const;
+
+    /**
+        Apply this stylesheet to the given XML document and write the
+        serialized result directly to the given file descriptor, which is
+        not closed afterwards.
+
+        @param doc The XML document to transform.
+        @param fd The file descriptor to write the output to.
+        @param keep_result If false, the result tree is freed as soon as
+                           it's written and the returned object contains
+                           an empty document.
+        @return The result of the transformation.
+     */
+    transform_result transform_to(const xml::document& doc,
+                                  int fd,
+                                  bool keep_result = false) const;
+
+    /**
+        Apply this stylesheet to the given XML document and write the
+        serialized result directly to the given file descriptor, which is
+        not closed afterwards.
+
+        @param doc The XML document to transform.
+        @param fd The file descriptor to write the output to.
+        @param with_params Override xsl:param elements using the given key/value map
+        @param keep_result If false, the result tree is freed as soon as
+                           it's written and the returned object contains
+                           an empty document.
+        @return The result of the transformation.
+     */
+    transform_result transform_to(const xml::document& doc,
+                                  int fd,
+                                  const param_type& with_params,
+                                  bool keep_result = false) const;
+
+    /**
+        Apply this stylesheet to the given XML document and write the
+        serialized result directly to the given file descriptor, which is
+        not closed afterwards.
+
+        @param doc The XML document to transform.
+        @param fd The file descriptor to write the output to.
+        @param with_params Override xsl:param elements using the given parameters
+        @param keep_result If false, the result tree is freed as soon as
+                           it's written and the returned object contains
+                           an empty document.
+        @return The result of the transformation.
+     */
+    transform_result transform_to(const xml::document& doc,
+                                  int fd,
+                                  const params& with_params,
+                                  bool keep_result = false) const;
+
+    /**
+        Make the given C++ function callable from XPath expressions in this
+        stylesheet as an extension function with the given namespace URI and
+        local name. A function registered with the same name before is
+        replaced.
+
+        The function object is not copied and must exist for as long as the
+        stylesheet is used. This member function must not be called while
+        the stylesheet is being used by other threads.
+
+        @param uri The namespace URI of the function.
+        @param name The local name of the function.
+        @param func The implementation of the function.
+     */
+    void register_function(const char *uri, const char *name,
+                           extension_function& func);
+
+    /**
+        Use the given loader for the documents loaded by the XPath document()
+        function in this stylesheet. By default, every transformation loads
+        these documents again.
+
+        The loader is not copied and must exist for as long as the stylesheet
+        is used. The same loader can be used by any number of stylesheets.
+        This member function must not be called while the stylesheet is being
+        used by other threads.
+
+        @param loader The loader to use or NULL to restore the default
+                      behaviour.
+     */
+    void set_document_loader(document_loader *loader);
+
     /**
         If you used one of the xslt::stylesheet::apply member functions that
         return a bool, you can use this function to get the text message for
@@ -156,6 +494,11 @@ public:
 private:
     pimpl *pimpl_;
 
+    void* get_stylesheet_data() const;
+
+    friend class stylesheet_cache;
+    friend class pipeline;
+
     // an xslt::stylesheet cannot yet be copied or assigned to.
     stylesheet(const stylesheet&);
     stylesheet& operator=(const stylesheet&);
@@ -0,0 +1,192 @@
+/*
+ * Copyright (C) 2001-2003 Peter J Jones (pjones@pmade.org)
+ * All Rights Reserved
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name of the Author nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ * USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+
+/**
+    @file
+
+    This file contains the definition of the xslt::stylesheet_cache class.
+ */
+
+#ifndef _xsltwrapp_stylesheet_cache_h_
+#define _xsltwrapp_stylesheet_cache_h_
+
+// xmlwrapp includes
+#include "xsltwrapp/init.h"
+#include "xsltwrapp/stylesheet.h"
+#include "xmlwrapp/export.h"
+
+// standard includes
+#include <cstddef>
+
+namespace xslt
+{
+
+/**
+    The xslt::stylesheet_cache class keeps compiled stylesheets loaded from
+    files, so that they are parsed only once instead of every time they are
+    used.
+
+    Every time a stylesheet is requested, the modification times of its file
+    and of all the files it imports or includes are checked and the
+    stylesheet is compiled again if any of them changed. When the cache
+    grows bigger than its maximal size, the least recently used stylesheets
+    are removed from it.
+
+    All member functions may be called from several threads at once.
+ */
+class XSLTWRAPP_API stylesheet_cache
+{
+public:
+    /**
+        A shared reference to a stylesheet from the cache.
+
+        The stylesheet remains valid as long as any handle referring to it
+        exists, even if it is removed from the cache in the meanwhile. Only
+        the const member functions of xslt::stylesheet, such as
+        xslt::stylesheet::transform(), can be used with it, as the same
+        stylesheet may be used by other threads at the same time.
+     */
+    class XSLTWRAPP_API handle
+    {
+    public:
+        /// Create a handle not referring to any stylesheet.
+        handle();
+
+        /**
+            Create another handle to the same stylesheet.
+
+            @param other The handle to copy.
+         */
+        handle(const handle& other);
+
+        /**
+            Make this handle refer to the same stylesheet as another one.
+
+            @param other The handle to copy.
+            @return A reference to this handle.
+         */
+        handle& operator=(const handle& other);
+
+        /**
+            Swap this handle with another one.
+
+            @param other The handle to swap with.
+         */
+        void swap(handle& other);
+
+        /// Release the reference to the stylesheet.
+        ~handle();
+
+        /**
+            Get the stylesheet this handle refers to.
+
+            @return The stylesheet or NULL if the handle is empty.
+         */
+        const stylesheet* get() const;
+
+        /// Access the stylesheet, the handle must not be empty.
+        const stylesheet& operator*() const { return *get(); }
+
+        /// Access the stylesheet, the handle must not be empty.
+        const stylesheet* operator->() const { return get(); }
+
+    private:
+        struct holder;
+        holder *holder_;
+
+        explicit handle(holder *h);
+
+        friend class stylesheet_cache;
+    };
+
+    /**
+        Create a new empty cache.
+
+        @param max_size The maximal number of stylesheets kept in the cache.
+     */
+    explicit stylesheet_cache(std::size_t max_size = 100);
+
+    /**
+        Clean up after an xslt::stylesheet_cache. Stylesheets still
+        referenced by handles are freed when the last handle is destroyed.
+     */
+    ~stylesheet_cache();
+
+    /**
+        Get the stylesheet loaded from the given file, compiling it if it
+        isn't in the cache yet or if it or any of the files it imports or
+        includes were modified since it was compiled.
+
+        If the stylesheet can't be loaded, xml::exception is thrown.
+
+        @param filename The name of the file that contains the stylesheet.
+        @return A handle to the compiled stylesheet.
+     */
+    handle get(const char *filename);
+
+    /**
+        Remove the stylesheet loaded from the given file from the cache.
+
+        @param filename The name of the file that contains the stylesheet.
+     */
+    void remove(const char *filename);
+
+    /// Remove all stylesheets from the cache.
+    void clear();
+
+    /**
+        Get the number of stylesheets in the cache.
+
+        @return The number of cached stylesheets.
+     */
+    std::size_t size() const;
+
+    /**
+        Get the maximal number of stylesheets kept in the cache.
+
+        @return The maximal size given to the constructor.
+     */
+    std::size_t get_max_size() const;
+
+private:
+    struct pimpl;
+    pimpl *pimpl_;
+
+    // an xslt::stylesheet_cache cannot be copied or assigned to.
+    stylesheet_cache(const stylesheet_cache&);
+    stylesheet_cache& operator=(const stylesheet_cache&);
+}; // end xslt::stylesheet_cache class
+
+} // end xslt namespace
+
+#endif // _xsltwrapp_stylesheet_cache_h_
@@ -0,0 +1,204 @@
+/*
+ * Copyright (C) 2001-2003 Peter J Jones (pjones@pmade.org)
+ * All Rights Reserved
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name of the Author nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ * USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+
+/**
+    @file
+
+    This file contains the definition of the xslt::transform_limits and
+    xslt::cancellation_token classes.
+ */
+
+#ifndef _xsltwrapp_transform_limits_h_
+#define _xsltwrapp_transform_limits_h_
+
+// xmlwrapp includes
+#include "xsltwrapp/init.h"
+#include "xmlwrapp/export.h"
+
+namespace xslt
+{
+
+/**
+    The xslt::cancellation_token class is used to stop transformations
+    from another thread. Give it to the transformations using
+    xslt::transform_limits::set_cancellation_token() and call cancel() to
+    make all of them fail as soon as possible.
+
+    A token can't be reset, use a new one for the next transformations.
+ */
+class XSLTWRAPP_API cancellation_token
+{
+public:
+    /// Create a token which is not cancelled.
+    cancellation_token();
+
+    /// Clean up after an xslt::cancellation_token.
+    ~cancellation_token();
+
+    /**
+        Cancel the transformations using this token. This may be called from
+        any thread.
+     */
+    void cancel();
+
+    /**
+        Check if cancel() was called.
+
+        @return True if the token is cancelled.
+     */
+    bool is_cancelled() const;
+
+private:
+    mutable volatile long cancelled_;
+
+    // an xslt::cancellation_token cannot be copied or assigned to.
+    cancellation_token(const cancellation_token&);
+    cancellation_token& operator=(const cancellation_token&);
+}; // end xslt::cancellation_token class
+
+
+/**
+    The xslt::transform_limits class holds the limits of the resources a
+    single transformation may use, protecting the application from badly
+    written or malicious stylesheets. A transformation exceeding any of them
+    is stopped and fails with an error identifying the limit, see
+    xslt::transform_result::get_error_type().
+
+    By default, the recursion limits built into libxslt are used and the
+    transformations are not limited in time.
+ */
+class XSLTWRAPP_API transform_limits
+{
+public:
+    struct pimpl;
+
+    /// Create limits with the default values.
+    transform_limits();
+
+    /**
+        Create a copy of other limits.
+
+        @param other The limits to copy.
+     */
+    transform_limits(const transform_limits& other);
+
+    /**
+        Replace these limits with a copy of other ones.
+
+        @param other The limits to copy.
+        @return A reference to this object.
+     */
+    transform_limits& operator=(const transform_limits& other);
+
+    /**
+        Swap these limits with other ones.
+
+        @param other The limits to swap with.
+     */
+    void swap(transform_limits& other);
+
+    /// Clean up after an xslt::transform_limits.
+    ~transform_limits();
+
+    /**
+        Set the maximal depth of nested template calls.
+
+        @param depth The maximal depth or 0 for the libxslt default.
+     */
+    void set_max_template_depth(int depth);
+
+    /**
+        Get the maximal depth of nested template calls.
+
+        @return The maximal depth or 0 if the libxslt default is used.
+     */
+    int get_max_template_depth() const;
+
+    /**
+        Set the maximal number of variables and parameters which may exist
+        at once, over all the nested template calls.
+
+        @param depth The maximal number or 0 for the libxslt default.
+     */
+    void set_max_variable_depth(int depth);
+
+    /**
+        Get the maximal number of variables and parameters which may exist
+        at once.
+
+        @return The maximal number or 0 if the libxslt default is used.
+     */
+    int get_max_variable_depth() const;
+
+    /**
+        Set the maximal time a transformation may take.
+
+        The time is checked before executing every XSLT instruction, so a
+        single XPath expression taking a long time can't be interrupted.
+
+        @param seconds The time limit or 0 for no limit.
+     */
+    void set_time_limit(double seconds);
+
+    /**
+        Get the maximal time a transformation may take.
+
+        @return The time limit in seconds or 0 if there is no limit.
+     */
+    double get_time_limit() const;
+
+    /**
+        Set the token which may be used to stop the transformation. Like the
+        time limit, the token is checked between XSLT instructions.
+
+        @param token The token, which must exist for as long as these limits
+                     are used, or NULL.
+     */
+    void set_cancellation_token(const cancellation_token *token);
+
+    /**
+        Get the token which may be used to stop the transformation.
+
+        @return The token or NULL.
+     */
+    const cancellation_token* get_cancellation_token() const;
+
+private:
+    pimpl *pimpl_;
+
+    friend class stylesheet;
+}; // end xslt::transform_limits class
+
+} // end xslt namespace
+
+#endif // _xsltwrapp_transform_limits_h_
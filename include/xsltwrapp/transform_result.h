@@ -0,0 +1,163 @@
+/*
+ * Copyright (C) 2001-2003 Peter J Jones (pjones@pmade.org)
+ * All Rights Reserved
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name of the Author nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ * USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+
+/**
+    @file
+
+    This file contains the definition of the xslt::transform_result class.
+ */
+
+#ifndef _xsltwrapp_transform_result_h_
+#define _xsltwrapp_transform_result_h_
+
+// xmlwrapp includes
+#include "xsltwrapp/init.h"
+#include "xmlwrapp/document.h"
+#include "xmlwrapp/export.h"
+
+// standard includes
+#include <string>
+
+namespace xslt
+{
+
+class stylesheet;
+class pipeline;
+
+/**
+    The xslt::transform_result class holds the outcome of a single
+    transformation done by xslt::stylesheet::transform(): either the result
+    document or the error message explaining why there is none.
+
+    Unlike the documents returned by xslt::stylesheet::apply(), the result
+    belongs to the caller alone, so several threads can transform documents
+    using the same stylesheet at once.
+ */
+class XSLTWRAPP_API transform_result
+{
+public:
+    /// The kind of error which made the transformation fail.
+    enum error_type
+    {
+        error_none,             ///< The transformation was successful.
+        error_transform,        ///< An error in the stylesheet or the input.
+        error_template_depth,   ///< Too deeply nested template calls.
+        error_variable_depth,   ///< Too many variables or parameters.
+        error_time_limit,       ///< The time limit was exceeded.
+        error_cancelled         ///< The transformation was cancelled.
+    };
+
+    /**
+        Create another reference to the same result. The copies share the
+        result document, use the xml::document copy constructor to get an
+        independent copy of it.
+
+        @param other The result to copy.
+     */
+    transform_result(const transform_result& other);
+
+    /**
+        Make this result refer to the same result as another one.
+
+        @param other The result to copy.
+        @return A reference to this result.
+     */
+    transform_result& operator=(const transform_result& other);
+
+    /**
+        Swap this result with another one.
+
+        @param other The result to swap with.
+     */
+    void swap(transform_result& other);
+
+    /**
+        Clean up after an xslt::transform_result.
+     */
+    ~transform_result();
+
+    /**
+        Check if the transformation was successful.
+
+        @return True if the result document is available, false if the
+                transformation failed.
+     */
+    bool is_successful() const;
+
+    /**
+        Get the result document. If the transformation failed, this is an
+        empty document.
+
+        @return A reference to the result tree.
+     */
+    const xml::document& get_document() const;
+
+    /**
+        Get the result document for modification. If the transformation
+        failed, this is an empty document.
+
+        @return A reference to the result tree.
+     */
+    xml::document& get_document();
+
+    /**
+        Get the text of the errors which happened during the transformation.
+
+        @return The error message or an empty string if the transformation
+                was successful.
+     */
+    const std::string& get_error_message() const;
+
+    /**
+        Get the kind of error which made the transformation fail. This is
+        mostly useful to tell the transformations stopped because of the
+        limits given by xslt::transform_limits from the other errors.
+
+        @return The error type or error_none if the transformation was
+                successful.
+     */
+    error_type get_error_type() const;
+
+private:
+    struct pimpl;
+    pimpl *pimpl_;
+
+    transform_result();
+
+    friend class stylesheet;
+    friend class pipeline;
+}; // end xslt::transform_result class
+
+} // end xslt namespace
+
+#endif // _xsltwrapp_transform_result_h_
@@ -34,7 +34,15 @@
 #define _xsltwrapp_xsltwrapp_h_
 
 #include "xmlwrapp/xmlwrapp.h"
+#include "xsltwrapp/document_loader.h"
+#include "xsltwrapp/extension_function.h"
 #include "xsltwrapp/init.h"
+#include "xsltwrapp/params.h"
+#include "xsltwrapp/pipeline.h"
+#include "xsltwrapp/profile_report.h"
 #include "xsltwrapp/stylesheet.h"
+#include "xsltwrapp/stylesheet_cache.h"
+#include "xsltwrapp/transform_limits.h"
+#include "xsltwrapp/transform_result.h"
 
 #endif // _xsltwrapp_xsltwrapp_h_
@@ -38,120 +38,37 @@
 
 // standard includes
 #include <algorithm>
+#include <cstring>
+#include <new>
 
 // libxml2 includes
+#include <libxml/hash.h>
 #include <libxml/tree.h>
+#include <libxml/valid.h>
 
 namespace xml
 {
 
 using namespace impl;
 
-// ------------------------------------------------------------------------
-// xml::impl::ait_impl
-// ------------------------------------------------------------------------
-
-namespace impl
-{
-
-ait_impl::ait_impl(xmlNodePtr node, xmlAttrPtr prop)
-    : xmlnode_(node), xmlattr_(prop), fake_(false)
-{
-    attr_.set_data(xmlnode_, xmlattr_);
-}
-
-
-ait_impl::ait_impl(const char *name, const char *value, bool)
-    : xmlnode_(0), xmlattr_(0), fake_(true)
-{
-    // in this constructor and in the functions to follow, the last
-    // parameter, the bool, is only used to create a unique signature
-    attr_.set_data(name, value, true);
-}
-
-
-ait_impl::ait_impl(const ait_impl& other)
-    : xmlnode_(other.xmlnode_), xmlattr_(other.xmlattr_), fake_(other.fake_)
-{
-    if (fake_)
-        attr_.set_data(other.attr_.get_name(), other.attr_.get_value(), true);
-    else
-        attr_.set_data(xmlnode_, xmlattr_);
-}
-
-
-ait_impl& ait_impl::operator=(const ait_impl& other)
-{
-    ait_impl tmp(other);
-
-    std::swap(xmlnode_, tmp.xmlnode_);
-    std::swap(xmlattr_, tmp.xmlattr_);
-    std::swap(fake_, tmp.fake_);
-    attr_.swap(tmp.attr_);
-
-    return *this;
-}
-
-
-attributes::attr* ait_impl::get()
-{
-    return &attr_;
-}
-
-
-xmlAttrPtr ait_impl::get_raw_attr()
-{
-    return xmlattr_;
-}
-
-
-ait_impl& ait_impl::operator++()
-{
-    if (xmlattr_)
-        xmlattr_ = xmlattr_->next;
-    else
-        fake_ = false;
-
-    attr_.set_data(xmlnode_, xmlattr_);
-    return *this;
-}
-
-
-ait_impl ait_impl::operator++(int)
-{
-    ait_impl tmp(xmlnode_, xmlattr_);
-    ++(*this);
-    return tmp;
-}
-
-} // namespace impl
-
-
 // ------------------------------------------------------------------------
 // xml::attributes::iterator
 // ------------------------------------------------------------------------
 
 attributes::iterator::iterator()
 {
-    pimpl_ = new ait_impl(0, 0);
-}
-
-
-attributes::iterator::iterator(void *node, void *prop)
-{
-    pimpl_ = new ait_impl(static_cast<xmlNodePtr>(node), static_cast<xmlAttrPtr>(prop));
 }
 
 
-attributes::iterator::iterator(const char *name, const char *value, bool)
+attributes::iterator::iterator(void *node, void *prop, bool fake)
 {
-    pimpl_ = new ait_impl(name, value, true);
+    attr_.set_data(node, prop, fake);
 }
 
 
 attributes::iterator::iterator (const iterator &other)
+    : attr_(other.attr_)
 {
-    pimpl_ = new ait_impl(*other.pimpl_);
 }
 
 
@@ -165,37 +82,42 @@ attributes::iterator& attributes::iterator::operator=(const iterator& other)
 
 void attributes::iterator::swap(iterator& other)
 {
-    std::swap(pimpl_, other.pimpl_);
+    attr_.swap(other.attr_);
 }
 
 
 attributes::iterator::~iterator()
 {
-    delete pimpl_;
 }
 
 
 void* attributes::iterator::get_raw_attr()
 {
-    return pimpl_->get_raw_attr();
+    return attr_.fake_ ? 0 : attr_.prop_;
 }
 
 
 attributes::iterator::reference attributes::iterator::operator*() const
 {
-    return *(pimpl_->get());
+    return attr_;
 }
 
 
 attributes::iterator::pointer attributes::iterator::operator->() const
 {
-    return pimpl_->get();
+    return &attr_;
 }
 
 
 attributes::iterator& attributes::iterator::operator++()
 {
-    ++(*pimpl_);
+    // DTD default attributes are not part of the list, the only thing
+    // following them is the end
+    void *next = 0;
+    if (attr_.prop_ && !attr_.fake_)
+        next = static_cast<xmlAttrPtr>(attr_.prop_)->next;
+
+    attr_.set_data(attr_.node_, next, false);
     return *this;
 }
 
@@ -214,31 +136,24 @@ attributes::iterator attributes::iterator::operator++(int)
 
 attributes::const_iterator::const_iterator()
 {
-    pimpl_ = new ait_impl(0, 0);
 }
 
 
-attributes::const_iterator::const_iterator(void *node, void *prop)
+attributes::const_iterator::const_iterator(void *node, void *prop, bool fake)
 {
-    pimpl_ = new ait_impl(static_cast<xmlNodePtr>(node), static_cast<xmlAttrPtr>(prop));
-}
-
-
-attributes::const_iterator::const_iterator(const char *name, const char *value, bool)
-{
-    pimpl_ = new ait_impl(name, value, true);
+    attr_.set_data(node, prop, fake);
 }
 
 
 attributes::const_iterator::const_iterator(const const_iterator& other)
+    : attr_(other.attr_)
 {
-    pimpl_ = new ait_impl(*other.pimpl_);
 }
 
 
 attributes::const_iterator::const_iterator(const iterator& other)
+    : attr_(other.attr_)
 {
-    pimpl_ = new ait_impl(*other.pimpl_);
 }
 
 
@@ -252,37 +167,40 @@ attributes::const_iterator& attributes::const_iterator::operator=(const const_it
 
 void attributes::const_iterator::swap(const_iterator& other)
 {
-    std::swap(pimpl_, other.pimpl_);
+    attr_.swap(other.attr_);
 }
 
 
 attributes::const_iterator::~const_iterator()
 {
-    delete pimpl_;
 }
 
 
 void* attributes::const_iterator::get_raw_attr()
 {
-    return pimpl_->get_raw_attr();
+    return attr_.fake_ ? 0 : attr_.prop_;
 }
 
 
 attributes::const_iterator::reference attributes::const_iterator::operator*() const
 {
-    return *(pimpl_->get());
+    return attr_;
 }
 
 
 attributes::const_iterator::pointer attributes::const_iterator::operator->() const
 {
-    return pimpl_->get();
+    return &attr_;
 }
 
 
 attributes::const_iterator& attributes::const_iterator::operator++()
 {
-    ++(*pimpl_);
+    void *next = 0;
+    if (attr_.prop_ && !attr_.fake_)
+        next = static_cast<xmlAttrPtr>(attr_.prop_)->next;
+
+    attr_.set_data(attr_.node_, next, false);
     return *this;
 }
 
@@ -299,20 +217,28 @@ attributes::const_iterator attributes::const_iterator::operator++(int)
 // xml::attributes::attr
 // ------------------------------------------------------------------------
 
-attributes::attr::attr() : node_(0), prop_(0)
+attributes::attr::attr() : node_(0), prop_(0), fake_(false), value_(0)
 {
 }
 
 
+// the value_ buffer is only a cache for values that had to be assembled
+// from several nodes and is intentionally not copied
 attributes::attr::attr(const attr& other)
     : node_(other.node_),
       prop_(other.prop_),
-      name_(other.name_),
-      value_(other.value_)
+      fake_(other.fake_),
+      value_(0)
 {
 }
 
 
+attributes::attr::~attr()
+{
+    xmlFree(value_);
+}
+
+
 attributes::attr& attributes::attr::operator=(const attr& other)
 {
     attr tmp(other);
@@ -325,65 +251,78 @@ void attributes::attr::swap(attr& other)
 {
     std::swap(node_, other.node_);
     std::swap(prop_, other.prop_);
-    name_.swap(other.name_);
-    value_.swap(other.value_);
+    std::swap(fake_, other.fake_);
+    void *value = value_;
+    value_ = other.value_;
+    other.value_ = value;
 }
 
 
-void attributes::attr::set_data(void *node, void *prop)
+void attributes::attr::set_data(void *node, void *prop, bool fake)
 {
     node_ = node;
     prop_ = prop;
-    name_.erase();
-    value_.erase();
-}
-
-
-void attributes::attr::set_data(const char *name, const char *value, bool)
-{
-    node_ = 0;
-    prop_ = 0;
-    name_ = name;
-    value_ = value;
+    fake_ = fake;
 }
 
 
 const char* attributes::attr::get_name() const
 {
-    if (!name_.empty())
-        return name_.c_str(); // we were given a name not a node
-
-    if (!node_ || !prop_)
+    if (!prop_)
         throw xml::exception("access to invalid attributes::attr object!");
 
+    if (fake_)
+    {
+        xmlAttributePtr decl = static_cast<xmlAttributePtr>(prop_);
+        if (decl->prefix == 0)
+            return reinterpret_cast<const char*>(decl->name);
+
+        // the declaration stores the prefix separately, so the qualified name
+        // has to be assembled; the value of a DTD default never uses value_,
+        // so it can cache the name instead
+        xmlChar *qname = xmlStrdup(decl->prefix);
+        if (qname)
+            qname = xmlStrcat(qname, reinterpret_cast<const xmlChar*>(":"));
+        if (qname)
+            qname = xmlStrcat(qname, decl->name);
+        if (qname == 0)
+            throw std::bad_alloc();
+
+        return cache_string(value_, qname);
+    }
+
     return reinterpret_cast<const char*>(static_cast<xmlAttrPtr>(prop_)->name);
 }
 
 
 const char* attributes::attr::get_value() const
 {
-    if (!value_.empty())
-        return value_.c_str(); // we were given a value, not a node
-
-    if (!node_ || !prop_)
+    if (!prop_)
         throw xml::exception("access to invalid attributes::attr object!");
 
-    xmlChar *tmpstr = xmlNodeListGetString(reinterpret_cast<xmlNodePtr>(node_)->doc, reinterpret_cast<xmlAttrPtr>(prop_)->children, 1);
+    if (fake_)
+        return reinterpret_cast<const char*>(static_cast<xmlAttributePtr>(prop_)->defaultValue);
+
+    xmlChar *tmpstr;
+    const xmlChar *value = get_prop_value(static_cast<xmlAttrPtr>(prop_), tmpstr);
+
     if (tmpstr == 0)
-        return "";
+        return value ? reinterpret_cast<const char*>(value) : "";
 
-    xmlchar_helper helper(tmpstr);
-    value_.assign(helper.get());
-    return value_.c_str();
+    return cache_string(value_, tmpstr);
 }
 
+
 // ------------------------------------------------------------------------
 // helper friend functions and operators
 // ------------------------------------------------------------------------
 
+// iterators to DTD default attributes never compare equal to anything
 bool operator==(const attributes::iterator& lhs, const attributes::iterator& rhs)
 {
-    return *(lhs.pimpl_) == *(rhs.pimpl_);
+    if (lhs.attr_.fake_ || rhs.attr_.fake_)
+        return false;
+    return lhs.attr_.prop_ == rhs.attr_.prop_;
 }
 
 bool operator!=(const attributes::iterator& lhs, const attributes::iterator& rhs)
@@ -393,7 +332,9 @@ bool operator!=(const attributes::iterator& lhs, const attributes::iterator& rhs
 
 bool operator==(const attributes::const_iterator& lhs, const attributes::const_iterator& rhs)
 {
-    return *(lhs.pimpl_) == *(rhs.pimpl_);
+    if (lhs.attr_.fake_ || rhs.attr_.fake_)
+        return false;
+    return lhs.attr_.prop_ == rhs.attr_.prop_;
 }
 
 bool operator!=(const attributes::const_iterator& lhs, const attributes::const_iterator& rhs)
@@ -419,39 +360,95 @@ xmlAttrPtr find_prop(xmlNodePtr xmlnode, const char *name)
 }
 
 
-xmlAttributePtr find_default_prop(xmlNodePtr xmlnode, const char *name)
+const xmlChar* get_prop_value(xmlAttrPtr prop, xmlChar *&allocated)
 {
-    if (xmlnode->doc != 0)
-    {
-        xmlAttributePtr dtd_attr=0;
+    allocated = 0;
 
-        if (xmlnode->doc->intSubset != 0)
-        {
-            dtd_attr = xmlGetDtdAttrDesc(xmlnode->doc->intSubset, xmlnode->name, reinterpret_cast<const xmlChar*>(name));
-        }
+    xmlNodePtr value_node = prop->children;
 
-        if (dtd_attr == 0 && xmlnode->doc->extSubset != 0)
-        {
-            dtd_attr = xmlGetDtdAttrDesc(xmlnode->doc->extSubset, xmlnode->name, reinterpret_cast<const xmlChar*>(name));
-        }
+    if (value_node == 0)
+        return 0;
 
-        if (dtd_attr != 0 && dtd_attr->defaultValue != 0)
-            return dtd_attr;
-    }
+    // the common case of a value consisting of a single text node doesn't
+    // need to be copied anywhere
+    if (value_node->next == 0 && value_node->type == XML_TEXT_NODE)
+        return value_node->content;
 
-    return 0;
+    // otherwise the value contains entity references and must be assembled
+    allocated = xmlNodeListGetString(prop->doc, value_node, 1);
+    return allocated;
 }
 
-bool operator==(const ait_impl& lhs, const ait_impl& rhs)
+
+namespace
 {
-    if (lhs.fake_ || rhs.fake_)
-        return false;
-    return lhs.xmlattr_ == rhs.xmlattr_;
+
+// Look up the declaration of the attribute of the element in the DTD. This
+// only reads the hash table of the attribute declarations which libxml2
+// fills when the DTD is parsed and which doesn't change afterwards, so it
+// can be done by several threads at once without locking.
+xmlAttributePtr lookup_decl(xmlDtdPtr dtd,
+                            const xmlChar *element,
+                            const xmlChar *name,
+                            const xmlChar *prefix)
+{
+    if (dtd == 0 || dtd->attributes == 0)
+        return 0;
+
+    return static_cast<xmlAttributePtr>(
+        xmlHashLookup3(static_cast<xmlHashTablePtr>(dtd->attributes),
+                       name, prefix, element));
 }
 
-bool operator!=(const ait_impl& lhs, const ait_impl& rhs)
+// longest prefix looked up without allocating memory
+const std::size_t MAX_PREFIX_LEN = 64;
+
+} // anonymous namespace
+
+
+xmlAttributePtr find_default_prop(xmlNodePtr xmlnode, const char *name)
 {
-    return !(lhs == rhs);
+    xmlDocPtr doc = xmlnode->doc;
+    if (doc == 0)
+        return 0;
+
+    xmlDtdPtr int_subset = doc->intSubset;
+    xmlDtdPtr ext_subset = doc->extSubset;
+    if ((int_subset == 0 || int_subset->attributes == 0) &&
+        (ext_subset == 0 || ext_subset->attributes == 0))
+        return 0;
+
+    // split the name into prefix and local name as xmlGetDtdAttrDesc()
+    // does, but without allocating copies of them
+    const xmlChar *qname = reinterpret_cast<const xmlChar*>(name);
+    const xmlChar *local = qname;
+    const xmlChar *prefix = 0;
+    xmlChar prefix_buf[MAX_PREFIX_LEN + 1];
+
+    const char *colon = std::strchr(name, ':');
+    if (colon && colon != name && colon[1] != '\0')
+    {
+        const std::size_t len = colon - name;
+        if (len > MAX_PREFIX_LEN)
+        {
+            // not worth optimizing
+            xmlAttributePtr decl = int_subset ? xmlGetDtdAttrDesc(int_subset, xmlnode->name, qname) : 0;
+            if (decl == 0 && ext_subset)
+                decl = xmlGetDtdAttrDesc(ext_subset, xmlnode->name, qname);
+            return decl && decl->defaultValue ? decl : 0;
+        }
+
+        std::memcpy(prefix_buf, name, len);
+        prefix_buf[len] = 0;
+        prefix = prefix_buf;
+        local = reinterpret_cast<const xmlChar*>(colon + 1);
+    }
+
+    xmlAttributePtr decl = lookup_decl(int_subset, xmlnode->name, local, prefix);
+    if (decl == 0)
+        decl = lookup_decl(ext_subset, xmlnode->name, local, prefix);
+
+    return decl && decl->defaultValue ? decl : 0;
 }
 
 } // namespace impl
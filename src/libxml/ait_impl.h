@@ -33,11 +33,6 @@
 #ifndef _xmlwrapp_ait_impl_h_
 #define _xmlwrapp_ait_impl_h_
 
-// xmlwrapp includes
-#include "xmlwrapp/attributes.h"
-
-#include "pimpl_base.h"
-
 // libxml2 includes
 #include <libxml/tree.h>
 
@@ -47,36 +42,16 @@ namespace xml
 namespace impl
 {
 
-// The class that does all the work behind xml::attributes::iterator and
-// xml::attributes::const_iterator.
-class ait_impl : public pimpl_base<ait_impl>
-{
-public:
-    ait_impl(xmlNodePtr node, xmlAttrPtr prop);
-    ait_impl(const char *name, const char *value, bool);
-    ait_impl(const ait_impl& other);
-    ait_impl& operator=(const ait_impl& other);
-
-    attributes::attr* get();
-    xmlAttrPtr get_raw_attr();
-
-    ait_impl& operator++();
-    ait_impl  operator++(int);
-
-    friend bool operator==(const ait_impl& lhs, const ait_impl& rhs);
-    friend bool operator!=(const ait_impl& lhs, const ait_impl& rhs);
-
-private:
-    xmlNodePtr xmlnode_;
-    xmlAttrPtr xmlattr_;
-    attributes::attr attr_;
-    bool fake_;
-};
-
-// a couple helper functions
+// helpers used by xml::attributes and its iterators
 xmlAttrPtr find_prop(xmlNodePtr xmlnode, const char *name);
 xmlAttributePtr find_default_prop(xmlNodePtr xmlnode, const char *name);
 
+// Get the value of the attribute without copying it, if possible. When the
+// value contains entity references it has to be assembled into a new string
+// which is returned and also stored in allocated; the caller must free it
+// with xmlFree(). Otherwise allocated is set to 0.
+const xmlChar* get_prop_value(xmlAttrPtr prop, xmlChar *&allocated);
+
 } // namespace impl
 
 } // namespace xml
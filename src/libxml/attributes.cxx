@@ -33,14 +33,20 @@
 // xmlwrapp includes
 #include "xmlwrapp/attributes.h"
 #include "ait_impl.h"
+#include "parallel.h"
 #include "pimpl_base.h"
 
 // standard includes
 #include <new>
+#include <memory>
 #include <algorithm>
+#include <string>
+#include <vector>
 
 // libxml2 includes
+#include <libxml/dict.h>
 #include <libxml/tree.h>
+#include <libxml/valid.h>
 
 namespace xml
 {
@@ -102,6 +108,154 @@ struct attributes::pimpl : public pimpl_base<attributes::pimpl>
 };
 
 
+// ------------------------------------------------------------------------
+// xml::attributes::name_set::pimpl
+// ------------------------------------------------------------------------
+
+struct attributes::name_set::pimpl : public pimpl_base<attributes::name_set::pimpl>
+{
+    pimpl() : dict_(0) {}
+
+    // the interned names are specific to the dictionary and not copied
+    pimpl(const pimpl& other) : names_(other.names_), dict_(0) {}
+
+    ~pimpl()
+    {
+        if ( dict_ )
+            xmlDictFree(dict_);
+    }
+
+    size_type add(const char *name)
+    {
+        mutex_lock lock(mutex_);
+        names_.push_back(name);
+        return names_.size() - 1;
+    }
+
+    const xmlChar* get(size_type index) const
+    {
+        return reinterpret_cast<const xmlChar*>(names_[index].c_str());
+    }
+
+    // Store the names as interned in the given dictionary, or NULL for the
+    // names not in it, in the array of size() pointers. They are looked up
+    // in the dictionary only once for all the elements of a document, but
+    // the names which were not found are looked up again every time, as
+    // they may have been added to the dictionary since then.
+    void get_interned(xmlDictPtr dict, const xmlChar **interned) const
+    {
+        mutex_lock lock(mutex_);
+
+        if ( dict != dict_ )
+        {
+            // keep the dictionary alive, so that it's not replaced by another
+            // one at the same address while the interned names are cached
+            xmlDictReference(dict);
+            if ( dict_ )
+                xmlDictFree(dict_);
+            dict_ = dict;
+            interned_.clear();
+        }
+
+        const size_type count = names_.size();
+        interned_.resize(count, 0);
+        for ( size_type i = 0; i < count; ++i )
+        {
+            if ( !interned_[i] )
+                interned_[i] = xmlDictExists(dict, get(i), -1);
+            interned[i] = interned_[i];
+        }
+    }
+
+    // check if the attribute declared in DTD has the name at given index
+    bool matches(size_type index, xmlAttributePtr decl) const
+    {
+        const xmlChar *name = get(index);
+        if ( !decl->prefix )
+            return xmlStrEqual(name, decl->name) != 0;
+
+        const int prefix_len = xmlStrlen(decl->prefix);
+        return xmlStrncmp(name, decl->prefix, prefix_len) == 0 &&
+               name[prefix_len] == ':' &&
+               xmlStrEqual(name + prefix_len + 1, decl->name);
+    }
+
+    std::vector<std::string> names_;
+
+    // the names interned in dict_, which is referenced by this object, see
+    // get_interned(); the mutex protects them and names_ as const name_set
+    // objects may be used by several threads at once
+    mutable xmlDictPtr dict_;
+    mutable std::vector<const xmlChar*> interned_;
+    mutable mutex mutex_;
+};
+
+
+// ------------------------------------------------------------------------
+// xml::attributes::name_set
+// ------------------------------------------------------------------------
+
+attributes::name_set::name_set()
+{
+    pimpl_ = new pimpl;
+}
+
+
+attributes::name_set::name_set(const char * const *names, size_type count)
+{
+    std::auto_ptr<pimpl> ap(pimpl_ = new pimpl);
+
+    for ( size_type i = 0; i < count; ++i )
+        pimpl_->add(names[i]);
+
+    ap.release();
+}
+
+
+attributes::name_set::name_set(const name_set& other)
+{
+    pimpl_ = new pimpl(*other.pimpl_);
+}
+
+
+attributes::name_set& attributes::name_set::operator=(const name_set& other)
+{
+    name_set tmp(other);
+    swap(tmp);
+    return *this;
+}
+
+
+void attributes::name_set::swap(name_set& other)
+{
+    std::swap(pimpl_, other.pimpl_);
+}
+
+
+attributes::name_set::~name_set()
+{
+    delete pimpl_;
+}
+
+
+attributes::size_type attributes::name_set::add(const char *name)
+{
+    return pimpl_->add(name);
+}
+
+
+attributes::size_type attributes::name_set::size() const
+{
+    return pimpl_->names_.size();
+}
+
+
+const char* attributes::name_set::get_name(size_type index) const
+{
+    return pimpl_->names_[index].c_str();
+}
+
+
 // ------------------------------------------------------------------------
 // xml::attributes
 // ------------------------------------------------------------------------
@@ -192,34 +346,161 @@ void attributes::insert(const char *name, const char *value)
 }
 
 
-attributes::iterator attributes::find(const char *name)
+attributes::iterator attributes::find(const char *name, default_values defaults)
 {
     xmlAttrPtr prop = find_prop(pimpl_->xmlnode_, name);
     if ( prop != 0 )
         return iterator(pimpl_->xmlnode_, prop);
 
+    if ( defaults == ignore_dtd_defaults )
+        return iterator();
+
     xmlAttributePtr dtd_prop = find_default_prop(pimpl_->xmlnode_, name);
     if ( dtd_prop != 0 )
-        return iterator(name, reinterpret_cast<const char*>(dtd_prop->defaultValue), true);
+        return iterator(pimpl_->xmlnode_, dtd_prop, true);
 
     return iterator();
 }
 
 
-attributes::const_iterator attributes::find(const char *name) const
+attributes::const_iterator attributes::find(const char *name, default_values defaults) const
 {
     xmlAttrPtr prop = find_prop(pimpl_->xmlnode_, name);
     if (prop != 0)
         return const_iterator(pimpl_->xmlnode_, prop);
 
+    if (defaults == ignore_dtd_defaults)
+        return const_iterator();
+
     xmlAttributePtr dtd_prop = find_default_prop(pimpl_->xmlnode_, name);
 
     if (dtd_prop != 0)
+        return const_iterator(pimpl_->xmlnode_, dtd_prop, true);
+
+    return const_iterator();
+}
+
+
+template<typename Iterator>
+attributes::size_type attributes::find_names(const name_set& names,
+                                             Iterator *results,
+                                             default_values defaults) const
+{
+    const name_set::pimpl& table = *names.pimpl_;
+    const size_type count = table.names_.size();
+    const Iterator the_end;
+    size_type found = 0;
+
+    for ( size_type i = 0; i < count; ++i )
+        results[i] = the_end;
+
+    xmlNodePtr node = pimpl_->xmlnode_;
+    if ( !node->properties && (!node->doc || defaults == ignore_dtd_defaults) )
+        return 0;
+
+    // The names of the properties of the parsed documents are interned in
+    // the document dictionary, so they can be compared by pointer. A name
+    // which is not in the dictionary at all can't be equal to any of them.
+    // The properties created by the application may still use names not
+    // owned by the dictionary and those are compared as strings.
+    xmlDictPtr dict = node->doc ? node->doc->dict : 0;
+    const xmlChar *interned_buf[16];
+    std::vector<const xmlChar*> interned_vec;
+    const xmlChar **interned = 0;
+    if ( dict && count )
     {
-        return const_iterator(name, reinterpret_cast<const char*>(dtd_prop->defaultValue), true);
+        if ( count <= sizeof(interned_buf) / sizeof(interned_buf[0]) )
+        {
+            interned = interned_buf;
+        }
+        else
+        {
+            interned_vec.resize(count);
+            interned = &interned_vec[0];
+        }
+
+        table.get_interned(dict, interned);
     }
 
-    return const_iterator();
+    for ( xmlAttrPtr prop = node->properties; prop && found < count; prop = prop->next )
+    {
+        const bool owned = dict && xmlDictOwns(dict, prop->name) == 1;
+
+        for ( size_type i = 0; i < count; ++i )
+        {
+            if ( results[i] != the_end )
+                continue;
+
+            if ( owned ? prop->name == interned[i]
+                       : xmlStrEqual(prop->name, table.get(i)) != 0 )
+            {
+                results[i] = Iterator(node, prop);
+                ++found;
+            }
+        }
+    }
+
+    if ( found == count || !node->doc || defaults == ignore_dtd_defaults )
+        return found;
+
+    // Look at all defaults declared for this element at once instead of
+    // querying the DTD for each missing attribute separately. Like find(),
+    // stop at the first declaration of the attribute, even if it has no
+    // default value, so that the internal subset overrides the external one.
+    char declared_buf[16];
+    std::vector<char> declared_vec;
+    char *declared = declared_buf;
+    if ( count > sizeof(declared_buf) / sizeof(declared_buf[0]) )
+    {
+        declared_vec.resize(count);
+        declared = &declared_vec[0];
+    }
+
+    for ( size_type i = 0; i < count; ++i )
+        declared[i] = results[i] != the_end;
+    size_type resolved = found;
+
+    xmlDtdPtr subsets[] = { node->doc->intSubset, node->doc->extSubset };
+    for ( int s = 0; s < 2 && resolved < count; ++s )
+    {
+        xmlElementPtr decl = subsets[s] ? xmlGetDtdElementDesc(subsets[s], node->name) : 0;
+        if ( !decl )
+            continue;
+
+        for ( xmlAttributePtr a = decl->attributes; a && resolved < count; a = a->nexth )
+        {
+            for ( size_type i = 0; i < count; ++i )
+            {
+                if ( declared[i] || !table.matches(i, a) )
+                    continue;
+
+                declared[i] = true;
+                ++resolved;
+
+                if ( a->defaultValue )
+                {
+                    results[i] = Iterator(node, a, true);
+                    ++found;
+                }
+            }
+        }
+    }
+
+    return found;
+}
+
+
+attributes::size_type attributes::find(const name_set& names, iterator *results,
+                                       default_values defaults)
+{
+    return find_names(names, results, defaults);
+}
+
+
+attributes::size_type attributes::find(const name_set& names, const_iterator *results,
+                                       default_values defaults) const
+{
+    return find_names(names, results, defaults);
 }
 
 
@@ -38,6 +38,9 @@
 #include "utility.h"
 #include "dtd_impl.h"
 #include "node_manip.h"
+#include "parallel.h"
+#include "parallel_save.h"
+#include "pimpl_base.h"
 
 // standard includes
 #include <new>
@@ -46,9 +49,12 @@
 #include <iostream>
 #include <algorithm>
 #include <stdexcept>
+#include <string>
+#include <vector>
 
 // libxml includes
 #include <libxml/tree.h>
+#include <libxml/xmlIO.h>
 #include <libxml/xinclude.h>
 
 // bring in private libxslt stuff (see bug #1927398)
@@ -62,6 +68,7 @@ using namespace impl;
 namespace
 {
     const char DEFAULT_ENCODING[] = "ISO-8859-1";
+    const std::string default_encoding(DEFAULT_ENCODING);
 }
 
 // ------------------------------------------------------------------------
@@ -71,11 +78,13 @@ namespace
 namespace impl
 {
 
-struct doc_impl
+struct doc_impl : public pimpl_base<doc_impl>
 {
     doc_impl()
         : doc_(0), xslt_result_(0)
     {
+        ensure_initialized();
+
         xmlDocPtr tmpdoc;
         if ( (tmpdoc = xmlNewDoc(0)) == 0)
             throw std::bad_alloc();
@@ -86,6 +95,8 @@ struct doc_impl
     doc_impl(const char *root_name)
         : doc_(0), xslt_result_(0), root_(root_name)
     {
+        ensure_initialized();
+
         xmlDocPtr tmpdoc;
         if ( (tmpdoc = xmlNewDoc(0)) == 0)
             throw std::bad_alloc();
@@ -105,8 +116,7 @@ struct doc_impl
 
     void set_doc_data(xmlDocPtr newdoc, bool root_is_okay)
     {
-        if (doc_)
-            xmlFreeDoc(doc_);
+        free_doc();
         doc_ = newdoc;
 
         if (doc_->version)
@@ -149,14 +159,27 @@ struct doc_impl
         if (old_root_node)
             xmlFreeNode(old_root_node);
 
-        xslt_result_ = 0;
+        set_xslt_result(0);
     }
 
 
-    ~doc_impl()
+    void set_xslt_result(xslt::impl::result *xr)
+    {
+        delete xslt_result_;
+        xslt_result_ = xr;
+    }
+
+
+    void free_doc()
     {
         if (doc_)
             xmlFreeDoc(doc_);
+    }
+
+
+    ~doc_impl()
+    {
+        free_doc();
         delete xslt_result_;
     }
 
@@ -164,7 +187,7 @@ struct doc_impl
     xslt::impl::result *xslt_result_;
     node root_;
     std::string version_;
-    mutable std::string encoding_;
+    std::string encoding_;
 };
 
 } // namespace impl
@@ -259,7 +282,7 @@ void document::set_version(const char *version)
 const std::string& document::get_encoding() const
 {
     if (pimpl_->encoding_.empty())
-        pimpl_->encoding_ = DEFAULT_ENCODING;
+        return default_encoding;
     return pimpl_->encoding_;
 }
 
@@ -436,7 +459,10 @@ void document::save_to_string(std::string& s) const
         return;
     }
 
-    const char *enc = pimpl_->encoding_.empty() ? 0 : pimpl_->encoding_.c_str();
+    // libxml2 temporarily stores the encoding in the document while saving
+    // it, so pass the pointer already stored there to keep the document
+    // unchanged during concurrent saves
+    const char *enc = reinterpret_cast<const char*>(pimpl_->doc_->encoding);
     xmlDocDumpFormatMemoryEnc(pimpl_->doc_, &xml_string, &xml_string_length, enc, 1);
 
     xmlchar_helper helper(xml_string);
@@ -447,21 +473,65 @@ void document::save_to_string(std::string& s) const
 
 bool document::save_to_file(const char *filename, int compression_level) const
 {
-    std::swap(pimpl_->doc_->compression, compression_level);
+    if (pimpl_->xslt_result_ != 0)
+        return pimpl_->xslt_result_->save_to_file(filename, compression_level);
+
+    // see save_to_string() for why doc_->encoding is used
+    const char *enc = reinterpret_cast<const char*>(pimpl_->doc_->encoding);
+
+    xmlCharEncodingHandlerPtr handler = 0;
+    if (enc)
+    {
+        if ( (handler = xmlFindCharEncodingHandler(enc)) == 0)
+            return false;
+    }
+
+    // unlike xmlSaveFormatFileEnc(), this doesn't need the compression level
+    // to be set in the document
+    xmlOutputBufferPtr buffer = xmlOutputBufferCreateFilename(filename, handler, compression_level);
+    if (!buffer)
+        return false;
+
+    return xmlSaveFormatFileTo(buffer, pimpl_->doc_, enc, 1) > 0;
+}
 
+
+void document::save_to_string_parallel(std::string& s, unsigned thread_count) const
+{
     if (pimpl_->xslt_result_ != 0)
     {
-        bool rc = pimpl_->xslt_result_->save_to_file(filename, compression_level);
-        std::swap(pimpl_->doc_->compression, compression_level);
+        pimpl_->xslt_result_->save_to_string(s);
+        return;
+    }
 
-        return rc;
+    std::vector<std::string> pieces;
+    if (!save_in_parallel(pimpl_->doc_, thread_count ? thread_count : cpu_count(), pieces))
+    {
+        save_to_string(s);
+        return;
     }
 
-    const char *enc = pimpl_->encoding_.empty() ? 0 : pimpl_->encoding_.c_str();
-    bool rc = xmlSaveFormatFileEnc(filename, pimpl_->doc_, enc, 1) > 0;
-    std::swap(pimpl_->doc_->compression, compression_level);
+    std::string::size_type size = 0;
+    for (std::size_t i = 0; i < pieces.size(); ++i)
+        size += pieces[i].size();
+
+    s.clear();
+    s.reserve(size);
+    for (std::size_t i = 0; i < pieces.size(); ++i)
+        s += pieces[i];
+}
+
+
+bool document::save_to_file_parallel(const char *filename, unsigned thread_count) const
+{
+    if (pimpl_->xslt_result_ != 0)
+        return pimpl_->xslt_result_->save_to_file(filename, 0);
+
+    std::vector<std::string> pieces;
+    if (!save_in_parallel(pimpl_->doc_, thread_count ? thread_count : cpu_count(), pieces))
+        return save_to_file(filename);
 
-    return rc;
+    return write_pieces(filename, pieces);
 }
 
 
@@ -469,7 +539,7 @@ void document::set_doc_data(void *data)
 {
     // we own the doc now, don't free it!
     pimpl_->set_doc_data(static_cast<xmlDocPtr>(data), false);
-    pimpl_->xslt_result_ = 0;
+    pimpl_->set_xslt_result(0);
 }
 
 
@@ -477,7 +547,7 @@ void document::set_doc_data_from_xslt(void *data, xslt::impl::result *xr)
 {
     // this document came from a XSLT transformation
     pimpl_->set_doc_data(static_cast<xmlDocPtr>(data), false);
-    pimpl_->xslt_result_ = xr;
+    pimpl_->set_xslt_result(xr);
 }
 
 
@@ -53,6 +53,12 @@ extern "C" void dtd_error(void *ctxt, const char *message, ...)
 {
     dtd_impl *dtd = static_cast<dtd_impl*>(ctxt);
 
+    try
+    {
+        capture_error(xmlGetLastError());
+    }
+    catch (...) {}
+
     va_list ap;
     va_start(ap, message);
     printf2string(dtd->error_, message, ap);
@@ -63,6 +69,12 @@ extern "C" void dtd_warning(void *ctxt, const char*, ...)
 {
     dtd_impl *dtd = static_cast<dtd_impl*>(ctxt);
     ++dtd->warnings_;
+
+    try
+    {
+        capture_error(xmlGetLastError());
+    }
+    catch (...) {}
 }
 
 } // anonymous namespace
@@ -71,6 +83,8 @@ extern "C" void dtd_warning(void *ctxt, const char*, ...)
 dtd_impl::dtd_impl(const char *filename)
     : warnings_(0), dtd_(0)
 {
+    ensure_initialized();
+
     if ( (dtd_ = xmlParseDTD(0, reinterpret_cast<const xmlChar*>(filename))) == 0)
     {
         error_ = "unable to parse DTD ";
@@ -105,6 +119,10 @@ bool dtd_impl::validate(xmlDocPtr xmldoc)
 {
     init_ctxt();
 
+    // the validation context callbacks are not used if the errors are
+    // captured, so they capture them themselves instead
+    suspend_error_capture suspend;
+
     if (dtd_)
         return xmlValidateDtd(&vctxt_, xmldoc, dtd_) != 0;
     else
@@ -0,0 +1,331 @@
+/*
+ * Copyright (C) 2026 xmlwrapp contributors
+ * All Rights Reserved
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name of the Author nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ * USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+
+/**
+    @file
+
+    This file contains the implementation of the xml::error_capture class.
+ */
+
+// xmlwrapp includes
+#include "xmlwrapp/errors.h"
+#include "parallel.h"
+#include "utility.h"
+
+// standard includes
+#include <cstdarg>
+
+// libxml includes
+#include <libxml/globals.h>
+#include <libxml/parser.h>
+#include <libxml/xmlerror.h>
+
+namespace xml
+{
+
+using namespace impl;
+
+namespace
+{
+
+// errors kept for a single thread
+struct error_ring
+{
+    error_ring()
+        : capacity_(error_capture::default_capacity), next_(0), total_(0) {}
+
+    // return the entry to fill for a new error or NULL if the errors are not
+    // kept at all
+    error_capture::error_info* add();
+
+    // the errors from the oldest to the most recent one
+    error_capture::errors_type get() const;
+
+    // once the buffer is full, errors_[next_] is the oldest error
+    error_capture::errors_type errors_;
+    std::size_t capacity_;
+    std::size_t next_;
+    unsigned long total_;
+};
+
+
+error_capture::error_info* error_ring::add()
+{
+    ++total_;
+
+    if (capacity_ == 0)
+        return 0;
+
+    if (errors_.size() < capacity_)
+    {
+        errors_.push_back(error_capture::error_info());
+        return &errors_.back();
+    }
+
+    // reuse the oldest entry, and the memory of its strings with it
+    error_capture::error_info *info = &errors_[next_];
+    next_ = (next_ + 1) % capacity_;
+    return info;
+}
+
+
+error_capture::errors_type error_ring::get() const
+{
+    error_capture::errors_type errors;
+    errors.reserve(errors_.size());
+    errors.insert(errors.end(), errors_.begin() + next_, errors_.end());
+    errors.insert(errors.end(), errors_.begin(), errors_.begin() + next_);
+    return errors;
+}
+
+
+void destroy_ring(void *ring)
+{
+    delete static_cast<error_ring*>(ring);
+}
+
+thread_slot g_rings = { 0, 0, 0, destroy_ring };
+
+
+error_ring* get_ring(bool create)
+{
+    error_ring *ring = static_cast<error_ring*>(g_rings.get());
+    if (!ring && create)
+    {
+        ring = new error_ring;
+        try
+        {
+            g_rings.set(ring);
+        }
+        catch (...)
+        {
+            delete ring;
+            throw;
+        }
+    }
+
+    return ring;
+}
+
+
+void assign_message(std::string& s, const char *message)
+{
+    s.assign(message ? message : "");
+
+    std::string::size_type end = s.find_last_not_of("\r\n");
+    s.erase(end == std::string::npos ? 0 : end + 1);
+}
+
+
+// libxml2 doesn't call the parser error callbacks if a structured error
+// handler is installed, so call them here as libxml2 would have done
+void forward_to_parser(xmlErrorPtr error)
+{
+    switch (error->domain)
+    {
+        case XML_FROM_PARSER:
+        case XML_FROM_NAMESPACE:
+        case XML_FROM_IO:
+        case XML_FROM_HTML:
+            break;
+
+        default:
+            // the validity errors are reported to the validation context
+            // callbacks and not to those of the parser
+            return;
+    }
+
+    xmlParserCtxtPtr ctxt = static_cast<xmlParserCtxtPtr>(error->ctxt);
+    if (!ctxt || !ctxt->sax)
+        return;
+
+    xmlGenericErrorFunc channel = error->level == XML_ERR_WARNING
+                                  ? ctxt->sax->warning
+                                  : ctxt->sax->error;
+    if (!channel)
+        return;
+
+    // the default callbacks always take the parser context
+    void *data = ctxt->userData;
+    if (channel == xmlParserError || channel == xmlParserWarning)
+        data = ctxt;
+
+    channel(data, "%s", error->message ? error->message : "");
+}
+
+
+extern "C" void cb_capture_error(void *, xmlErrorPtr error)
+{
+    if (!error)
+        return;
+
+    try
+    {
+        capture_error(error);
+    }
+    catch (...) {}
+
+    forward_to_parser(error);
+}
+
+} // anonymous namespace
+
+
+namespace impl
+{
+
+void install_error_capture()
+{
+    xmlSetStructuredErrorFunc(0, cb_capture_error);
+    xmlThrDefSetStructuredErrorFunc(0, cb_capture_error);
+}
+
+
+void capture_error(xmlErrorPtr error)
+{
+    if (!error || error->code == XML_ERR_OK)
+        return;
+
+    error_capture::error_info *info = get_ring(true)->add();
+    if (!info)
+        return;
+
+    info->code = error->code;
+    info->domain = error->domain;
+    switch (error->level)
+    {
+        case XML_ERR_WARNING:
+            info->level = error_capture::level_warning;
+            break;
+        case XML_ERR_FATAL:
+            info->level = error_capture::level_fatal;
+            break;
+        default:
+            info->level = error_capture::level_error;
+            break;
+    }
+    info->file.assign(error->file ? error->file : "");
+    info->line = error->line;
+    assign_message(info->message, error->message);
+}
+
+
+void capture_message(int domain, const char *message, va_list ap)
+{
+    std::string formatted;
+    printf2string(formatted, message, ap);
+    assign_message(formatted, formatted.c_str());
+    if (formatted.empty())
+        return;
+
+    error_capture::error_info *info = get_ring(true)->add();
+    if (!info)
+        return;
+
+    info->code = 0;
+    info->domain = domain;
+    info->level = error_capture::level_error;
+    info->file.clear();
+    info->line = 0;
+    info->message.swap(formatted);
+}
+
+
+suspend_error_capture::suspend_error_capture()
+    : handler_(xmlStructuredError), context_(xmlStructuredErrorContext)
+{
+    xmlSetStructuredErrorFunc(0, 0);
+}
+
+
+suspend_error_capture::~suspend_error_capture()
+{
+    xmlSetStructuredErrorFunc(context_, handler_);
+}
+
+} // namespace impl
+
+
+// ------------------------------------------------------------------------
+// xml::error_capture
+// ------------------------------------------------------------------------
+
+const std::size_t error_capture::default_capacity;
+
+
+error_capture::errors_type error_capture::get_errors()
+{
+    error_ring *ring = get_ring(false);
+    return ring ? ring->get() : errors_type();
+}
+
+
+unsigned long error_capture::get_total()
+{
+    error_ring *ring = get_ring(false);
+    return ring ? ring->total_ : 0;
+}
+
+
+void error_capture::clear()
+{
+    error_ring *ring = get_ring(false);
+    if (ring)
+    {
+        ring->errors_.clear();
+        ring->next_ = 0;
+    }
+}
+
+
+void error_capture::set_capacity(std::size_t capacity)
+{
+    error_ring *ring = get_ring(true);
+
+    errors_type errors(ring->get());
+    if (errors.size() > capacity)
+        errors.erase(errors.begin(), errors.end() - capacity);
+
+    ring->errors_.swap(errors);
+    ring->next_ = 0;
+    ring->capacity_ = capacity;
+}
+
+
+std::size_t error_capture::get_capacity()
+{
+    error_ring *ring = get_ring(false);
+    return ring ? ring->capacity_ : default_capacity;
+}
+
+} // namespace xml
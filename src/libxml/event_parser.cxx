@@ -39,6 +39,7 @@
 #include "xmlwrapp/event_parser.h"
 #include "xmlwrapp/node.h"
 #include "utility.h"
+#include "pimpl_base.h"
 
 // libxml includes
 #include <libxml/parser.h>
@@ -66,7 +67,7 @@ using namespace xml::impl;
 // xml::impl::epimpl
 // ------------------------------------------------------------------------
 
-struct impl::epimpl
+struct impl::epimpl : public pimpl_base<impl::epimpl>
 {
 public:
     epimpl(event_parser& parent);
@@ -155,6 +156,8 @@ void cb_ignore(void*, const xmlChar*, int)
 epimpl::epimpl(event_parser& parent)
     : parser_status_(true), parent_(parent)
 {
+    ensure_initialized();
+
     std::memset(&sax_handler_, 0, sizeof(sax_handler_));
 
     sax_handler_.startElement           = cb_start_element;
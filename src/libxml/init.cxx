@@ -33,6 +33,8 @@
 
 // xmlwrapp includes
 #include "xmlwrapp/init.h"
+#include "parallel.h"
+#include "utility.h"
 
 // libxml includes
 #include <libxml/globals.h>
@@ -52,72 +54,167 @@ static void xml_error(void *, const char*, ...)
 namespace xml
 {
 
-int init::ms_counter = 0;
+using namespace impl;
 
-init::init()
+namespace
 {
-    if ( ms_counter++ == 0 )
-        init_library();
+
+// The variables below are used by the static xml::init objects, possibly
+// before any other static objects are constructed, and so must not need any
+// dynamic initialization.
+
+// protects the counter and initializing and shutting down the library
+volatile long g_lock = 0;
+
+// the number of existing xml::init objects plus one if the library was
+// initialized lazily, in which case it's never shut down
+long g_counter = 0;
+
+// nonzero while the library is initialized, can be read without the lock
+volatile long g_initialized = 0;
+
+
+// libxml2 keeps its settings per thread, so change both the value used by
+// the current thread and the default used by the threads started later
+
+void set_indent_output(bool flag)
+{
+    xmlIndentTreeOutput = flag ? 1 : 0;
+    xmlThrDefIndentTreeOutput(flag ? 1 : 0);
 }
 
+void set_remove_whitespace(bool flag)
+{
+    xmlKeepBlanksDefaultValue = flag ? 0 : 1;
+    xmlThrDefKeepBlanksDefaultValue(flag ? 0 : 1);
+}
 
-init::~init()
+void set_substitute_entities(bool flag)
 {
-    if ( --ms_counter == 0 )
-        shutdown_library();
+    xmlSubstituteEntitiesDefaultValue = flag ? 1 : 0;
+    xmlThrDefSubstituteEntitiesDefaultValue(flag ? 1 : 0);
 }
 
+void set_load_external_subsets(bool flag)
+{
+    xmlLoadExtDtdDefaultValue = flag ? 1 : 0;
+    xmlThrDefLoadExtDtdDefaultValue(flag ? 1 : 0);
+}
 
-void init::init_library()
+void set_validate_xml(bool flag)
 {
+    xmlDoValidityCheckingDefaultValue = flag ? 1 : 0;
+    xmlThrDefDoValidityCheckingDefaultValue(flag ? 1 : 0);
+}
+
+
+// must be called with the lock held
+void init_library()
+{
+    // libxml2 must use the same allocator for all its memory
+    use_allocator();
+
+    // init the parser (keeps libxml2 thread safe)
+    xmlInitParser();
+
     // set some libxml global variables
-    indent_output(true);
-    remove_whitespace(false);
-    substitute_entities(true);
-    load_external_subsets(true);
-    validate_xml(false);
+    set_indent_output(true);
+    set_remove_whitespace(false);
+    set_substitute_entities(true);
+    set_load_external_subsets(true);
+    set_validate_xml(false);
 
     // keep libxml2 from using stderr
     xmlSetGenericErrorFunc(0, xml_error);
+    xmlThrDefSetGenericErrorFunc(0, xml_error);
 
-    // init the parser (keeps libxml2 thread safe)
-    xmlInitParser();
+    // but keep the errors for xml::error_capture
+    install_error_capture();
+
+    atomic_add(g_initialized, 1);
 }
 
 
-void init::shutdown_library()
+// must be called with the lock held
+void shutdown_library()
 {
+    atomic_add(g_initialized, -1);
+
     xmlCleanupParser();
 }
 
+} // anonymous namespace
+
+
+namespace impl
+{
+
+void ensure_initialized()
+{
+    if (atomic_add(g_initialized, 0))
+        return;
+
+    // the library is initialized on first use and this reference to it is
+    // never released
+    static_lock lock(g_lock);
+    if (g_counter == 0)
+    {
+        g_counter = 1;
+        init_library();
+    }
+}
+
+} // namespace impl
+
+
+init::init()
+{
+    static_lock lock(g_lock);
+    if (g_counter++ == 0)
+        init_library();
+}
+
+
+init::~init()
+{
+    static_lock lock(g_lock);
+    if (--g_counter == 0)
+        shutdown_library();
+}
+
 
 void init::indent_output(bool flag)
 {
-    xmlIndentTreeOutput = flag ? 1 : 0;
+    ensure_initialized();
+    set_indent_output(flag);
 }
 
 
 void init::remove_whitespace(bool flag)
 {
-    xmlKeepBlanksDefaultValue = flag ? 0 : 1;
+    ensure_initialized();
+    set_remove_whitespace(flag);
 }
 
 
 void init::substitute_entities(bool flag)
 {
-    xmlSubstituteEntitiesDefaultValue = flag ? 1 : 0;
+    ensure_initialized();
+    set_substitute_entities(flag);
 }
 
 
 void init::load_external_subsets(bool flag)
 {
-    xmlLoadExtDtdDefaultValue = flag ? 1 : 0;
+    ensure_initialized();
+    set_load_external_subsets(flag);
 }
 
 
 void init::validate_xml(bool flag)
 {
-    xmlDoValidityCheckingDefaultValue = flag ? 1 : 0;
+    ensure_initialized();
+    set_validate_xml(flag);
 }
 
 } // namespace xml
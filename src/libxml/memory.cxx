@@ -0,0 +1,355 @@
+/*
+ * Copyright (C) 2026 xmlwrapp contributors
+ * All Rights Reserved
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name of the Author nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ * USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+
+/**
+    @file
+
+    This file contains the implementation of the xml::memory class.
+ */
+
+// xmlwrapp includes
+#include "xmlwrapp/memory.h"
+#include "xmlwrapp/exception.h"
+#include "parallel.h"
+#include "pimpl_base.h"
+#include "utility.h"
+
+// standard includes
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+// libxml includes
+#include <libxml/xmlmemory.h>
+
+namespace xml
+{
+
+using namespace impl;
+
+namespace
+{
+
+// prefix of the blocks allocated by libxml2 when the statistics are
+// collected, the other members keep the blocks after it suitably aligned
+union block_header
+{
+    std::size_t size;
+    long double align_ld_;
+    double align_d_;
+    void *align_p_;
+    long align_l_;
+};
+
+void* default_allocate(std::size_t size)
+{
+    return std::malloc(size);
+}
+
+void* default_reallocate(void *ptr, std::size_t size)
+{
+    return std::realloc(ptr, size);
+}
+
+void default_deallocate(void *ptr)
+{
+    std::free(ptr);
+}
+
+// protects the variables below, which can't change once g_in_use is set
+volatile long g_lock = 0;
+volatile long g_in_use = 0;
+memory::allocator g_allocator =
+    { default_allocate, default_reallocate, default_deallocate };
+bool g_custom = false;
+bool g_statistics = false;
+
+
+void destroy_statistics(void *stats)
+{
+    delete static_cast<memory::statistics*>(stats);
+}
+
+thread_slot g_thread_statistics = { 0, 0, 0, destroy_statistics };
+
+
+// return the statistics of the current thread, NULL if they couldn't be
+// allocated: this is called from the allocation functions which must not
+// throw
+memory::statistics* thread_statistics()
+{
+    memory::statistics *stats =
+        static_cast<memory::statistics*>(g_thread_statistics.get());
+    if (!stats)
+    {
+        stats = new (std::nothrow) memory::statistics();
+        if (!stats)
+            return 0;
+
+        try
+        {
+            g_thread_statistics.set(stats);
+        }
+        catch (...)
+        {
+            delete stats;
+            return 0;
+        }
+    }
+
+    return stats;
+}
+
+
+void record_allocation(std::size_t size)
+{
+    memory::statistics *stats = thread_statistics();
+    if (!stats)
+        return;
+
+    ++stats->allocations;
+    stats->allocated_bytes += size;
+    stats->current_bytes += static_cast<long>(size);
+    if (stats->current_bytes > stats->peak_bytes)
+        stats->peak_bytes = stats->current_bytes;
+}
+
+
+void record_deallocation(std::size_t size)
+{
+    memory::statistics *stats = thread_statistics();
+    if (!stats)
+        return;
+
+    ++stats->deallocations;
+    stats->current_bytes -= static_cast<long>(size);
+}
+
+
+// the functions given to libxml2, they are only used if a custom allocator
+// was set or the statistics are enabled
+
+extern "C" void* cb_malloc(size_t size)
+{
+    if (!g_statistics)
+        return g_allocator.allocate(size);
+
+    if (size > static_cast<size_t>(-1) - sizeof(block_header))
+        return 0;
+
+    block_header *block = static_cast<block_header*>
+        (g_allocator.allocate(sizeof(block_header) + size));
+    if (!block)
+        return 0;
+
+    block->size = size;
+    record_allocation(size);
+
+    return block + 1;
+}
+
+
+extern "C" void* cb_realloc(void *ptr, size_t size)
+{
+    if (!g_statistics)
+        return g_allocator.reallocate(ptr, size);
+
+    if (!ptr)
+        return cb_malloc(size);
+
+    if (size > static_cast<size_t>(-1) - sizeof(block_header))
+        return 0;
+
+    block_header *block = static_cast<block_header*>(ptr) - 1;
+    const std::size_t old_size = block->size;
+
+    block = static_cast<block_header*>
+        (g_allocator.reallocate(block, sizeof(block_header) + size));
+    if (!block)
+        return 0;
+
+    block->size = size;
+    record_deallocation(old_size);
+    record_allocation(size);
+
+    return block + 1;
+}
+
+
+extern "C" void cb_free(void *ptr)
+{
+    if (!ptr)
+        return;
+
+    if (!g_statistics)
+    {
+        g_allocator.deallocate(ptr);
+        return;
+    }
+
+    block_header *block = static_cast<block_header*>(ptr) - 1;
+    record_deallocation(block->size);
+    g_allocator.deallocate(block);
+}
+
+
+extern "C" char* cb_strdup(const char *str)
+{
+    if (!str)
+        return 0;
+
+    const std::size_t size = std::strlen(str) + 1;
+
+    char *copy = static_cast<char*>(cb_malloc(size));
+    if (copy)
+        std::memcpy(copy, str, size);
+
+    return copy;
+}
+
+
+// must be called with the lock held
+void check_not_in_use()
+{
+    if (g_in_use)
+        throw xml::exception("the memory allocator can't be changed after "
+                             "the library was initialized");
+}
+
+} // anonymous namespace
+
+
+namespace impl
+{
+
+void use_allocator()
+{
+    if (atomic_add(g_in_use, 0))
+        return;
+
+    static_lock lock(g_lock);
+    if (g_in_use)
+        return;
+
+    if (g_custom || g_statistics)
+        xmlGcMemSetup(cb_free, cb_malloc, cb_malloc, cb_realloc, cb_strdup);
+
+    atomic_add(g_in_use, 1);
+}
+
+
+void* allocate_pimpl(std::size_t size, void* (*default_alloc)(std::size_t))
+{
+    use_allocator();
+
+    void *ptr = g_custom ? g_allocator.allocate(size) : default_alloc(size);
+    if (!ptr)
+        throw std::bad_alloc();
+
+    if (g_statistics)
+        record_allocation(size);
+
+    return ptr;
+}
+
+
+void deallocate_pimpl(void *ptr, std::size_t size, void (*default_dealloc)(void*))
+{
+    if (g_statistics)
+        record_deallocation(size);
+
+    if (g_custom)
+        g_allocator.deallocate(ptr);
+    else
+        default_dealloc(ptr);
+}
+
+} // namespace impl
+
+
+// ------------------------------------------------------------------------
+// xml::memory
+// ------------------------------------------------------------------------
+
+void memory::set_allocator(const allocator& alloc)
+{
+    if (!alloc.allocate || !alloc.reallocate || !alloc.deallocate)
+        throw xml::exception("all the memory allocation functions must be set");
+
+    static_lock lock(g_lock);
+    check_not_in_use();
+
+    g_allocator = alloc;
+    g_custom = true;
+}
+
+
+void memory::enable_statistics()
+{
+    static_lock lock(g_lock);
+    check_not_in_use();
+
+    g_statistics = true;
+}
+
+
+bool memory::statistics_enabled()
+{
+    static_lock lock(g_lock);
+    return g_statistics;
+}
+
+
+memory::statistics memory::get_statistics()
+{
+    memory::statistics *stats =
+        static_cast<memory::statistics*>(g_thread_statistics.get());
+
+    return stats ? *stats : statistics();
+}
+
+
+void memory::reset_statistics()
+{
+    memory::statistics *stats =
+        static_cast<memory::statistics*>(g_thread_statistics.get());
+    if (!stats)
+        return;
+
+    stats->allocations = 0;
+    stats->deallocations = 0;
+    stats->allocated_bytes = 0;
+    stats->peak_bytes = stats->current_bytes;
+}
+
+} // namespace xml
@@ -35,12 +35,14 @@
 #include "xmlwrapp/node.h"
 #include "xmlwrapp/nodes_view.h"
 #include "xmlwrapp/attributes.h"
+#include "xmlwrapp/document.h"
 #include "xmlwrapp/exception.h"
 #include "utility.h"
 #include "ait_impl.h"
 #include "node_manip.h"
 #include "pimpl_base.h"
 #include "node_iterator.h"
+#include "parallel.h"
 
 // standard includes
 #include <cstring>
@@ -57,6 +59,8 @@
 // libxml includes
 #include <libxml/tree.h>
 #include <libxml/parser.h>
+#include <libxml/xpath.h>
+#include <libxml/xmlsave.h>
 
 namespace xml
 {
@@ -72,8 +76,8 @@ namespace impl
 
 struct node_impl : public pimpl_base<xml::impl::node_impl>
 {
-    node_impl() : xmlnode_(0), owner_(true), attrs_(0) {}
-    ~node_impl() { release(); }
+    node_impl() : xmlnode_(0), owner_(true), attrs_(0), tmp_string(0) {}
+    ~node_impl() { release(); xmlFree(tmp_string); }
 
     void release()
     {
@@ -81,27 +85,39 @@ struct node_impl : public pimpl_base<xml::impl::node_impl>
             xmlFreeNode(xmlnode_);
     }
 
+    // attrs_ is always kept in sync with the wrapped node, so that const
+    // methods don't need to modify it
+    void set_xmlnode(xmlNodePtr xmlnode)
+    {
+        xmlnode_ = xmlnode;
+        attrs_.set_data(xmlnode);
+    }
+
     xmlNodePtr xmlnode_;
     bool owner_;
     attributes attrs_;
-    std::string tmp_string;
+    void *tmp_string;   // see cache_string()
 };
 
 
+// sort compare function passing the nodes being sorted to the user-provided
+// function object, using the same two non-owning xml::node objects for all
+// comparisons
 struct node_cmp : public std::binary_function<xmlNodePtr, xmlNodePtr, bool>
 {
-    node_cmp (cbfo_node_compare &cb) : cb_(cb) {}
+    node_cmp (cbfo_node_compare &cb, xml::node &lhs, xml::node &rhs)
+        : cb_(cb), lhs_(lhs), rhs_(rhs) {}
 
     bool operator()(xmlNodePtr lhs, xmlNodePtr rhs)
     {
-        xml::node l_node, r_node;
-        l_node.set_node_data(lhs);
-        r_node.set_node_data(rhs);
-
-        return cb_(l_node, r_node);
+        lhs_.set_node_data(lhs);
+        rhs_.set_node_data(rhs);
+        return cb_(lhs_, rhs_);
     }
 
     cbfo_node_compare &cb_;
+    xml::node &lhs_;
+    xml::node &rhs_;
 };
 
 } // namespace impl
@@ -114,97 +130,237 @@ struct node_cmp : public std::binary_function<xmlNodePtr, xmlNodePtr, bool>
 namespace
 {
 
-// help turn a node into a document
-class node2doc
+// a single attribute value used as a sort key
+struct sort_key_value
+{
+    const xmlChar *str;     // 0 if the node doesn't have this attribute
+    double num;
+};
+
+
+// a node being sorted together with its precomputed keys
+struct sort_item
+{
+    xmlNodePtr node;
+    const sort_key_value *keys;
+};
+
+
+struct sort_key_spec
+{
+    std::string name;
+    node::sort_keys::key_type type;
+    node::sort_keys::key_order order;
+};
+
+typedef std::vector<sort_key_spec> sort_key_specs;
+
+
+// sort compare function comparing precomputed keys, missing values are
+// smaller than all others and equal to each other
+class compare_keys : public std::binary_function<sort_item, sort_item, bool>
 {
 public:
-    node2doc(xmlNodePtr xmlnode_)
-        : xmlnode__(xmlnode_), prev_(0), next_(0)
-    {
-        xmldoc_ = xmlNewDoc(0);
-        if (!xmldoc_)
-            throw std::bad_alloc();
+    compare_keys(const sort_key_specs& specs) : specs_(specs) {}
 
-        xmldoc_->children   = xmlnode__;
-        xmldoc_->last   = xmlnode__;
+    bool operator()(const sort_item& lhs, const sort_item& rhs) const
+    {
+        for (std::size_t k = 0; k < specs_.size(); ++k)
+        {
+            int rc = compare(lhs.keys[k], rhs.keys[k], specs_[k].type);
+            if (rc != 0)
+                return specs_[k].order == node::sort_keys::descending ? rc > 0 : rc < 0;
+        }
 
-        std::swap(prev_, xmlnode__->prev);
-        std::swap(next_, xmlnode__->next);
+        return false;
     }
 
-    ~node2doc()
+private:
+    static int compare(const sort_key_value& lhs,
+                       const sort_key_value& rhs,
+                       node::sort_keys::key_type type)
     {
-        xmldoc_->children   = 0;
-        xmldoc_->last   = 0;
+        if (lhs.str == 0 || rhs.str == 0)
+            return (lhs.str != 0) - (rhs.str != 0);
+
+        if (type == node::sort_keys::number)
+            return (lhs.num > rhs.num) - (lhs.num < rhs.num);
+
+        return xmlStrcmp(lhs.str, rhs.str);
+    }
+
+    const sort_key_specs& specs_;
+};
+
 
-        xmlFreeDoc(xmldoc_);
+// owns the attribute values that had to be assembled during key extraction
+class assembled_values
+{
+public:
+    assembled_values() {}
 
-        std::swap(prev_, xmlnode__->prev);
-        std::swap(next_, xmlnode__->next);
+    ~assembled_values()
+    {
+        std::for_each(values_.begin(), values_.end(), xmlFree);
     }
 
-    xmlDocPtr get_doc()  { return xmldoc_; }
+    void push_back(xmlChar *value)
+    {
+        try
+        {
+            values_.push_back(value);
+        }
+        catch (...)
+        {
+            xmlFree(value);
+            throw;
+        }
+    }
 
 private:
-    xmlDocPtr xmldoc_;
-    xmlNodePtr xmlnode__;
-    xmlNodePtr prev_;
-    xmlNodePtr next_;
+    std::vector<xmlChar*> values_;
+
+    assembled_values(const assembled_values&);
+    assembled_values& operator=(const assembled_values&);
 };
 
 
-// sort compare function to sort based on attribute
-struct compare_attr : public std::binary_function<xmlNodePtr, xmlNodePtr, bool>
+void extract_sort_key(xmlNodePtr xmlnode,
+                      const sort_key_spec& spec,
+                      sort_key_value& key,
+                      assembled_values& values)
 {
-    compare_attr(const char *attr_name) : name_(attr_name) {}
+    key.str = 0;
+    key.num = 0;
 
-    bool operator()(xmlNodePtr lhs, xmlNodePtr rhs)
+    if (xmlAttrPtr prop = find_prop(xmlnode, spec.name.c_str()))
     {
-        xmlAttrPtr attr_l, attr_r;
-        xmlAttributePtr dtd_l(0), dtd_r(0);
+        xmlChar *allocated;
+        key.str = get_prop_value(prop, allocated);
+        if (allocated)
+            values.push_back(allocated);
 
-        attr_l = find_prop(lhs, name_);
-        if (attr_l == 0 && (dtd_l = find_default_prop(lhs, name_)) == 0)
-            return true;
+        if (key.str == 0)
+            key.str = reinterpret_cast<const xmlChar*>("");
+    }
+    else if (xmlAttributePtr dtd_prop = find_default_prop(xmlnode, spec.name.c_str()))
+    {
+        key.str = dtd_prop->defaultValue;
+    }
 
-        attr_r = find_prop(rhs, name_);
-        if (attr_r == 0 && (dtd_r = find_default_prop(rhs, name_)) == 0)
-            return false;
+    if (key.str && spec.type == node::sort_keys::number)
+    {
+        // use the same syntax as XPath number() and xsl:sort do
+        key.num = xmlXPathCastStringToNumber(key.str);
+        if (xmlXPathIsNaN(key.num))
+            key.str = 0;
+    }
+}
 
-        xmlChar *value_l, *value_r;
 
-        if (dtd_l)
-            value_l = const_cast<xmlChar*>(dtd_l->defaultValue);
-        else
-            value_l = xmlNodeListGetString(lhs->doc, attr_l->children, 1);
+// sorts one part of the items
+class sort_range_task : public parallel_task
+{
+public:
+    sort_range_task(sort_item *first, sort_item *last,
+                    const compare_keys& cmp, bool stable)
+        : first_(first), last_(last), cmp_(&cmp), stable_(stable) {}
 
-        if (dtd_r)
-            value_r = const_cast<xmlChar*>(dtd_r->defaultValue);
+    virtual void run()
+    {
+        if (stable_)
+            std::stable_sort(first_, last_, *cmp_);
         else
-            value_r = xmlNodeListGetString(rhs->doc, attr_r->children, 1);
+            std::sort(first_, last_, *cmp_);
+    }
 
-        int rc = xmlStrcmp(value_l, value_r);
+private:
+    sort_item *first_, *last_;
+    const compare_keys *cmp_;
+    bool stable_;
+};
 
-        if (!dtd_l)
-            xmlFree(value_l);
-        if (!dtd_r)
-            xmlFree(value_r);
 
-        return rc < 0;
+// merges two adjacent sorted parts of the items
+class merge_ranges_task : public parallel_task
+{
+public:
+    merge_ranges_task(sort_item *first, sort_item *middle, sort_item *last,
+                      const compare_keys& cmp)
+        : first_(first), middle_(middle), last_(last), cmp_(&cmp) {}
+
+    virtual void run()
+    {
+        std::inplace_merge(first_, middle_, last_, *cmp_);
     }
 
-    const char *name_;
+private:
+    sort_item *first_, *middle_, *last_;
+    const compare_keys *cmp_;
 };
 
 
-// add a node as a child
-struct insert_node : public std::unary_function<xmlNodePtr, void>
+// sort the items by splitting them into chunks sorted in parallel and then
+// merging the neighbouring chunks pairwise, also in parallel
+void parallel_sort(sort_item *items, std::size_t count,
+                   const compare_keys& cmp, bool stable)
 {
-    insert_node(xmlNodePtr parent) : parent_(parent) {}
-    void operator()(xmlNodePtr child) { xmlAddChild(parent_, child); }
+    std::size_t chunks = std::min<std::size_t>(cpu_count(), count);
 
-    xmlNodePtr parent_;
-};
+    std::vector<sort_item*> bounds;
+    for (std::size_t i = 0; i < chunks; ++i)
+        bounds.push_back(items + count * i / chunks);
+    bounds.push_back(items + count);
+
+    std::vector<sort_range_task> sorters;
+    sorters.reserve(chunks);
+    std::vector<parallel_task*> tasks;
+    for (std::size_t i = 0; i < chunks; ++i)
+    {
+        sorters.push_back(sort_range_task(bounds[i], bounds[i + 1], cmp, stable));
+        tasks.push_back(&sorters.back());
+    }
+    run_in_parallel(&tasks[0], tasks.size());
+
+    while (bounds.size() > 2)
+    {
+        std::vector<merge_ranges_task> mergers;
+        mergers.reserve(bounds.size() / 2);
+        std::vector<sort_item*> merged;
+        tasks.clear();
+
+        std::size_t i = 0;
+        for (; i + 2 < bounds.size(); i += 2)
+        {
+            mergers.push_back(merge_ranges_task(bounds[i], bounds[i + 1], bounds[i + 2], cmp));
+            tasks.push_back(&mergers.back());
+            merged.push_back(bounds[i]);
+        }
+        // an odd chunk at the end is merged in the next round
+        for (; i < bounds.size(); ++i)
+            merged.push_back(bounds[i]);
+
+        run_in_parallel(&tasks[0], tasks.size());
+        bounds.swap(merged);
+    }
+}
+
+
+// append a node, which must not be linked anywhere, as the last child of
+// the parent, without merging text nodes as xmlAddChild() does
+void link_last_child(xmlNodePtr parent, xmlNodePtr child)
+{
+    child->parent = parent;
+    child->next = 0;
+    child->prev = parent->last;
+
+    if (parent->last)
+        parent->last->next = child;
+    else
+        parent->children = child;
+
+    parent->last = child;
+}
 
 
 // an element node finder
@@ -257,6 +413,88 @@ private:
 } // anonymous namespace
 
 
+// ------------------------------------------------------------------------
+// xml::node::sort_keys
+// ------------------------------------------------------------------------
+
+struct node::sort_keys::pimpl : public pimpl_base<node::sort_keys::pimpl>
+{
+    pimpl() : stable_(false), parallel_threshold_(0) {}
+
+    sort_key_specs specs_;
+    bool stable_;
+    size_type parallel_threshold_;
+};
+
+
+node::sort_keys::sort_keys()
+{
+    pimpl_ = new pimpl;
+}
+
+
+node::sort_keys::sort_keys(const char *attr_name, key_type type, key_order order)
+{
+    std::auto_ptr<pimpl> ap(pimpl_ = new pimpl);
+    add(attr_name, type, order);
+    ap.release();
+}
+
+
+node::sort_keys::sort_keys(const sort_keys& other)
+{
+    pimpl_ = new pimpl(*other.pimpl_);
+}
+
+
+node::sort_keys& node::sort_keys::operator=(const sort_keys& other)
+{
+    sort_keys tmp(other);
+    swap(tmp);
+    return *this;
+}
+
+
+void node::sort_keys::swap(sort_keys& other)
+{
+    std::swap(pimpl_, other.pimpl_);
+}
+
+
+node::sort_keys::~sort_keys()
+{
+    delete pimpl_;
+}
+
+
+void node::sort_keys::add(const char *attr_name, key_type type, key_order order)
+{
+    sort_key_spec spec;
+    spec.name = attr_name;
+    spec.type = type;
+    spec.order = order;
+    pimpl_->specs_.push_back(spec);
+}
+
+
+node::size_type node::sort_keys::size() const
+{
+    return pimpl_->specs_.size();
+}
+
+
+void node::sort_keys::set_stable(bool flag)
+{
+    pimpl_->stable_ = flag;
+}
+
+
+void node::sort_keys::set_parallel_threshold(size_type min_nodes)
+{
+    pimpl_->parallel_threshold_ = min_nodes;
+}
+
+
 // ------------------------------------------------------------------------
 // xml::node
 // ------------------------------------------------------------------------
@@ -271,7 +509,7 @@ node::node()
 {
     std::auto_ptr<node_impl> ap(pimpl_ = new node_impl);
 
-    pimpl_->xmlnode_ = xmlNewNode(0, reinterpret_cast<const xmlChar*>("blank"));
+    pimpl_->set_xmlnode(xmlNewNode(0, reinterpret_cast<const xmlChar*>("blank")));
     if (!pimpl_->xmlnode_)
         throw std::bad_alloc();
 
@@ -283,7 +521,7 @@ node::node (const char *name)
 {
     std::auto_ptr<node_impl> ap(pimpl_ = new node_impl);
 
-    pimpl_->xmlnode_ = xmlNewNode(0, reinterpret_cast<const xmlChar*>(name));
+    pimpl_->set_xmlnode(xmlNewNode(0, reinterpret_cast<const xmlChar*>(name)));
     if (!pimpl_->xmlnode_)
         throw std::bad_alloc();
 
@@ -295,7 +533,7 @@ node::node (const char *name, const char *content)
 {
     std::auto_ptr<node_impl> ap(pimpl_ = new node_impl);
 
-    pimpl_->xmlnode_ = xmlNewNode(0, reinterpret_cast<const xmlChar*>(name));
+    pimpl_->set_xmlnode(xmlNewNode(0, reinterpret_cast<const xmlChar*>(name)));
     if (!pimpl_->xmlnode_)
         throw std::bad_alloc();
 
@@ -320,10 +558,9 @@ node::node(cdata cdata_info)
 {
     std::auto_ptr<node_impl> ap(pimpl_ = new node_impl);
 
-    if ( (pimpl_->xmlnode_ = xmlNewCDataBlock(0, reinterpret_cast<const xmlChar*>(cdata_info.t), std::strlen(cdata_info.t))) == 0)
-    {
+    pimpl_->set_xmlnode(xmlNewCDataBlock(0, reinterpret_cast<const xmlChar*>(cdata_info.t), std::strlen(cdata_info.t)));
+    if (!pimpl_->xmlnode_)
         throw std::bad_alloc();
-    }
 
     ap.release();
 }
@@ -333,10 +570,9 @@ node::node(comment comment_info)
 {
     std::auto_ptr<node_impl> ap(pimpl_ = new node_impl);
 
-    if ( (pimpl_->xmlnode_ =  xmlNewComment(reinterpret_cast<const xmlChar*>(comment_info.t))) == 0)
-    {
+    pimpl_->set_xmlnode(xmlNewComment(reinterpret_cast<const xmlChar*>(comment_info.t)));
+    if (!pimpl_->xmlnode_)
         throw std::bad_alloc();
-    }
 
     ap.release();
 }
@@ -346,10 +582,9 @@ node::node(pi pi_info)
 {
     std::auto_ptr<node_impl> ap(pimpl_ = new node_impl);
 
-    if ( (pimpl_->xmlnode_ = xmlNewPI(reinterpret_cast<const xmlChar*>(pi_info.n), reinterpret_cast<const xmlChar*>(pi_info.c))) == 0)
-    {
+    pimpl_->set_xmlnode(xmlNewPI(reinterpret_cast<const xmlChar*>(pi_info.n), reinterpret_cast<const xmlChar*>(pi_info.c)));
+    if (!pimpl_->xmlnode_)
         throw std::bad_alloc();
-    }
 
     ap.release();
 }
@@ -359,10 +594,9 @@ node::node(text text_info)
 {
     std::auto_ptr<node_impl> ap(pimpl_ = new node_impl);
 
-    if ( (pimpl_->xmlnode_ =  xmlNewText(reinterpret_cast<const xmlChar*>(text_info.t))) == 0)
-    {
+    pimpl_->set_xmlnode(xmlNewText(reinterpret_cast<const xmlChar*>(text_info.t)));
+    if (!pimpl_->xmlnode_)
         throw std::bad_alloc();
-    }
 
     ap.release();
 }
@@ -372,7 +606,7 @@ node::node(const node& other)
 {
     std::auto_ptr<node_impl> ap(pimpl_ = new node_impl);
 
-    pimpl_->xmlnode_ = xmlCopyNode(other.pimpl_->xmlnode_, 1);
+    pimpl_->set_xmlnode(xmlCopyNode(other.pimpl_->xmlnode_, 1));
     if (!pimpl_->xmlnode_)
         throw std::bad_alloc();
 
@@ -403,7 +637,7 @@ node::~node()
 void node::set_node_data(void *data)
 {
     pimpl_->release();
-    pimpl_->xmlnode_ = static_cast<xmlNodePtr>(data);
+    pimpl_->set_xmlnode(static_cast<xmlNodePtr>(data));
     pimpl_->owner_ = false;
 }
 
@@ -451,12 +685,38 @@ void node::set_text_content(const char *content)
 
 const char* node::get_content() const
 {
-    xmlchar_helper content(xmlNodeGetContent(pimpl_->xmlnode_));
-    if (!content.get())
+    xmlNodePtr n = pimpl_->xmlnode_;
+
+    // the common cases of text-like nodes and of elements containing a
+    // single text node can return the content stored in the tree directly
+    switch (n->type)
+    {
+        case XML_TEXT_NODE:
+        case XML_CDATA_SECTION_NODE:
+        case XML_COMMENT_NODE:
+        case XML_PI_NODE:
+            return reinterpret_cast<const char*>(n->content);
+
+        case XML_ELEMENT_NODE:
+            if (n->children == 0)
+                return "";
+            if (n->children->next == 0 &&
+                (n->children->type == XML_TEXT_NODE || n->children->type == XML_CDATA_SECTION_NODE) &&
+                n->children->content != 0)
+            {
+                return reinterpret_cast<const char*>(n->children->content);
+            }
+            break;
+
+        default:
+            break;
+    }
+
+    xmlChar *content = xmlNodeGetContent(n);
+    if (!content)
         return NULL;
 
-    pimpl_->tmp_string = content.get();
-    return pimpl_->tmp_string.c_str();
+    return cache_string(pimpl_->tmp_string, content);
 }
 
 
@@ -494,7 +754,6 @@ xml::attributes& node::get_attributes()
         throw xml::exception("get_attributes called on non-element node");
     }
 
-    pimpl_->attrs_.set_data(pimpl_->xmlnode_);
     return pimpl_->attrs_;
 }
 
@@ -506,7 +765,6 @@ const xml::attributes& node::get_attributes() const
         throw xml::exception("get_attributes called on non-element node");
     }
 
-    pimpl_->attrs_.set_data(pimpl_->xmlnode_);
     return pimpl_->attrs_;
 }
 
@@ -668,6 +926,48 @@ node::iterator node::insert(const iterator& position, const node &n)
 }
 
 
+node::iterator node::insert_range(const iterator& position, const std::vector<void*>& nodes)
+{
+    if (nodes.empty())
+        return position;
+
+    return iterator(xml::impl::node_insert_range(pimpl_->xmlnode_, static_cast<xmlNodePtr>(position.get_raw_node()), &nodes[0], nodes.size()));
+}
+
+
+node::iterator node::adopt_from(document& source, const iterator& child)
+{
+    return adopt_from(end(), source, child);
+}
+
+
+node::iterator node::adopt_from(const iterator& position, document& source, const iterator& child)
+{
+    xmlDocPtr source_doc = static_cast<xmlDocPtr>(source.get_doc_data());
+    xmlNodePtr to_adopt = static_cast<xmlNodePtr>(child.get_raw_node());
+
+    if (to_adopt == 0 || to_adopt->doc != source_doc)
+        throw xml::exception("node to adopt doesn't belong to the source document");
+
+    if (to_adopt == xmlDocGetRootElement(source_doc))
+        throw xml::exception("root node of a document can't be adopted");
+
+    for (xmlNodePtr i = pimpl_->xmlnode_; i != 0; i = i->parent)
+    {
+        if (i == to_adopt)
+            throw xml::exception("node can't adopt its ancestor");
+    }
+
+    return iterator(xml::impl::node_adopt(pimpl_->xmlnode_, static_cast<xmlNodePtr>(position.get_raw_node()), to_adopt));
+}
+
+
+void* node::raw_node(const node& n)
+{
+    return n.pimpl_->xmlnode_;
+}
+
+
 node::iterator node::replace(const iterator& old_node, const node &new_node)
 {
     return iterator(xml::impl::node_replace(static_cast<xmlNodePtr>(old_node.get_raw_node()), new_node.pimpl_->xmlnode_));
@@ -691,12 +991,39 @@ node::iterator node::erase(iterator first, const iterator& last)
 node::size_type node::erase(const char *name)
 {
     size_type removed_count(0);
-    iterator to_remove(begin()), the_end(end());
+    xmlNodePtr i(pimpl_->xmlnode_->children);
 
-    while ( (to_remove = find(name, to_remove)) != the_end)
+    while ( (i = find_element(name, i)) != 0)
     {
         ++removed_count;
-        to_remove = erase(to_remove);
+        i = xml::impl::node_erase(i);
+    }
+
+    return removed_count;
+}
+
+
+node::size_type node::remove_if_fo(cbfo_node_predicate& pred)
+{
+    size_type removed_count(0);
+    xmlNodePtr i(pimpl_->xmlnode_->children);
+
+    // the same non-owning wrapper is used for all the children
+    node current(0);
+
+    while (i != 0)
+    {
+        current.set_node_data(i);
+
+        if (pred(current))
+        {
+            ++removed_count;
+            i = xml::impl::node_erase(i);
+        }
+        else
+        {
+            i = i->next;
+        }
     }
 
     return removed_count;
@@ -718,68 +1045,116 @@ void node::clear()
 
 void node::sort(const char *node_name, const char *attr_name)
 {
-    xmlNodePtr i(pimpl_->xmlnode_->children), next(0);
-    std::vector<xmlNodePtr> node_list;
+    sort(node_name, sort_keys(attr_name));
+}
 
-    while (i!=0)
-    {
-        next = i->next;
 
-        if (i->type == XML_ELEMENT_NODE && xmlStrcmp(i->name, reinterpret_cast<const xmlChar*>(node_name)) == 0)
-        {
-            xmlUnlinkNode(i);
-            node_list.push_back(i);
-        }
+void node::sort(const char *node_name, const sort_keys& keys)
+{
+    const sort_key_specs& specs = keys.pimpl_->specs_;
+    const std::size_t key_count = specs.size();
+
+    xmlNodePtr parent = pimpl_->xmlnode_;
 
-        i = next;
+    std::size_t count = 0;
+    for (xmlNodePtr i = parent->children; i != 0; i = i->next)
+    {
+        if (i->type == XML_ELEMENT_NODE && xmlStrcmp(i->name, reinterpret_cast<const xmlChar*>(node_name)) == 0)
+            ++count;
     }
 
-    if (node_list.empty())
+    if (count == 0)
         return;
 
-    std::sort(node_list.begin(), node_list.end(), compare_attr(attr_name));
-    std::for_each(node_list.begin(), node_list.end(), insert_node(pimpl_->xmlnode_));
+    // read all the keys up front, before changing anything, so that
+    // comparisons don't need to look up and copy the attribute values
+    std::vector<sort_item> items(count);
+    std::vector<sort_key_value> values(count * key_count);
+    assembled_values assembled;
+
+    std::size_t n = 0;
+    for (xmlNodePtr i = parent->children; i != 0; i = i->next)
+    {
+        if (i->type != XML_ELEMENT_NODE || xmlStrcmp(i->name, reinterpret_cast<const xmlChar*>(node_name)) != 0)
+            continue;
+
+        sort_key_value *node_values = key_count ? &values[n * key_count] : 0;
+        for (std::size_t k = 0; k < key_count; ++k)
+            extract_sort_key(i, specs[k], node_values[k], assembled);
+
+        items[n].node = i;
+        items[n].keys = node_values;
+        ++n;
+    }
+
+    compare_keys cmp(specs);
+
+    if (keys.pimpl_->parallel_threshold_ && count >= keys.pimpl_->parallel_threshold_)
+        parallel_sort(&items[0], count, cmp, keys.pimpl_->stable_);
+    else if (keys.pimpl_->stable_)
+        std::stable_sort(items.begin(), items.end(), cmp);
+    else
+        std::sort(items.begin(), items.end(), cmp);
+
+    for (std::size_t i = 0; i < count; ++i)
+        xmlUnlinkNode(items[i].node);
+
+    for (std::size_t i = 0; i < count; ++i)
+        link_last_child(parent, items[i].node);
 }
 
 
 void node::sort_fo(cbfo_node_compare& cb)
 {
-    xmlNodePtr i(pimpl_->xmlnode_->children), next(0);
-    std::vector<xmlNodePtr> node_list;
+    xmlNodePtr parent = pimpl_->xmlnode_;
 
-    while (i!=0)
+    std::vector<xmlNodePtr> children;
+    for (xmlNodePtr i = parent->children; i != 0; i = i->next)
     {
-        next = i->next;
-
-        if (i->type == XML_ELEMENT_NODE) {
-            xmlUnlinkNode(i);
-            node_list.push_back(i);
-        }
-
-        i = next;
+        if (i->type == XML_ELEMENT_NODE)
+            children.push_back(i);
     }
 
-    if (node_list.empty())
+    if (children.empty())
         return;
 
-    std::sort(node_list.begin(), node_list.end(), node_cmp(cb));
-    std::for_each(node_list.begin(), node_list.end(), insert_node(pimpl_->xmlnode_));
+    // the tree is left untouched if the function object throws
+    node lhs(0), rhs(0);
+    std::sort(children.begin(), children.end(), node_cmp(cb, lhs, rhs));
+
+    for (std::vector<xmlNodePtr>::iterator i = children.begin(); i != children.end(); ++i)
+        xmlUnlinkNode(*i);
+
+    for (std::vector<xmlNodePtr>::iterator i = children.begin(); i != children.end(); ++i)
+        link_last_child(parent, *i);
 }
 
 
 void node::node_to_string(std::string& xml) const
 {
-    node2doc n2d(pimpl_->xmlnode_);
-    xmlDocPtr doc = n2d.get_doc();
+    xmlBufferPtr buffer = xmlBufferCreate();
+    if (!buffer)
+        throw std::bad_alloc();
+
+    // produce the same output as when saving a document containing just
+    // this node, but without modifying the tree to create such document
+    static const char xml_decl[] = "<?xml version=\"1.0\"?>\n";
+    xmlBufferCCat(buffer, xml_decl);
+
+    xmlSaveCtxtPtr ctxt = xmlSaveToBuffer(buffer, 0, XML_SAVE_FORMAT | XML_SAVE_AS_XML);
+    if (!ctxt)
+    {
+        xmlBufferFree(buffer);
+        throw std::bad_alloc();
+    }
 
-    xmlChar *xml_string;
-    int xml_string_length;
+    xmlSaveTree(ctxt, pimpl_->xmlnode_);
+    xmlSaveClose(ctxt);
 
-    xmlDocDumpFormatMemory(doc, &xml_string, &xml_string_length, 1);
+    xmlBufferCCat(buffer, "\n");
 
-    xmlchar_helper helper(xml_string);
-    if (xml_string_length)
-        xml.assign(helper.get(), xml_string_length);
+    xml.assign(reinterpret_cast<const char*>(xmlBufferContent(buffer)), xmlBufferLength(buffer));
+    xmlBufferFree(buffer);
 }
 
 
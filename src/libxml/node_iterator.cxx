@@ -65,17 +65,6 @@ struct impl::nipimpl : public pimpl_base<impl::nipimpl>
     nipimpl(const nipimpl& other) : it(other.it) {}
 };
 
-// ------------------------------------------------------------------------
-// xml::impl::node_iterator - real iterator class
-// ------------------------------------------------------------------------
-
-node* impl::node_iterator::get() const
-{
-    fake_node_.set_node_data(node_);
-    return& fake_node_;
-}
-
-
 // ------------------------------------------------------------------------
 // xml::node::iterator wrapper iterator class
 // ------------------------------------------------------------------------
@@ -36,6 +36,7 @@
 
 // xmlwrapp includes
 #include "xmlwrapp/node.h"
+#include "parallel.h"
 
 // libxml includes
 #include <libxml/tree.h>
@@ -57,14 +58,16 @@ class iter_advance_functor
 public:
     iter_advance_functor() : refcnt_(1) {}
 
+    // the functor is shared by copies of the same view, which may be used
+    // from several threads, so the reference count must be atomic
     void inc_ref()
     {
-        refcnt_++;
+        atomic_add(refcnt_, 1);
     }
 
     void dec_ref()
     {
-        if ( --refcnt_ == 0 )
+        if ( atomic_add(refcnt_, -1) == 0 )
             delete this;
     }
 
@@ -75,7 +78,7 @@ protected:
     virtual ~iter_advance_functor() {}
 
 private:
-    int refcnt_;
+    volatile long refcnt_;
 };
 
 // base iterator class
@@ -88,20 +91,25 @@ public:
         : fake_node_(0),
           node_(reinterpret_cast<xmlNodePtr>(parent.get_node_data()))
     {
+        sync();
     }
 
-    node_iterator(xmlNodePtr xmlnode) : fake_node_(0), node_(xmlnode) {}
-    node_iterator(const node_iterator& other) : fake_node_(0), node_(other.node_) {}
+    node_iterator(xmlNodePtr xmlnode) : fake_node_(0), node_(xmlnode) { sync(); }
+    node_iterator(const node_iterator& other) : fake_node_(0), node_(other.node_) { sync(); }
     node_iterator& operator=(const node_iterator& other)
-        { node_ = other.node_; return *this;}
+        { node_ = other.node_; sync(); return *this;}
 
-    node *get() const;
+    node *get() const { return &fake_node_; }
     xmlNodePtr get_raw_node() { return node_; }
 
-    void advance() { node_ = node_->next; }
-    void advance(iter_advance_functor& next) { node_ = next(node_); }
+    void advance() { node_ = node_->next; sync(); }
+    void advance(iter_advance_functor& next) { node_ = next(node_); sync(); }
 
 private:
+    // fake_node_ always wraps node_ so that get() doesn't need to modify it
+    // and may be called from several threads at once
+    void sync() { fake_node_.set_node_data(node_); }
+
     mutable node fake_node_;
     xmlNodePtr node_;
 };
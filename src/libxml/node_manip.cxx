@@ -36,6 +36,7 @@
 #include "node_manip.h"
 
 // standard includes
+#include <new>
 #include <stdexcept>
 #include <string>
 
@@ -49,10 +50,14 @@ xml::impl::node_insert(xmlNodePtr parent, xmlNodePtr before, xmlNodePtr to_add)
     if ( !new_xml_node )
         throw std::bad_alloc();
 
+    // a text node may be merged with an adjacent one and freed, so return
+    // the node that libxml2 returns and not the one passed to it
+    xmlNodePtr inserted;
+
     if ( before == 0 )
     {
         // insert at the end of the child list
-        if ( xmlAddChild(parent, new_xml_node) == 0 )
+        if ( (inserted = xmlAddChild(parent, new_xml_node)) == 0 )
         {
             xmlFreeNode(new_xml_node);
             throw xml::exception("failed to insert xml::node; xmlAddChild failed");
@@ -60,14 +65,209 @@ xml::impl::node_insert(xmlNodePtr parent, xmlNodePtr before, xmlNodePtr to_add)
     }
     else
     {
-        if ( xmlAddPrevSibling(before, new_xml_node) == 0 )
+        if ( (inserted = xmlAddPrevSibling(before, new_xml_node)) == 0 )
         {
             xmlFreeNode(new_xml_node);
             throw xml::exception("failed to insert xml::node; xmlAddPrevSibling failed");
         }
     }
 
-    return new_xml_node;
+    return inserted;
+}
+
+
+namespace
+{
+
+// true if libxml2 would merge the second text node into the first one when
+// linking them next to each other
+bool text_mergeable(xmlNodePtr first, xmlNodePtr second)
+{
+    return first->type == XML_TEXT_NODE &&
+           second->type == XML_TEXT_NODE &&
+           first->name == second->name;
+}
+
+
+// a chain of unlinked sibling nodes built by node_insert_range(), freed
+// unless it was spliced into the tree
+class node_chain
+{
+public:
+    node_chain() : first_(0), last_(0) {}
+
+    ~node_chain()
+    {
+        if (first_)
+            xmlFreeNodeList(first_);
+    }
+
+    // append the node at the end of the chain, merging adjacent text nodes
+    // as xmlAddChild() does
+    void append(xmlNodePtr n)
+    {
+        if (last_ && text_mergeable(last_, n))
+        {
+            xmlNodeAddContent(last_, n->content);
+            xmlFreeNode(n);
+            return;
+        }
+
+        n->prev = last_;
+        if (last_)
+            last_->next = n;
+        else
+            first_ = n;
+        last_ = n;
+    }
+
+    // remove the first or last node of the chain and free it
+    void drop_first()
+    {
+        xmlNodePtr n = first_;
+        first_ = n->next;
+        if (first_)
+            first_->prev = 0;
+        else
+            last_ = 0;
+        n->next = 0;
+        xmlFreeNode(n);
+    }
+
+    void drop_last()
+    {
+        xmlNodePtr n = last_;
+        last_ = n->prev;
+        if (last_)
+            last_->next = 0;
+        else
+            first_ = 0;
+        n->prev = 0;
+        xmlFreeNode(n);
+    }
+
+    xmlNodePtr first() const { return first_; }
+    xmlNodePtr last() const { return last_; }
+
+    void release() { first_ = last_ = 0; }
+
+private:
+    xmlNodePtr first_, last_;
+
+    node_chain(const node_chain&);
+    node_chain& operator=(const node_chain&);
+};
+
+} // anonymous namespace
+
+
+xmlNodePtr
+xml::impl::node_insert_range(xmlNodePtr parent, xmlNodePtr before,
+                             void * const *to_add, std::size_t count)
+{
+    if ( count == 0 )
+        return 0;
+
+    // copy the nodes directly into the destination document, so that they
+    // don't need to be moved there again when linked, and chain the copies
+    // together; nothing is changed in the tree if this fails
+    node_chain chain;
+
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        xmlNodePtr copy = xmlDocCopyNode(static_cast<xmlNodePtr>(to_add[i]), parent->doc, 1);
+        if ( !copy )
+            throw std::bad_alloc();
+
+        chain.append(copy);
+    }
+
+    xmlNodePtr prev = before ? before->prev : parent->last;
+
+    // merge text nodes at the ends of the chain with their new neighbours,
+    // the same way as xmlAddPrevSibling() and xmlAddChild() do
+    if ( before && chain.last() && text_mergeable(chain.last(), before) )
+    {
+        xmlChar *content = xmlStrncatNew(chain.last()->content, before->content, -1);
+        if ( !content && (chain.last()->content || before->content) )
+            throw std::bad_alloc();
+        xmlNodeSetContent(before, content);
+        xmlFree(content);
+        chain.drop_last();
+    }
+
+    xmlNodePtr first_added = chain.first();
+
+    if ( prev && first_added && text_mergeable(prev, first_added) )
+    {
+        xmlNodeAddContent(prev, first_added->content);
+        chain.drop_first();
+        first_added = prev;
+    }
+
+    if ( !chain.first() )
+        return first_added ? first_added : before;
+
+    // splice the whole chain in at once
+    for (xmlNodePtr i = chain.first(); i != 0; i = i->next)
+        i->parent = parent;
+
+    chain.first()->prev = prev;
+    if ( prev )
+        prev->next = chain.first();
+    else
+        parent->children = chain.first();
+
+    chain.last()->next = before;
+    if ( before )
+        before->prev = chain.last();
+    else
+        parent->last = chain.last();
+
+    chain.release();
+
+    return first_added;
+}
+
+
+xmlNodePtr
+xml::impl::node_adopt(xmlNodePtr parent, xmlNodePtr before, xmlNodePtr to_adopt)
+{
+    if ( parent->doc == 0 )
+    {
+        // libxml2 can only move nodes into a document
+        xmlNodePtr new_xml_node = node_insert(parent, before, to_adopt);
+        node_erase(to_adopt);
+        return new_xml_node;
+    }
+
+    // this unlinks the node and makes it use the namespaces and dictionary
+    // of the destination document; it can only fail when out of memory and
+    // the node can't be safely freed then, as it's only partially converted
+    if ( xmlDOMWrapAdoptNode(0, to_adopt->doc, to_adopt, parent->doc, parent, 0) != 0 )
+        throw xml::exception("failed to adopt xml::node; xmlDOMWrapAdoptNode failed");
+
+    // as in node_insert(), the node may have been merged and freed
+    xmlNodePtr adopted;
+
+    if ( before == 0 )
+    {
+        if ( (adopted = xmlAddChild(parent, to_adopt)) == 0 )
+        {
+            xmlFreeNode(to_adopt);
+            throw xml::exception("failed to adopt xml::node; xmlAddChild failed");
+        }
+    }
+    else
+    {
+        if ( (adopted = xmlAddPrevSibling(before, to_adopt)) == 0 )
+        {
+            xmlFreeNode(to_adopt);
+            throw xml::exception("failed to adopt xml::node; xmlAddPrevSibling failed");
+        }
+    }
+
+    return adopted;
 }
 
 
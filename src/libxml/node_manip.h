@@ -39,6 +39,9 @@
 #ifndef _xmlwrapp_node_manip_h_
 #define _xmlwrapp_node_manip_h_
 
+// standard includes
+#include <cstddef>
+
 // libxml includes
 #include <libxml/tree.h>
 
@@ -58,10 +61,48 @@ namespace impl
                   0 (null), insert at the end of the child list.
     @param to_add The node to be copied and then inserted into the child list.
 
-    @return The new node that was inserted into the child list.
+    @return The new node that was inserted into the child list, or the node
+            it was merged into if it is a text node inserted next to another
+            text node.
  */
 xmlNodePtr node_insert(xmlNodePtr parent, xmlNodePtr before, xmlNodePtr to_add);
 
+/**
+    @internal
+
+    Insert several nodes somewhere in the child list of a parent node. All
+    the nodes are copied into the document of the parent and then linked in
+    at once. Text nodes are merged as node_insert() does it.
+
+    @param parent The parent who's child list will be inserted into.
+    @param before Insert the nodes before this node, or, if this node is
+                  0 (null), insert at the end of the child list.
+    @param to_add The nodes to be copied and then inserted into the child list.
+    @param count The number of nodes in @a to_add.
+
+    @return The first new node that was inserted into the child list or 0
+            if @a count is 0.
+ */
+xmlNodePtr node_insert_range(xmlNodePtr parent, xmlNodePtr before,
+                             void * const *to_add, std::size_t count);
+
+/**
+    @internal
+
+    Move a node from its current place, possibly in another document, into
+    the child list of a parent node without copying it. If the parent
+    doesn't belong to any document, the node is copied and then erased.
+
+    @param parent The parent who's child list will be inserted into.
+    @param before Insert @a to_adopt before this node, or, if this node is
+                  0 (null), insert at the end of the child list.
+    @param to_adopt The node to be moved into the child list.
+
+    @return The moved node, or the node it was merged into if it is a text
+            node inserted next to another text node.
+ */
+xmlNodePtr node_adopt(xmlNodePtr parent, xmlNodePtr before, xmlNodePtr to_adopt);
+
 /**
     @internal
 
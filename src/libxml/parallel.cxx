@@ -0,0 +1,306 @@
+/*
+ * Copyright (C) 2026 xmlwrapp contributors
+ * All Rights Reserved
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name of the Author nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ * USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+// xmlwrapp includes
+#include "parallel.h"
+
+// standard includes
+#include <new>
+#include <vector>
+
+#ifdef _WIN32
+    #include <windows.h>
+    #include <process.h>
+#else
+    #include <pthread.h>
+    #include <sched.h>
+    #include <unistd.h>
+#endif
+
+namespace xml
+{
+
+namespace impl
+{
+
+namespace
+{
+
+#ifdef _WIN32
+
+typedef HANDLE thread_handle;
+
+unsigned __stdcall thread_entry(void *arg)
+{
+    static_cast<parallel_task*>(arg)->run();
+    return 0;
+}
+
+bool start_thread(thread_handle& handle, parallel_task *task)
+{
+    handle = reinterpret_cast<HANDLE>(_beginthreadex(0, 0, thread_entry, task, 0, 0));
+    return handle != 0;
+}
+
+void join_thread(thread_handle handle)
+{
+    WaitForSingleObject(handle, INFINITE);
+    CloseHandle(handle);
+}
+
+void yield_thread()
+{
+    SwitchToThread();
+}
+
+#else // !_WIN32
+
+typedef pthread_t thread_handle;
+
+extern "C" void* thread_entry(void *arg)
+{
+    static_cast<parallel_task*>(arg)->run();
+    return 0;
+}
+
+bool start_thread(thread_handle& handle, parallel_task *task)
+{
+    return pthread_create(&handle, 0, thread_entry, task) == 0;
+}
+
+void join_thread(thread_handle handle)
+{
+    pthread_join(handle, 0);
+}
+
+void yield_thread()
+{
+    sched_yield();
+}
+
+#endif // _WIN32/!_WIN32
+
+} // anonymous namespace
+
+
+void run_in_parallel(parallel_task **tasks, std::size_t count)
+{
+    if (count == 0)
+        return;
+
+    std::vector<thread_handle> threads;
+    threads.reserve(count - 1);
+
+    for (std::size_t i = 1; i < count; ++i)
+    {
+        thread_handle handle;
+        if (start_thread(handle, tasks[i]))
+            threads.push_back(handle);
+        else
+            tasks[i]->run();
+    }
+
+    tasks[0]->run();
+
+    for (std::size_t i = 0; i < threads.size(); ++i)
+        join_thread(threads[i]);
+}
+
+
+unsigned cpu_count()
+{
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwNumberOfProcessors > 0 ? info.dwNumberOfProcessors : 1;
+#else
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? static_cast<unsigned>(n) : 1;
+#endif
+}
+
+
+unsigned long current_thread_id()
+{
+#ifdef _WIN32
+    return GetCurrentThreadId();
+#else
+    // pthread_t is an integer or a pointer on all the supported platforms,
+    // the id is only compared for equality so its exact value doesn't matter
+    return (unsigned long)pthread_self();
+#endif
+}
+
+
+#if !defined(_WIN32) && !defined(__GNUC__)
+namespace { mutex atomic_guard; }
+#endif
+
+long atomic_add(volatile long& value, long delta)
+{
+#if defined(_WIN32)
+    return InterlockedExchangeAdd(&value, delta) + delta;
+#elif defined(__GNUC__)
+    return __sync_add_and_fetch(&value, delta);
+#else
+    mutex_lock lock(atomic_guard);
+    return value += delta;
+#endif
+}
+
+
+bool atomic_compare_exchange(volatile long& value, long expected, long desired)
+{
+#if defined(_WIN32)
+    return InterlockedCompareExchange(&value, desired, expected) == expected;
+#elif defined(__GNUC__)
+    return __sync_bool_compare_and_swap(&value, expected, desired);
+#else
+    mutex_lock lock(atomic_guard);
+    if (value != expected)
+        return false;
+    value = desired;
+    return true;
+#endif
+}
+
+
+void* atomic_compare_exchange(void * volatile& value, void *expected, void *desired)
+{
+#if defined(_WIN32)
+    return InterlockedCompareExchangePointer(&value, desired, expected);
+#elif defined(__GNUC__)
+    return __sync_val_compare_and_swap(&value, expected, desired);
+#else
+    mutex_lock lock(atomic_guard);
+    void *previous = value;
+    if (previous == expected)
+        value = desired;
+    return previous;
+#endif
+}
+
+
+// ------------------------------------------------------------------------
+// xml::impl::static_lock
+// ------------------------------------------------------------------------
+
+static_lock::static_lock(volatile long& state) : state_(state)
+{
+    while (!atomic_compare_exchange(state_, 0, 1))
+        yield_thread();
+}
+
+
+static_lock::~static_lock()
+{
+    atomic_compare_exchange(state_, 1, 0);
+}
+
+
+// ------------------------------------------------------------------------
+// xml::impl::thread_slot
+// ------------------------------------------------------------------------
+
+void* thread_slot::get()
+{
+    if (!atomic_add(created_, 0))
+        return 0;
+
+#ifdef _WIN32
+    return TlsGetValue(static_cast<DWORD>(key_));
+#else
+    return pthread_getspecific(static_cast<pthread_key_t>(key_));
+#endif
+}
+
+
+void thread_slot::set(void *value)
+{
+    if (!atomic_add(created_, 0))
+    {
+        static_lock lock(lock_);
+        if (!created_)
+        {
+#ifdef _WIN32
+            DWORD key = TlsAlloc();
+            if (key == TLS_OUT_OF_INDEXES)
+                throw std::bad_alloc();
+#else
+            pthread_key_t key;
+            if (pthread_key_create(&key, destroy_) != 0)
+                throw std::bad_alloc();
+#endif
+            key_ = static_cast<unsigned long>(key);
+            atomic_add(created_, 1);
+        }
+    }
+
+#ifdef _WIN32
+    TlsSetValue(static_cast<DWORD>(key_), value);
+#else
+    pthread_setspecific(static_cast<pthread_key_t>(key_), value);
+#endif
+}
+
+
+// ------------------------------------------------------------------------
+// xml::impl::mutex
+// ------------------------------------------------------------------------
+
+mutex::mutex()
+{
+    if ( (mutex_ = xmlNewMutex()) == 0)
+        throw std::bad_alloc();
+}
+
+
+mutex::~mutex()
+{
+    xmlFreeMutex(mutex_);
+}
+
+
+void mutex::lock()
+{
+    xmlMutexLock(mutex_);
+}
+
+
+void mutex::unlock()
+{
+    xmlMutexUnlock(mutex_);
+}
+
+} // namespace impl
+
+} // namespace xml
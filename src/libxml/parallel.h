@@ -0,0 +1,158 @@
+/*
+ * Copyright (C) 2026 xmlwrapp contributors
+ * All Rights Reserved
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name of the Author nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ * USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#ifndef _xmlwrapp_parallel_h_
+#define _xmlwrapp_parallel_h_
+
+// xmlwrapp includes
+#include "xmlwrapp/export.h"
+
+// standard includes
+#include <cstddef>
+
+// libxml includes
+#include <libxml/threads.h>
+
+namespace xml
+{
+
+namespace impl
+{
+
+// Base class for units of work executed by run_in_parallel(). Tasks must
+// not let exceptions escape from run(), they have to catch them and report
+// the error in some other way.
+class parallel_task
+{
+public:
+    virtual ~parallel_task() {}
+    virtual void run() = 0;
+};
+
+// Run all the given tasks concurrently and return after all of them are
+// finished. The first task is run in the calling thread; if a thread can't
+// be created for some other task, it is run in the calling thread too.
+XMLWRAPP_API void run_in_parallel(parallel_task **tasks, std::size_t count);
+
+// Get the number of processors available, at least 1.
+XMLWRAPP_API unsigned cpu_count();
+
+// Get a number identifying the calling thread among the running ones.
+XMLWRAPP_API unsigned long current_thread_id();
+
+// Atomically add delta to the value and return the new value.
+XMLWRAPP_API long atomic_add(volatile long& value, long delta);
+
+// Atomically replace the value with the desired one if it is equal to the
+// expected one, return true if it was replaced.
+XMLWRAPP_API bool atomic_compare_exchange(volatile long& value,
+                                          long expected,
+                                          long desired);
+
+// Same as above for pointers, but return the previous value of the pointer,
+// so that atomic_compare_exchange(p, 0, 0) can be used to read it.
+XMLWRAPP_API void* atomic_compare_exchange(void * volatile& value,
+                                           void *expected,
+                                           void *desired);
+
+// Lock for the lifetime of this object using a long initialized to 0 as
+// the lock state. Unlike xml::impl::mutex, this doesn't need any dynamic
+// initialization and so can be used by the static objects initializing the
+// library. Waiting threads just yield the processor in a loop, so it's only
+// suitable for rarely contended locks.
+class XMLWRAPP_API static_lock
+{
+public:
+    explicit static_lock(volatile long& state);
+    ~static_lock();
+
+private:
+    volatile long& state_;
+
+    static_lock(const static_lock&);
+    static_lock& operator=(const static_lock&);
+};
+
+// Pointer with a separate value in each thread. Like static_lock, it doesn't
+// need any dynamic initialization: define it as a static variable initialized
+// with { 0, 0, 0, destroy }, where destroy, if not NULL, is called with the
+// non-NULL values of the exiting threads. Under Windows the values are not
+// destroyed, the threads must reset them themselves if necessary.
+struct XMLWRAPP_API thread_slot
+{
+    void* get();
+    void set(void *value);
+
+    // these members are public only to allow static initialization
+    volatile long lock_;
+    volatile long created_;
+    unsigned long key_;
+    void (*destroy_)(void*);
+};
+
+
+// Non-recursive mutex.
+class XMLWRAPP_API mutex
+{
+public:
+    mutex();
+    ~mutex();
+
+    void lock();
+    void unlock();
+
+private:
+    xmlMutexPtr mutex_;
+
+    mutex(const mutex&);
+    mutex& operator=(const mutex&);
+};
+
+// Locks the mutex for the lifetime of this object.
+class mutex_lock
+{
+public:
+    explicit mutex_lock(mutex& m) : mutex_(m) { mutex_.lock(); }
+    ~mutex_lock() { mutex_.unlock(); }
+
+private:
+    mutex& mutex_;
+
+    mutex_lock(const mutex_lock&);
+    mutex_lock& operator=(const mutex_lock&);
+};
+
+} // namespace impl
+
+} // namespace xml
+
+#endif // _xmlwrapp_parallel_h_
@@ -0,0 +1,592 @@
+/*
+ * Copyright (C) 2026 xmlwrapp contributors
+ * All Rights Reserved
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name of the Author nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ * USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+// xmlwrapp includes
+#include "parallel_save.h"
+#include "parallel.h"
+#include "utility.h"
+
+// standard includes
+#include <new>
+#include <cstdio>
+#include <deque>
+
+// libxml includes
+#include <libxml/encoding.h>
+#include <libxml/globals.h>
+#include <libxml/xmlIO.h>
+#include <libxml/xmlsave.h>
+
+#ifndef _WIN32
+    #include <fcntl.h>
+    #include <limits.h>
+    #include <sys/uio.h>
+    #include <unistd.h>
+    #include <errno.h>
+
+    #ifndef IOV_MAX
+        #define IOV_MAX 16
+    #endif
+#endif
+
+namespace
+{
+
+// The output of every range is stored in blocks of this size, so that it
+// never needs to be moved while it grows.
+const std::string::size_type BLOCK_SIZE = 1024 * 1024;
+
+typedef std::deque<std::string> block_list;
+
+} // anonymous namespace
+
+extern "C"
+{
+
+static int append_to_blocks(void *context, const char *buffer, int len)
+{
+    try
+    {
+        block_list& blocks = *static_cast<block_list*>(context);
+
+        if (blocks.empty() || blocks.back().size() + len > blocks.back().capacity())
+        {
+            blocks.push_back(std::string());
+            blocks.back().reserve(BLOCK_SIZE > std::string::size_type(len) ? BLOCK_SIZE : len);
+        }
+
+        blocks.back().append(buffer, len);
+        return len;
+    }
+    catch (...)
+    {
+        return -1;
+    }
+}
+
+static int close_blocks(void *)
+{
+    return 0;
+}
+
+} // extern "C"
+
+namespace xml
+{
+
+namespace impl
+{
+
+namespace
+{
+
+// libxml2 keeps these settings per thread, the threads converting the
+// ranges must use the values set in the thread saving the document
+struct save_settings
+{
+    save_settings()
+        : indent_tree_output(xmlIndentTreeOutput),
+          save_no_empty_tags(xmlSaveNoEmptyTags),
+          tree_indent_string(xmlTreeIndentString)
+    {}
+
+    void apply() const
+    {
+        xmlIndentTreeOutput = indent_tree_output;
+        xmlSaveNoEmptyTags = save_no_empty_tags;
+        xmlTreeIndentString = tree_indent_string;
+    }
+
+    int indent_tree_output;
+    int save_no_empty_tags;
+    const char *tree_indent_string;
+};
+
+
+// Only stateless encodings can be used, as each range is converted
+// separately.
+bool is_supported_encoding(const char *encoding)
+{
+    if (!encoding)
+        return true;
+
+    switch (xmlParseCharEncoding(encoding))
+    {
+        case XML_CHAR_ENCODING_UTF8:
+        case XML_CHAR_ENCODING_ASCII:
+        case XML_CHAR_ENCODING_8859_1:
+        case XML_CHAR_ENCODING_8859_2:
+        case XML_CHAR_ENCODING_8859_3:
+        case XML_CHAR_ENCODING_8859_4:
+        case XML_CHAR_ENCODING_8859_5:
+        case XML_CHAR_ENCODING_8859_6:
+        case XML_CHAR_ENCODING_8859_7:
+        case XML_CHAR_ENCODING_8859_8:
+        case XML_CHAR_ENCODING_8859_9:
+            return true;
+
+        default:
+            return false;
+    }
+}
+
+
+// libxml2 doesn't indent the children of an element if any of them
+// contains text
+bool is_formatted(xmlNodePtr parent)
+{
+    for (xmlNodePtr child = parent->children; child; child = child->next)
+    {
+        if (child->type == XML_TEXT_NODE ||
+            child->type == XML_CDATA_SECTION_NODE ||
+            child->type == XML_ENTITY_REF_NODE)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
+// When saving a document without encoding, libxml2 escapes all non-ASCII
+// characters of the text nodes. This is only done when saving the whole
+// document, so the ranges can be converted separately only if their text
+// doesn't need such escaping.
+bool has_plain_text(const xmlChar *text)
+{
+    for (; *text; ++text)
+    {
+        if ((*text < 0x20 || *text >= 0x80) && *text != '\n' && *text != '\t')
+            return false;
+    }
+
+    return true;
+}
+
+bool has_plain_text(xmlNodePtr first, xmlNodePtr last)
+{
+    for (xmlNodePtr top = first; top != last; top = top->next)
+    {
+        xmlNodePtr n = top;
+        for (;;)
+        {
+            if (n->type == XML_TEXT_NODE && n->content && !has_plain_text(n->content))
+                return false;
+
+            if (n->type == XML_ELEMENT_NODE && n->children)
+            {
+                n = n->children;
+                continue;
+            }
+
+            while (n != top && !n->next)
+                n = n->parent;
+
+            if (n == top)
+                break;
+
+            n = n->next;
+        }
+    }
+
+    return true;
+}
+
+
+xmlOutputBufferPtr blocks_output(block_list& blocks, const char *encoding)
+{
+    xmlCharEncodingHandlerPtr handler = 0;
+    if (encoding)
+    {
+        if ( (handler = xmlFindCharEncodingHandler(encoding)) == 0)
+            return 0;
+    }
+
+    return xmlOutputBufferCreateIO(append_to_blocks, close_blocks, &blocks, handler);
+}
+
+
+// what is common to all the ranges of a document
+struct range_context
+{
+    xmlDocPtr doc;
+    const char *encoding;
+    bool format;
+    std::string indent;
+    save_settings settings;
+};
+
+
+// Converts the children of the root element in [first, last) exactly as
+// they would be written when saving the whole document.
+class save_range_task : public parallel_task
+{
+public:
+    save_range_task(const range_context& context, xmlNodePtr first, xmlNodePtr last, block_list& output)
+        : context_(&context), first_(first), last_(last), output_(&output), ok_(false)
+    {}
+
+    virtual void run()
+    {
+        try
+        {
+            ok_ = save();
+        }
+        catch (...)
+        {
+            ok_ = false;
+        }
+    }
+
+    bool ok() const { return ok_; }
+
+private:
+    bool save()
+    {
+        context_->settings.apply();
+
+        if (!context_->encoding && !has_plain_text(first_, last_))
+            return false;
+
+        xmlOutputBufferPtr buffer = blocks_output(*output_, context_->encoding);
+        if (!buffer)
+            return false;
+
+        for (xmlNodePtr n = first_; n != last_; n = n->next)
+        {
+            if (context_->format)
+            {
+                if (n->type == XML_ELEMENT_NODE ||
+                    n->type == XML_COMMENT_NODE ||
+                    n->type == XML_PI_NODE)
+                {
+                    xmlOutputBufferWrite(buffer, context_->indent.size(), context_->indent.data());
+                }
+            }
+
+            xmlNodeDumpOutput(buffer, context_->doc, n, 1, context_->format ? 1 : 0, context_->encoding);
+
+            if (context_->format && n->type != XML_XINCLUDE_START && n->type != XML_XINCLUDE_END)
+                xmlOutputBufferWrite(buffer, 1, "\n");
+        }
+
+        return xmlOutputBufferClose(buffer) >= 0;
+    }
+
+    const range_context *context_;
+    xmlNodePtr first_;
+    xmlNodePtr last_;
+    block_list *output_;
+    bool ok_;
+};
+
+
+class doc_guard
+{
+public:
+    explicit doc_guard(xmlDocPtr doc) : doc_(doc) {}
+    ~doc_guard() { xmlFreeDoc(doc_); }
+
+private:
+    xmlDocPtr doc_;
+
+    doc_guard(const doc_guard&);
+    doc_guard& operator=(const doc_guard&);
+};
+
+
+std::string dump_doc(xmlDocPtr doc, const char *encoding)
+{
+    xmlChar *xml_string = 0;
+    int xml_string_length = 0;
+    xmlDocDumpFormatMemoryEnc(doc, &xml_string, &xml_string_length, encoding, 1);
+
+    if (!xml_string)
+        throw std::bad_alloc();
+
+    xmlchar_helper helper(xml_string);
+    return std::string(helper.get(), xml_string_length);
+}
+
+
+// Get the output before and after the children of the root element by
+// saving a copy of the document without them. The copy of the root
+// contains a single placeholder node instead, which is saved twice with
+// different contents to find out where exactly it is in the output.
+bool save_around_root(const range_context& context, xmlNodePtr root,
+                      std::string& prefix, std::string& suffix, std::string& indent)
+{
+    xmlDocPtr skeleton = xmlCopyDoc(context.doc, 0);
+    if (!skeleton)
+        throw std::bad_alloc();
+
+    doc_guard guard(skeleton);
+    xmlNodePtr placeholder = 0;
+
+    for (xmlNodePtr n = context.doc->children; n; n = n->next)
+    {
+        xmlNodePtr copy;
+
+        if (n->type == XML_DTD_NODE)
+        {
+            xmlDtdPtr dtd = xmlCopyDtd(reinterpret_cast<xmlDtdPtr>(n));
+            if (!dtd)
+                throw std::bad_alloc();
+
+            xmlSetTreeDoc(reinterpret_cast<xmlNodePtr>(dtd), skeleton);
+            if (n == reinterpret_cast<xmlNodePtr>(context.doc->intSubset))
+                skeleton->intSubset = dtd;
+            copy = reinterpret_cast<xmlNodePtr>(dtd);
+        }
+        else if (n == root)
+        {
+            // copy the root with its attributes and namespaces only
+            if ( (copy = xmlDocCopyNode(n, skeleton, 2)) == 0)
+                throw std::bad_alloc();
+
+            // the placeholder must not change the formatting of the root
+            const xmlChar *a = reinterpret_cast<const xmlChar*>("a");
+            if (context.format)
+                placeholder = xmlNewDocComment(skeleton, a);
+            else
+                placeholder = xmlNewDocText(skeleton, a);
+
+            if (!placeholder)
+            {
+                xmlFreeNode(copy);
+                throw std::bad_alloc();
+            }
+
+            xmlAddChild(copy, placeholder);
+        }
+        else
+        {
+            if ( (copy = xmlDocCopyNode(n, skeleton, 1)) == 0)
+                throw std::bad_alloc();
+        }
+
+        xmlAddChild(reinterpret_cast<xmlNodePtr>(skeleton), copy);
+    }
+
+    const std::string first = dump_doc(skeleton, context.encoding);
+    xmlNodeSetContent(placeholder, reinterpret_cast<const xmlChar*>("b"));
+    const std::string second = dump_doc(skeleton, context.encoding);
+
+    if (first.size() != second.size())
+        return false;
+
+    std::string::size_type pos = 0;
+    while (pos < first.size() && first[pos] == second[pos])
+        ++pos;
+
+    if (pos == first.size())
+        return false;
+
+    if (!context.format)
+    {
+        prefix.assign(first, 0, pos);
+        suffix.assign(first, pos + 1, std::string::npos);
+        return true;
+    }
+
+    // the placeholder comment is on its own line, possibly indented
+    const std::string::size_type start = pos - 4;
+    if (pos < 5 || first.compare(start, 4, "<!--") != 0 || first.compare(pos + 1, 4, "-->\n") != 0)
+        return false;
+
+    const std::string::size_type line = first.rfind('\n', start - 1);
+    if (line == std::string::npos)
+        return false;
+
+    prefix.assign(first, 0, line + 1);
+    indent.assign(first, line + 1, start - line - 1);
+    suffix.assign(first, pos + 5, std::string::npos);
+
+    return true;
+}
+
+} // anonymous namespace
+
+
+bool save_in_parallel(xmlDocPtr doc, unsigned thread_count, std::vector<std::string>& pieces)
+{
+    const char *encoding = reinterpret_cast<const char*>(doc->encoding);
+    if (!is_supported_encoding(encoding))
+        return false;
+
+    xmlNodePtr root = xmlDocGetRootElement(doc);
+    if (!root)
+        return false;
+
+    std::size_t child_count = 0;
+    for (xmlNodePtr child = root->children; child; child = child->next)
+        ++child_count;
+
+    std::size_t range_count = thread_count;
+    if (range_count > child_count)
+        range_count = child_count;
+    if (range_count < 2)
+        return false;
+
+    range_context context;
+    context.doc = doc;
+    context.encoding = encoding;
+    context.format = is_formatted(root);
+
+    std::string prefix, suffix;
+    if (!save_around_root(context, root, prefix, suffix, context.indent))
+        return false;
+
+    std::vector<block_list> output(range_count);
+
+    std::vector<save_range_task> savers;
+    savers.reserve(range_count);
+    std::vector<parallel_task*> tasks;
+
+    xmlNodePtr first = root->children;
+    for (std::size_t i = 0; i < range_count; ++i)
+    {
+        // spread the remainder over the first ranges
+        std::size_t size = child_count / range_count + (i < child_count % range_count ? 1 : 0);
+
+        xmlNodePtr last = first;
+        while (size--)
+            last = last->next;
+
+        savers.push_back(save_range_task(context, first, last, output[i]));
+        tasks.push_back(&savers.back());
+
+        first = last;
+    }
+
+    run_in_parallel(&tasks[0], tasks.size());
+
+    std::size_t block_count = 0;
+    for (std::size_t i = 0; i < savers.size(); ++i)
+    {
+        if (!savers[i].ok())
+            return false;
+        block_count += output[i].size();
+    }
+
+    // swap the strings into place instead of copying them
+    std::vector<std::string> all(block_count + 2);
+    std::vector<std::string>::iterator dest = all.begin();
+
+    (dest++)->swap(prefix);
+    for (std::size_t i = 0; i < output.size(); ++i)
+    {
+        for (block_list::iterator block = output[i].begin(); block != output[i].end(); ++block)
+            (dest++)->swap(*block);
+    }
+    dest->swap(suffix);
+
+    pieces.swap(all);
+    return true;
+}
+
+
+#ifdef _WIN32
+
+bool write_pieces(const char *filename, const std::vector<std::string>& pieces)
+{
+    std::FILE *file = std::fopen(filename, "wb");
+    if (!file)
+        return false;
+
+    bool ok = true;
+    for (std::size_t i = 0; ok && i < pieces.size(); ++i)
+    {
+        if (!pieces[i].empty())
+            ok = std::fwrite(pieces[i].data(), pieces[i].size(), 1, file) == 1;
+    }
+
+    return std::fclose(file) == 0 && ok;
+}
+
+#else // !_WIN32
+
+bool write_pieces(const char *filename, const std::vector<std::string>& pieces)
+{
+    int fd = open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    if (fd < 0)
+        return false;
+
+    std::vector<iovec> iov(pieces.size());
+    for (std::size_t i = 0; i < pieces.size(); ++i)
+    {
+        iov[i].iov_base = const_cast<char*>(pieces[i].data());
+        iov[i].iov_len = pieces[i].size();
+    }
+
+    bool ok = true;
+    std::size_t current = 0;
+    while (ok && current < iov.size())
+    {
+        if (iov[current].iov_len == 0)
+        {
+            ++current;
+            continue;
+        }
+
+        int count = static_cast<int>(iov.size() - current);
+        if (count > IOV_MAX)
+            count = IOV_MAX;
+
+        ssize_t written = writev(fd, &iov[current], count);
+        if (written < 0)
+        {
+            ok = errno == EINTR;
+            continue;
+        }
+
+        // skip what was written, the last buffer may be written partially
+        std::size_t left = static_cast<std::size_t>(written);
+        while (left && left >= iov[current].iov_len)
+            left -= iov[current++].iov_len;
+
+        if (left)
+        {
+            iov[current].iov_base = static_cast<char*>(iov[current].iov_base) + left;
+            iov[current].iov_len -= left;
+        }
+    }
+
+    return close(fd) == 0 && ok;
+}
+
+#endif // _WIN32/!_WIN32
+
+} // namespace impl
+
+} // namespace xml
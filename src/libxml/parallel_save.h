@@ -0,0 +1,94 @@
+/*
+ * Copyright (C) 2026 xmlwrapp contributors
+ * All Rights Reserved
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name of the Author nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ * USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/**
+    @file
+
+    This file contains the functions used for saving documents using several
+    threads.
+ */
+
+#ifndef _xmlwrapp_parallel_save_h_
+#define _xmlwrapp_parallel_save_h_
+
+// standard includes
+#include <string>
+#include <vector>
+
+// libxml includes
+#include <libxml/tree.h>
+
+namespace xml
+{
+
+namespace impl
+{
+
+/**
+    @internal
+
+    Convert the document to text using up to the given number of threads.
+    The children of the root element are split into contiguous ranges and
+    each range is converted in its own thread.
+
+    The concatenation of the resulting pieces is identical to the output of
+    xmlDocDumpFormatMemoryEnc() with the encoding stored in the document.
+
+    @param doc The document to convert.
+    @param thread_count The maximum number of threads to use.
+    @param pieces Filled with the output pieces, in order.
+
+    @return False if the document can't be converted in parallel, e.g.
+            because its root has less than two children or it uses an
+            encoding not supported by this function. Nothing is stored in
+            @a pieces in this case.
+ */
+bool save_in_parallel(xmlDocPtr doc, unsigned thread_count, std::vector<std::string>& pieces);
+
+/**
+    @internal
+
+    Write the given pieces to a file, in order, replacing its contents.
+    Vectored I/O is used on the platforms supporting it.
+
+    @param filename The path of the file to write.
+    @param pieces The data to write.
+
+    @return True if all the data was written successfully.
+ */
+bool write_pieces(const char *filename, const std::vector<std::string>& pieces);
+
+} // namespace impl
+
+} // namespace xml
+
+#endif // _xmlwrapp_parallel_save_h_
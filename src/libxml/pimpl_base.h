@@ -33,8 +33,12 @@
 #ifndef _xmlwrapp_pimpl_base_h_
 #define _xmlwrapp_pimpl_base_h_
 
+// standard includes
+#include <cassert>
+#include <cstddef>
+#include <new>
+
 #ifdef HAVE_BOOST_POOL_SINGLETON_POOL_HPP
-    #include <cassert>
     #include <boost/pool/singleton_pool.hpp>
 #endif // HAVE_BOOST_POOL_SINGLETON_POOL_HPP
 
@@ -44,13 +48,22 @@ namespace xml
 namespace impl
 {
 
+// Allocate the memory for a pimpl using the xml::memory allocator, if one
+// was set, or the given default function otherwise, and update the memory
+// statistics. Throws std::bad_alloc if the memory couldn't be allocated.
+void* allocate_pimpl(std::size_t size, void* (*default_alloc)(std::size_t));
+
+// Free the memory allocated by allocate_pimpl().
+void deallocate_pimpl(void *ptr, std::size_t size, void (*default_dealloc)(void*));
+
 // Base class for all pimpl classes. Uses custom pool allocator for better
-// performance. Usage: derive your class FooImpl from pimpl_base<FooImpl>.
+// performance, unless xml::memory::set_allocator() was called. Usage:
+// derive your class FooImpl from pimpl_base<FooImpl>.
 template<typename T>
 class pimpl_base
 {
-#ifdef HAVE_BOOST_POOL_SINGLETON_POOL_HPP
 public:
+#ifdef HAVE_BOOST_POOL_SINGLETON_POOL_HPP
     struct xmlwrapp_pool_tag {};
 
     // NB: we can't typedef the pool type as pimpl_base<T> subtype,
@@ -59,20 +72,40 @@ public:
     //     (compiled only when T, and so sizeof(T), is known)
     #define XMLWRAPP_PIMPL_ALLOCATOR_TYPE(T) \
         boost::singleton_pool<xmlwrapp_pool_tag, sizeof(T)>
+#endif // HAVE_BOOST_POOL_SINGLETON_POOL_HPP
 
     static void* operator new(size_t size)
     {
         assert( size == sizeof(T) );
-        return XMLWRAPP_PIMPL_ALLOCATOR_TYPE(T)::malloc();
+        return allocate_pimpl(size, default_alloc);
     }
 
     static void operator delete(void *ptr, size_t size)
     {
         assert( size == sizeof(T) );
         if ( ptr )
-            XMLWRAPP_PIMPL_ALLOCATOR_TYPE(T)::free(ptr);
+            deallocate_pimpl(ptr, size, default_dealloc);
+    }
+
+private:
+    static void* default_alloc(std::size_t size)
+    {
+#ifdef HAVE_BOOST_POOL_SINGLETON_POOL_HPP
+        (void)size;
+        return XMLWRAPP_PIMPL_ALLOCATOR_TYPE(T)::malloc();
+#else
+        return ::operator new(size, std::nothrow);
+#endif
+    }
+
+    static void default_dealloc(void *ptr)
+    {
+#ifdef HAVE_BOOST_POOL_SINGLETON_POOL_HPP
+        XMLWRAPP_PIMPL_ALLOCATOR_TYPE(T)::free(ptr);
+#else
+        ::operator delete(ptr);
+#endif
     }
-#endif // HAVE_BOOST_POOL_SINGLETON_POOL_HPP
 };
 
 } // namespace impl
@@ -35,6 +35,7 @@
 #include "xmlwrapp/document.h"
 #include "xmlwrapp/exception.h"
 #include "utility.h"
+#include "pimpl_base.h"
 
 // libxml includes
 #include <libxml/parser.h>
@@ -65,7 +66,7 @@ using namespace impl;
 // xml::impl::tree_impl
 // ------------------------------------------------------------------------
 
-struct impl::tree_impl
+struct impl::tree_impl : public pimpl_base<impl::tree_impl>
 {
     tree_impl();
 
@@ -127,6 +128,8 @@ extern "C" void cb_tree_ignore(void*, const xmlChar*, int)
 impl::tree_impl::tree_impl()
     : last_error_(DEFAULT_ERROR), warnings_(false), okay_(false)
 {
+    ensure_initialized();
+
     std::memset(&sax_, 0, sizeof(sax_));
     initxmlDefaultSAXHandler(&sax_, 0);
 
@@ -40,6 +40,7 @@
 #endif
 
 #include "utility.h"
+#include "parallel.h"
 
 #include <cstdarg>
 #include <cstdlib>
@@ -76,6 +77,33 @@ XMLWRAPP_API void printf2string(std::string& s, const char *message, va_list ap)
     }
 }
 
+
+const char* cache_string(void *&cache, xmlChar *value)
+{
+    void *expected = 0;
+
+    for ( ;; )
+    {
+        void *cached = atomic_compare_exchange(cache, expected, value);
+        if (cached == expected)
+        {
+            // the previous value can only be different if the tree was
+            // modified and then nobody else may be using it
+            if (cached)
+                xmlFree(cached);
+            return reinterpret_cast<const char*>(value);
+        }
+
+        if (xmlStrEqual(static_cast<xmlChar*>(cached), value))
+        {
+            xmlFree(value);
+            return static_cast<const char*>(cached);
+        }
+
+        expected = cached;
+    }
+}
+
 } // namespace impl
 
 } // namespace xml
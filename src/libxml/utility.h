@@ -41,6 +41,7 @@
 
 // libxml2 includes
 #include <libxml/tree.h>
+#include <libxml/xmlerror.h>
 
 namespace xml
 {
@@ -48,6 +49,40 @@ namespace xml
 namespace impl
 {
 
+// Initialize the library if it isn't initialized yet, this is needed when
+// XMLWRAPP_LAZY_INIT is used and there are no xml::init objects.
+XMLWRAPP_API void ensure_initialized();
+
+// Start using the xml::memory allocator, which can't be changed any more
+// after this. Must be called before libxml2 allocates any memory.
+void use_allocator();
+
+// Make libxml2 report the errors in all threads to xml::error_capture.
+void install_error_capture();
+
+// Record the error for xml::error_capture.
+void capture_error(xmlErrorPtr error);
+
+// Record an error reported only as a message, e.g. by libxslt.
+XMLWRAPP_API void capture_message(int domain, const char *message, va_list ap);
+
+// While this object exists, libxml2 reports the errors happening in the
+// current thread only to the callbacks given to it, which need to pass
+// xmlGetLastError() to capture_error() themselves.
+class suspend_error_capture
+{
+public:
+    suspend_error_capture();
+    ~suspend_error_capture();
+
+private:
+    xmlStructuredErrorFunc handler_;
+    void *context_;
+
+    suspend_error_capture(const suspend_error_capture&);
+    suspend_error_capture& operator=(const suspend_error_capture&);
+};
+
 // exception safe wrapper around xmlChar*s that are returned from some
 // of the libxml functions that the user must free.
 class xmlchar_helper
@@ -67,6 +102,16 @@ private:
 
 void printf2string(std::string& s, const char *message, va_list ap);
 
+// Make the cache, which must be initialized to 0 and freed with xmlFree(),
+// contain the given string and return a pointer to it. Takes ownership of
+// the value. The cache is only modified if it contains a different value,
+// so const methods may use this to return strings that are not stored in
+// the tree as such: several threads may read the same unmodified tree and
+// get the same pointer without any of them invalidating it. No lock is
+// taken, the first value is stored with an atomic compare and exchange, so
+// the cache must not be accessed otherwise while other threads may use it.
+const char* cache_string(void *&cache, xmlChar *value);
+
 // Sun CC uses ancient C++ standard library that doesn't have standard
 // std::distance(). Work around it here
 #if defined(__SUNPRO_CC) && !defined(_STLPORT_VERSION)
@@ -0,0 +1,323 @@
+/*
+ * Copyright (C) 2001-2003 Peter J Jones (pjones@pmade.org)
+ * All Rights Reserved
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name of the Author nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ * USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include "context_pool.h"
+
+// libxslt includes
+#include <libxslt/xslt.h>
+#include <libxslt/transform.h>
+#include <libxslt/documents.h>
+#include <libxslt/extensions.h>
+#include <libxslt/keys.h>
+#include <libxslt/variables.h>
+#include <libxslt/security.h>
+#include <libxslt/xsltutils.h>
+
+// libxml includes
+#include <libxml/dict.h>
+#include <libxml/xpath.h>
+
+namespace xslt
+{
+
+namespace impl
+{
+
+namespace
+{
+
+// don't keep more idle contexts than can reasonably be used at once
+const std::size_t MAX_IDLE_CONTEXTS = 16;
+
+
+// free the tree fragments cached by the context for reuse, they refer to
+// the dictionary of the context
+void free_cached_fragments(xsltTransformContextPtr ctxt)
+{
+    xsltTransformCachePtr cache = ctxt->cache;
+    if (!cache)
+        return;
+
+    xmlDocPtr cur = cache->RVT;
+    while (cur)
+    {
+        xmlDocPtr next = reinterpret_cast<xmlDocPtr>(cur->next);
+        if (cur->_private)
+        {
+            xsltFreeDocumentKeys(static_cast<xsltDocumentPtr>(cur->_private));
+            xmlFree(cur->_private);
+        }
+        xmlFreeDoc(cur);
+        cur = next;
+    }
+
+    cache->RVT = NULL;
+    cache->nbRVT = 0;
+}
+
+
+// free everything the last transformation left in the context, mirroring
+// what xsltFreeTransformContext() does but keeping the context itself,
+// together with its XPath context, and reset all the fields
+// that describe the state of a transformation to their initial values
+void reset_context(xsltTransformContextPtr ctxt,
+                   int xpath_context_size,
+                   int xpath_proximity_position)
+{
+    // pattern matching caches the nodes of the last document here
+    for (int i = 0; i < ctxt->extrasNr; ++i)
+    {
+        xsltRuntimeExtraPtr extra = &ctxt->extras[i];
+        if (extra->deallocate && extra->info)
+            extra->deallocate(extra->info);
+        extra->info = NULL;
+        extra->deallocate = NULL;
+        extra->val.ptr = NULL;
+    }
+
+    xsltShutdownCtxtExts(ctxt);
+
+    xsltFreeGlobalVariables(ctxt);
+    ctxt->globalVars = NULL;
+
+    // this doesn't free the main documents, i.e. the input one and those
+    // shared by xslt::document_loader
+    xsltFreeDocuments(ctxt);
+    ctxt->docList = NULL;
+    ctxt->styleList = NULL;
+    ctxt->document = NULL;
+
+    xsltFreeRVTs(ctxt);
+    ctxt->localRVT = NULL;
+    ctxt->tmpRVT = NULL;
+    ctxt->persistRVT = NULL;
+    free_cached_fragments(ctxt);
+
+    // the result document keeps using the dictionary, possibly in another
+    // thread, so the next transformation must get a new one
+    xmlDictFree(ctxt->dict);
+    ctxt->dict = NULL;
+    ctxt->xpathCtxt->dict = NULL;
+
+    ctxt->templ = NULL;
+    ctxt->vars = NULL;
+    ctxt->varsBase = 0;
+    ctxt->mode = NULL;
+    ctxt->modeURI = NULL;
+    ctxt->node = NULL;
+    ctxt->nodeList = NULL;
+    ctxt->output = NULL;
+    ctxt->insert = NULL;
+    ctxt->inst = NULL;
+    ctxt->outputFile = NULL;
+    ctxt->prof = 0;
+    ctxt->profNr = 0;
+    ctxt->_private = NULL;
+    ctxt->error = NULL;
+    ctxt->errctx = NULL;
+    ctxt->sortfunc = NULL;
+    ctxt->ctxtflags = 0;
+    ctxt->lasttext = NULL;
+    ctxt->lasttsize = 0;
+    ctxt->lasttuse = 0;
+    ctxt->nbKeys = 0;
+    ctxt->hasTemplKeyPatterns = 0;
+    ctxt->currentTemplateRule = NULL;
+    ctxt->initialContextNode = NULL;
+    ctxt->initialContextDoc = NULL;
+    ctxt->contextVariable = NULL;
+    ctxt->keyInitLevel = 0;
+#ifdef HAVE_XSLTTRANSFORMCONTEXT_OPLIMIT
+    ctxt->opLimit = 0;
+#endif
+#ifdef HAVE_XSLTTRANSFORMCONTEXT_SOURCEDOCDIRTY
+    // libxslt cleans up the source document itself at the end of the
+    // transformation, so the flag only needs to be reset
+    ctxt->sourceDocDirty = 0;
+#endif
+#ifdef HAVE_XSLTTRANSFORMCONTEXT_CURRENTID
+    ctxt->currentId = 0;
+#endif
+
+    xmlXPathContextPtr xpath = ctxt->xpathCtxt;
+    xpath->doc = NULL;
+    xpath->node = NULL;
+    xpath->contextSize = xpath_context_size;
+    xpath->proximityPosition = xpath_proximity_position;
+    xpath->namespaces = NULL;
+    xpath->nsNr = 0;
+}
+
+
+// check if the context was left in a state allowing to reuse it
+bool is_reusable(xsltTransformContextPtr ctxt)
+{
+    return ctxt->state == XSLT_STATE_OK &&
+           ctxt->depth == 0 &&
+           ctxt->templNr == 0 &&
+           ctxt->varsNr == 0;
+}
+
+
+// prepare a pooled context for transforming the given document, this sets
+// the fields xsltNewTransformContext() initializes from the document and the
+// global settings
+bool prepare_context(xsltTransformContextPtr ctxt, xmlDocPtr doc)
+{
+    xsltStylesheetPtr style = ctxt->style;
+
+    ctxt->dict = xmlDictCreateSub(style->dict);
+    if (!ctxt->dict)
+        return false;
+    ctxt->xpathCtxt->dict = ctxt->dict;
+    ctxt->internalized = style->internalized;
+
+    if (xsltInitCtxtExts(ctxt) < 0)
+        return false;
+
+    ctxt->debugStatus = xsltGetDebuggerStatus();
+    if (ctxt->debugStatus == XSLT_DEBUG_NONE)
+        xmlXPathOrderDocElems(doc);
+
+    ctxt->parserOptions = XSLT_PARSE_OPTIONS;
+
+    xsltDocumentPtr document = xsltNewDocument(ctxt, doc);
+    if (!document)
+        return false;
+
+    document->main = 1;
+    ctxt->document = document;
+
+    ctxt->xpathCtxt->doc = doc;
+    ctxt->xpathCtxt->node = reinterpret_cast<xmlNodePtr>(doc);
+
+    ctxt->state = XSLT_STATE_OK;
+    ctxt->profile = 0;
+#ifdef HAVE_XSLTTRANSFORMCONTEXT_OPLIMIT
+    ctxt->opCount = 0;
+#endif
+    ctxt->maxTemplateDepth = xsltMaxDepth;
+    ctxt->maxTemplateVars = xsltMaxVars;
+    ctxt->xinclude = xsltGetXIncludeDefault();
+    ctxt->sec = xsltGetDefaultSecurityPrefs();
+
+    return true;
+}
+
+} // anonymous namespace
+
+
+context_pool::context_pool()
+    : xpath_context_size_(-1), xpath_proximity_position_(-1)
+{
+    xmlXPathContextPtr xpath = xmlXPathNewContext(NULL);
+    if (xpath)
+    {
+        xpath_context_size_ = xpath->contextSize;
+        xpath_proximity_position_ = xpath->proximityPosition;
+        xmlXPathFreeContext(xpath);
+    }
+}
+
+
+xsltTransformContextPtr context_pool::acquire(xsltStylesheetPtr style, xmlDocPtr doc)
+{
+    xsltTransformContextPtr ctxt = NULL;
+    {
+        const unsigned long thread = xml::impl::current_thread_id();
+
+        xml::impl::mutex_lock lock(mutex_);
+        if (!idle_.empty())
+        {
+            // take the most recently released context of this thread, or
+            // the most recent one of any thread if there is none
+            std::size_t n = idle_.size() - 1;
+            for (std::size_t i = idle_.size(); i > 0; --i)
+            {
+                if (idle_[i - 1].thread == thread)
+                {
+                    n = i - 1;
+                    break;
+                }
+            }
+
+            ctxt = idle_[n].ctxt;
+            idle_.erase(idle_.begin() + n);
+        }
+    }
+
+    if (ctxt)
+    {
+        if (prepare_context(ctxt, doc))
+            return ctxt;
+
+        xsltFreeTransformContext(ctxt);
+    }
+
+    return xsltNewTransformContext(style, doc);
+}
+
+
+void context_pool::release(xsltTransformContextPtr ctxt, bool successful)
+{
+    if (successful && is_reusable(ctxt))
+    {
+        reset_context(ctxt, xpath_context_size_, xpath_proximity_position_);
+
+        idle_context idle;
+        idle.ctxt = ctxt;
+        idle.thread = xml::impl::current_thread_id();
+
+        xml::impl::mutex_lock lock(mutex_);
+        if (idle_.size() < MAX_IDLE_CONTEXTS)
+        {
+            idle_.push_back(idle);
+            return;
+        }
+    }
+
+    xsltFreeTransformContext(ctxt);
+}
+
+
+void context_pool::clear()
+{
+    xml::impl::mutex_lock lock(mutex_);
+
+    for (std::size_t i = 0; i < idle_.size(); ++i)
+        xsltFreeTransformContext(idle_[i].ctxt);
+    idle_.clear();
+}
+
+} // end impl namespace
+
+} // end xslt namespace
@@ -0,0 +1,98 @@
+/*
+ * Copyright (C) 2001-2003 Peter J Jones (pjones@pmade.org)
+ * All Rights Reserved
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name of the Author nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ * USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#ifndef _xsltwrapp_context_pool_h_
+#define _xsltwrapp_context_pool_h_
+
+#include "../libxml/parallel.h"
+
+// libxslt includes
+#include <libxslt/xsltInternals.h>
+
+// standard includes
+#include <vector>
+
+namespace xslt
+{
+
+namespace impl
+{
+
+// Transformation contexts of a single stylesheet which are kept after use
+// to avoid creating and initializing new ones for every transformation.
+// Each context is used by a single transformation at a time, so the
+// contexts of threads using the same stylesheet concurrently are distinct,
+// and nothing it contains is shared with the results of the previous ones.
+// Contexts are preferably reused by the thread which released them, to keep
+// their memory local to it.
+class context_pool
+{
+public:
+    context_pool();
+    ~context_pool() { clear(); }
+
+    // get a context for transforming the given document: either one of the
+    // pooled ones, reset for this document, or a new one
+    xsltTransformContextPtr acquire(xsltStylesheetPtr style, xmlDocPtr doc);
+
+    // return the context after the transformation, it's kept for reuse if it
+    // was successful and freed otherwise
+    void release(xsltTransformContextPtr ctxt, bool successful);
+
+    // free all the pooled contexts, this must be done before freeing the
+    // stylesheet they belong to
+    void clear();
+
+private:
+    struct idle_context
+    {
+        xsltTransformContextPtr ctxt;
+        unsigned long thread;
+    };
+
+    std::vector<idle_context> idle_;
+    xml::impl::mutex mutex_;
+
+    // the XPath context of a new transformation context starts in this
+    // state, which depends on the libxml2 version
+    int xpath_context_size_;
+    int xpath_proximity_position_;
+
+    context_pool(const context_pool&);
+    context_pool& operator=(const context_pool&);
+};
+
+} // end impl namespace
+
+} // end xslt namespace
+
+#endif // _xsltwrapp_context_pool_h_
@@ -0,0 +1,373 @@
+/*
+ * Copyright (C) 2001-2003 Peter J Jones (pjones@pmade.org)
+ * All Rights Reserved
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name of the Author nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ * USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/**
+    @file
+
+    This file contains the implementation of the xslt::document_loader class.
+ */
+
+// xmlwrapp includes
+#include "xsltwrapp/document_loader.h"
+#include "xmlwrapp/exception.h"
+
+#include "document_loader_impl.h"
+#include "stylesheet_impl.h"
+
+// libxslt includes
+#include <libxslt/documents.h>
+#include <libxslt/xsltInternals.h>
+
+// libxml includes
+#include <libxml/parser.h>
+#include <libxml/xinclude.h>
+#include <libxml/xpath.h>
+
+// standard includes
+#include <memory>
+#include <new>
+
+using xml::impl::atomic_add;
+using xml::impl::mutex;
+using xml::impl::mutex_lock;
+using xslt::impl::file_stamp;
+using xslt::impl::update_stamp;
+
+
+namespace
+{
+
+// the loader used by libxslt before install_hook() was called
+xsltDocLoaderFunc previous_loader = 0;
+mutex hook_mutex;
+
+
+extern "C"
+{
+
+static xmlDocPtr loader_cb(const xmlChar *uri,
+                           xmlDictPtr dict,
+                           int options,
+                           void *ctxt,
+                           xsltLoadType type)
+{
+    if (type == XSLT_LOAD_DOCUMENT && ctxt)
+    {
+        xsltTransformContextPtr tctxt = static_cast<xsltTransformContextPtr>(ctxt);
+        const xslt::stylesheet::pimpl *owner = 0;
+        if (tctxt->style)
+            owner = static_cast<const xslt::stylesheet::pimpl*>(tctxt->style->_private);
+
+        if (owner && owner->loader_)
+        {
+            try
+            {
+                xmlDocPtr doc = 0;
+                if (owner->loader_->load(uri, options, tctxt->xinclude != 0, doc))
+                    return doc;
+            }
+            catch (...)
+            {
+                return 0;
+            }
+        }
+    }
+
+    xmlDocPtr doc = previous_loader(uri, dict, options, ctxt, type);
+
+    // the EXSLT modules used only by the imported stylesheets must be
+    // registered before they are compiled too
+    if (doc && type == XSLT_LOAD_STYLESHEET)
+        xslt::impl::register_exslt(doc);
+
+    return doc;
+}
+
+} // extern "C"
+
+} // anonymous namespace
+
+
+// ------------------------------------------------------------------------
+// xslt::document_loader::pimpl
+// ------------------------------------------------------------------------
+
+void xslt::document_loader::pimpl::release(entry *e)
+{
+    if (atomic_add(e->refs_, -1) == 0)
+        delete e;
+}
+
+
+void xslt::document_loader::pimpl::release(entries_list& entries)
+{
+    for (std::size_t i = 0; i < entries.size(); ++i)
+        release(entries[i]);
+    entries.clear();
+}
+
+
+void xslt::document_loader::pimpl::insert(entry *e)
+{
+    mutex_lock lock(mutex_);
+
+    entry*& slot = entries_[e->uri_];
+    if (slot)
+        release(slot);
+    slot = e;
+}
+
+
+void xslt::document_loader::pimpl::erase(entry *e)
+{
+    mutex_lock lock(mutex_);
+
+    entries_map::iterator i = entries_.find(e->uri_);
+    if (i != entries_.end() && i->second == e)
+    {
+        entries_.erase(i);
+        release(e);
+    }
+}
+
+
+void xslt::document_loader::pimpl::clear()
+{
+    mutex_lock lock(mutex_);
+
+    for (entries_map::iterator i = entries_.begin(); i != entries_.end(); ++i)
+        release(i->second);
+    entries_.clear();
+}
+
+
+void xslt::document_loader::pimpl::attach(xsltTransformContextPtr ctxt,
+                                          entries_list& used)
+{
+    entries_list candidates;
+    {
+        mutex_lock lock(mutex_);
+
+        candidates.reserve(entries_.size());
+        for (entries_map::iterator i = entries_.begin(); i != entries_.end(); ++i)
+        {
+            atomic_add(i->second->refs_, 1);
+            candidates.push_back(i->second);
+        }
+    }
+
+    used.reserve(candidates.size());
+    for (std::size_t i = 0; i < candidates.size(); ++i)
+    {
+        entry *e = candidates[i];
+
+        // modified files are dropped here and loaded again if requested
+        if (e->has_file_)
+        {
+            file_stamp current;
+            current.path_ = e->file_.path_;
+            update_stamp(current);
+
+            if (!(current == e->file_))
+            {
+                erase(e);
+                release(e);
+                continue;
+            }
+        }
+
+        // libxslt looks for already loaded documents in this list before
+        // calling the loader; "main" documents are not freed by it
+        xsltDocumentPtr d = xsltNewDocument(ctxt, e->doc_);
+        if (!d)
+        {
+            release(e);
+            continue;
+        }
+
+        d->main = 1;
+        used.push_back(e);
+    }
+}
+
+
+bool xslt::document_loader::pimpl::load(const xmlChar *uri,
+                                        int options,
+                                        bool xinclude,
+                                        xmlDocPtr& doc)
+{
+    const std::string key(reinterpret_cast<const char*>(uri));
+
+    // the document may have been cached after the transformation started
+    entry *e = 0;
+    {
+        mutex_lock lock(mutex_);
+
+        entries_map::iterator i = entries_.find(key);
+        if (i != entries_.end())
+        {
+            e = i->second;
+            atomic_add(e->refs_, 1);
+        }
+    }
+
+    if (e)
+    {
+        bool up_to_date = true;
+        if (e->has_file_)
+        {
+            file_stamp current;
+            current.path_ = e->file_.path_;
+            update_stamp(current);
+            up_to_date = current == e->file_;
+        }
+
+        if (up_to_date)
+            doc = xmlCopyDoc(e->doc_, 1);
+        else
+            erase(e);
+
+        release(e);
+
+        if (up_to_date)
+            return true;
+    }
+
+    file_stamp stamp;
+    if (!impl::url_to_path(key.c_str(), stamp.path_))
+        return false;
+
+    // stat the file before loading it: if it's modified while we're
+    // parsing it, it will be loaded again the next time
+    update_stamp(stamp);
+    if (!stamp.exists_)
+        return false;
+
+    std::auto_ptr<entry> ap(new entry(key, 0));
+    ap->file_ = stamp;
+    ap->has_file_ = true;
+
+    // the cached document must not use the dictionary of the context, as
+    // it's going to outlive it
+    ap->doc_ = xmlReadFile(key.c_str(), 0, options);
+    if (!ap->doc_)
+    {
+        doc = 0;
+        return true;
+    }
+
+    // do this once now, as libxslt does for the documents it loads, so
+    // that the cached document is never modified afterwards
+    if (xinclude)
+        xmlXIncludeProcessFlags(ap->doc_, options);
+    xmlXPathOrderDocElems(ap->doc_);
+
+    doc = xmlCopyDoc(ap->doc_, 1);
+    insert(ap.release());
+
+    return true;
+}
+
+
+void xslt::document_loader::pimpl::install_hook()
+{
+    mutex_lock lock(hook_mutex);
+
+    if (previous_loader)
+        return;
+
+    previous_loader = xsltDocDefaultLoader;
+    xsltSetLoaderFunc(loader_cb);
+}
+
+
+// ------------------------------------------------------------------------
+// xslt::document_loader
+// ------------------------------------------------------------------------
+
+xslt::document_loader::document_loader() : pimpl_(new pimpl)
+{
+}
+
+
+xslt::document_loader::~document_loader()
+{
+    delete pimpl_;
+}
+
+
+void xslt::document_loader::preload(const char *uri, const xml::document& doc)
+{
+    xmlDocPtr source = static_cast<xmlDocPtr>(doc.get_doc_data_read_only());
+
+    std::auto_ptr<pimpl::entry> ap(new pimpl::entry(uri, 0));
+
+    xmlDocPtr copy = ap->doc_ = xmlCopyDoc(source, 1);
+    if (!copy)
+        throw std::bad_alloc();
+
+    // this is what libxslt compares the URI passed to document() with
+    if (copy->URL)
+        xmlFree(const_cast<xmlChar*>(copy->URL));
+    copy->URL = xmlStrdup(reinterpret_cast<const xmlChar*>(uri));
+
+    xmlXPathOrderDocElems(copy);
+
+    pimpl_->insert(ap.release());
+}
+
+
+bool xslt::document_loader::remove(const char *uri)
+{
+    mutex_lock lock(pimpl_->mutex_);
+
+    pimpl::entries_map::iterator i = pimpl_->entries_.find(uri);
+    if (i == pimpl_->entries_.end())
+        return false;
+
+    pimpl::release(i->second);
+    pimpl_->entries_.erase(i);
+    return true;
+}
+
+
+void xslt::document_loader::clear()
+{
+    pimpl_->clear();
+}
+
+
+std::size_t xslt::document_loader::size() const
+{
+    mutex_lock lock(pimpl_->mutex_);
+    return pimpl_->entries_.size();
+}
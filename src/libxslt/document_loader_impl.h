@@ -0,0 +1,100 @@
+/*
+ * Copyright (C) 2001-2003 Peter J Jones (pjones@pmade.org)
+ * All Rights Reserved
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name of the Author nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ * USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#ifndef _xsltwrapp_document_loader_impl_h_
+#define _xsltwrapp_document_loader_impl_h_
+
+// xmlwrapp includes
+#include "xsltwrapp/document_loader.h"
+
+#include "file_stamp.h"
+#include "../libxml/parallel.h"
+
+// libxslt includes
+#include <libxslt/xsltInternals.h>
+
+// standard includes
+#include <map>
+#include <string>
+#include <vector>
+
+struct xslt::document_loader::pimpl
+{
+    // a cached document: it is never modified after being added to the cache
+    // and is freed when the last transformation using it is done with it
+    struct entry
+    {
+        entry(const std::string& uri, xmlDocPtr doc)
+            : uri_(uri), doc_(doc), has_file_(false), refs_(1) { }
+        ~entry() { xmlFreeDoc(doc_); }
+
+        std::string uri_;
+        xmlDocPtr doc_;
+        impl::file_stamp file_;
+        bool has_file_;
+        volatile long refs_;
+    };
+
+    typedef std::map<std::string, entry*> entries_map;
+    typedef std::vector<entry*> entries_list;
+
+    ~pimpl() { clear(); }
+
+    static void release(entry *e);
+    static void release(entries_list& entries);
+
+    // add the entry to the cache, replacing any existing one for its URI
+    void insert(entry *e);
+
+    // remove the entry from the cache unless it was already replaced
+    void erase(entry *e);
+
+    void clear();
+
+    // add all the cached documents that are still up to date to the list of
+    // documents known to the transformation context and return them in the
+    // given list, which must be released after freeing the context
+    void attach(xsltTransformContextPtr ctxt, entries_list& used);
+
+    // load the document for libxslt, which takes ownership of it; returns
+    // false if the document can't be cached, i.e. it is not a local file
+    bool load(const xmlChar *uri, int options, bool xinclude, xmlDocPtr& doc);
+
+    // make libxslt use load() for the stylesheets using some loader, this
+    // hook is also used for registering EXSLT modules on demand
+    static void install_hook();
+
+    entries_map entries_;
+    mutable xml::impl::mutex mutex_;
+};
+
+#endif // _xsltwrapp_document_loader_impl_h_
@@ -0,0 +1,375 @@
+/*
+ * Copyright (C) 2001-2003 Peter J Jones (pjones@pmade.org)
+ * All Rights Reserved
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name of the Author nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ * USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/**
+    @file
+
+    This file contains the implementation of the xslt::extension_call class
+    and of the glue between libxslt and xslt::extension_function.
+ */
+
+// xmlwrapp includes
+#include "xsltwrapp/extension_function.h"
+#include "xmlwrapp/exception.h"
+
+#include "stylesheet_impl.h"
+#include "../libxml/utility.h"
+
+// libxslt includes
+#include <libxslt/xsltInternals.h>
+#include <libxslt/extensions.h>
+#include <libxslt/transform.h>
+#include <libxslt/variables.h>
+#include <libxslt/xsltutils.h>
+
+// libxml includes
+#include <libxml/xpath.h>
+#include <libxml/xpathInternals.h>
+
+// standard includes
+#include <string>
+#include <vector>
+
+
+// ------------------------------------------------------------------------
+// xslt::extension_call::pimpl
+// ------------------------------------------------------------------------
+
+struct xslt::extension_call::pimpl
+{
+    // takes the arguments of the current function call from the XPath stack
+    pimpl(xmlXPathParserContextPtr ctxt, int nargs)
+        : ctxt_(ctxt), result_(0), container_(0)
+    {
+        args_.resize(nargs);
+        for (int i = nargs - 1; i >= 0; --i)
+            args_[i] = valuePop(ctxt_);
+    }
+
+    ~pimpl()
+    {
+        for (std::size_t i = 0; i < args_.size(); ++i)
+            xmlXPathFreeObject(args_[i]);
+
+        if (result_)
+            xmlXPathFreeObject(result_);
+    }
+
+    xmlXPathObjectPtr get_arg(std::size_t arg) const
+    {
+        if (arg >= args_.size() || !args_[arg])
+            throw xml::exception("invalid extension function argument index");
+        return args_[arg];
+    }
+
+    static xmlNodeSetPtr get_node_set(xmlXPathObjectPtr obj)
+    {
+        if (obj->type != XPATH_NODESET && obj->type != XPATH_XSLT_TREE)
+            return 0;
+        return obj->nodesetval;
+    }
+
+    xmlNodePtr get_node(std::size_t arg, std::size_t index) const
+    {
+        xmlNodeSetPtr set = get_node_set(get_arg(arg));
+        if (!set || index >= static_cast<std::size_t>(set->nodeNr))
+            throw xml::exception("invalid extension function node index");
+        return set->nodeTab[index];
+    }
+
+    void set_result(xmlXPathObjectPtr obj)
+    {
+        if (!obj)
+            throw std::bad_alloc();
+
+        if (result_)
+            xmlXPathFreeObject(result_);
+        result_ = obj;
+    }
+
+    // get the node set result, creating it if necessary
+    xmlNodeSetPtr get_result_nodes()
+    {
+        if (!result_ || result_->type != XPATH_NODESET || !result_->nodesetval)
+            set_result(xmlXPathNewNodeSet(0));
+        return result_->nodesetval;
+    }
+
+    // copy the node into a result tree fragment owned by the transformation
+    xmlNodePtr copy_node(xmlNodePtr node)
+    {
+        if (!container_)
+        {
+            xsltTransformContextPtr tctxt = xsltXPathGetTransformContext(ctxt_);
+            if ( !tctxt || (container_ = xsltCreateRVT(tctxt)) == 0)
+                throw std::bad_alloc();
+            xsltRegisterLocalRVT(tctxt, container_);
+        }
+
+        xmlNodePtr copy = xmlDocCopyNode(node, container_, 1);
+        if (!copy)
+            throw std::bad_alloc();
+        xmlAddChild(reinterpret_cast<xmlNodePtr>(container_), copy);
+
+        return copy;
+    }
+
+    // push the result on the XPath stack, giving up its ownership
+    void push_result()
+    {
+        if (!result_)
+            result_ = xmlXPathNewCString("");
+        else if (result_->type == XPATH_NODESET && result_->nodesetval)
+            xmlXPathNodeSetSort(result_->nodesetval);
+
+        valuePush(ctxt_, result_);
+        result_ = 0;
+    }
+
+    static void invoke(xmlXPathParserContextPtr ctxt, int nargs);
+
+    xmlXPathParserContextPtr ctxt_;
+    std::vector<xmlXPathObjectPtr> args_;
+    xmlXPathObjectPtr result_;
+    xmlDocPtr container_;
+};
+
+
+void xslt::extension_call::pimpl::invoke(xmlXPathParserContextPtr ctxt, int nargs)
+{
+    pimpl impl(ctxt, nargs);
+
+    const xmlChar *uri = ctxt->context->functionURI;
+    const xmlChar *name = ctxt->context->function;
+
+    xsltTransformContextPtr tctxt = xsltXPathGetTransformContext(ctxt);
+    const stylesheet::pimpl *owner = 0;
+    if (tctxt && tctxt->style)
+        owner = static_cast<const stylesheet::pimpl*>(tctxt->style->_private);
+
+    extension_function *func = owner ? owner->find_function(uri, name) : 0;
+
+    std::string error;
+    try
+    {
+        if (!func)
+            throw xml::exception("extension function is not registered");
+
+        extension_call call(&impl);
+        func->execute(call);
+        impl.push_result();
+        return;
+    }
+    catch (std::exception& e)
+    {
+        error = e.what();
+    }
+    catch (...)
+    {
+        error = "unknown error";
+    }
+
+    // this stops the transformation and makes it fail with this message
+    xsltTransformError(tctxt, 0, tctxt ? tctxt->inst : 0,
+                       "extension function {%s}%s failed: %s\n",
+                       uri ? reinterpret_cast<const char*>(uri) : "",
+                       reinterpret_cast<const char*>(name),
+                       error.c_str());
+    ctxt->error = XPATH_EXPR_ERROR;
+}
+
+
+namespace
+{
+
+extern "C"
+{
+
+static void extension_function_cb(xmlXPathParserContextPtr ctxt, int nargs)
+{
+    xslt::extension_call::pimpl::invoke(ctxt, nargs);
+}
+
+} // extern "C"
+
+} // anonymous namespace
+
+
+namespace xslt
+{
+
+// ------------------------------------------------------------------------
+// xslt::extension_call
+// ------------------------------------------------------------------------
+
+std::size_t extension_call::size() const
+{
+    return pimpl_->args_.size();
+}
+
+
+extension_call::value_type extension_call::get_type(std::size_t arg) const
+{
+    switch (pimpl_->get_arg(arg)->type)
+    {
+        case XPATH_NODESET:
+        case XPATH_XSLT_TREE:
+            return type_node_set;
+        case XPATH_BOOLEAN:
+            return type_boolean;
+        case XPATH_NUMBER:
+            return type_number;
+        case XPATH_STRING:
+            return type_string;
+        default:
+            return type_other;
+    }
+}
+
+
+std::string extension_call::get_string(std::size_t arg) const
+{
+    xmlXPathObjectPtr obj = pimpl_->get_arg(arg);
+
+    // strings don't need to be converted nor copied twice
+    if (obj->type == XPATH_STRING)
+        return obj->stringval ? reinterpret_cast<const char*>(obj->stringval) : "";
+
+    xml::impl::xmlchar_helper value(xmlXPathCastToString(obj));
+    return value.get() ? value.get() : "";
+}
+
+
+double extension_call::get_number(std::size_t arg) const
+{
+    return xmlXPathCastToNumber(pimpl_->get_arg(arg));
+}
+
+
+bool extension_call::get_boolean(std::size_t arg) const
+{
+    return xmlXPathCastToBoolean(pimpl_->get_arg(arg)) != 0;
+}
+
+
+std::size_t extension_call::get_node_count(std::size_t arg) const
+{
+    xmlNodeSetPtr set = pimpl::get_node_set(pimpl_->get_arg(arg));
+    return set ? set->nodeNr : 0;
+}
+
+
+std::string extension_call::get_node_string(std::size_t arg, std::size_t index) const
+{
+    xml::impl::xmlchar_helper value(xmlXPathCastNodeToString(pimpl_->get_node(arg, index)));
+    return value.get() ? value.get() : "";
+}
+
+
+void extension_call::return_string(const std::string& value)
+{
+    pimpl_->set_result(xmlXPathNewCString(value.c_str()));
+}
+
+
+void extension_call::return_number(double value)
+{
+    pimpl_->set_result(xmlXPathNewFloat(value));
+}
+
+
+void extension_call::return_boolean(bool value)
+{
+    pimpl_->set_result(xmlXPathNewBoolean(value ? 1 : 0));
+}
+
+
+void extension_call::add_result_node(const xml::node& n)
+{
+    xmlNodePtr node = static_cast<xmlNodePtr>(xml::node::raw_node(n));
+    xmlNodeSetPtr set = pimpl_->get_result_nodes();
+    xmlXPathNodeSetAddUnique(set, pimpl_->copy_node(node));
+}
+
+
+void extension_call::add_result_node(std::size_t arg, std::size_t index)
+{
+    xmlNodePtr node = pimpl_->get_node(arg, index);
+    xmlXPathNodeSetAdd(pimpl_->get_result_nodes(), node);
+}
+
+
+namespace impl
+{
+
+void register_functions(xsltTransformContextPtr ctxt, xsltStylesheetPtr style)
+{
+    const stylesheet::pimpl *owner = static_cast<const stylesheet::pimpl*>(style->_private);
+    if (!owner)
+        return;
+
+    stylesheet::pimpl::functions_type::const_iterator
+        i = owner->functions_.begin(), end = owner->functions_.end();
+    for (; i != end; ++i)
+    {
+        xsltRegisterExtFunction(ctxt,
+                                reinterpret_cast<const xmlChar*>(i->name_.c_str()),
+                                reinterpret_cast<const xmlChar*>(i->uri_.c_str()),
+                                extension_function_cb);
+    }
+}
+
+} // end impl namespace
+
+} // end xslt namespace
+
+
+// ------------------------------------------------------------------------
+// xslt::stylesheet::pimpl
+// ------------------------------------------------------------------------
+
+xslt::extension_function*
+xslt::stylesheet::pimpl::find_function(const xmlChar *uri,
+                                       const xmlChar *name) const
+{
+    functions_type::const_iterator i = functions_.begin(), end = functions_.end();
+    for (; i != end; ++i)
+    {
+        if (xmlStrEqual(reinterpret_cast<const xmlChar*>(i->name_.c_str()), name) &&
+            xmlStrEqual(reinterpret_cast<const xmlChar*>(i->uri_.c_str()), uri))
+        {
+            return i->func_;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,98 @@
+/*
+ * Copyright (C) 2001-2003 Peter J Jones (pjones@pmade.org)
+ * All Rights Reserved
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name of the Author nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ * USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include "file_stamp.h"
+
+// libxml includes
+#include <libxml/uri.h>
+#include <libxml/xmlmemory.h>
+
+// standard includes
+#include <cstring>
+
+#include <sys/types.h>
+#include <sys/stat.h>
+
+namespace xslt
+{
+
+namespace impl
+{
+
+bool url_to_path(const char *url, std::string& path)
+{
+    if (std::strncmp(url, "file://", 7) != 0)
+    {
+        if (std::strstr(url, "://") != 0)
+            return false;
+
+        path = url;
+        return true;
+    }
+
+    url += 7;
+    if (std::strncmp(url, "localhost/", 10) == 0)
+        url += 9;
+
+#ifdef _WIN32
+    // file:///C:/foo
+    if (url[0] == '/' && url[1] != '\0' && url[2] == ':')
+        ++url;
+#endif
+
+    char *unescaped = xmlURIUnescapeString(url, 0, NULL);
+    if (!unescaped)
+        return false;
+
+    path = unescaped;
+    xmlFree(unescaped);
+    return true;
+}
+
+
+void update_stamp(file_stamp& stamp)
+{
+#ifdef _WIN32
+    struct _stat st;
+    stamp.exists_ = _stat(stamp.path_.c_str(), &st) == 0;
+#else
+    struct stat st;
+    stamp.exists_ = stat(stamp.path_.c_str(), &st) == 0;
+#endif
+
+    stamp.mtime_ = stamp.exists_ ? st.st_mtime : 0;
+    stamp.size_ = stamp.exists_ ? static_cast<long>(st.st_size) : 0;
+}
+
+} // end impl namespace
+
+} // end xslt namespace
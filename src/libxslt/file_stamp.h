@@ -0,0 +1,75 @@
+/*
+ * Copyright (C) 2001-2003 Peter J Jones (pjones@pmade.org)
+ * All Rights Reserved
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name of the Author nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ * USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#ifndef _xsltwrapp_file_stamp_h_
+#define _xsltwrapp_file_stamp_h_
+
+// standard includes
+#include <ctime>
+#include <string>
+
+namespace xslt
+{
+
+namespace impl
+{
+
+// state of a file used by a cached object, for detecting its modifications
+struct file_stamp
+{
+    file_stamp() : exists_(false), mtime_(0), size_(0) { }
+
+    bool operator==(const file_stamp& other) const
+    {
+        return exists_ == other.exists_ &&
+               mtime_ == other.mtime_ &&
+               size_ == other.size_;
+    }
+
+    std::string path_;
+    bool exists_;
+    std::time_t mtime_;
+    long size_;
+};
+
+// get the path of a local file from the URL of a document, returns false
+// for non-local URLs
+bool url_to_path(const char *url, std::string& path);
+
+// fill in the state of the file with the path given in the stamp
+void update_stamp(file_stamp& stamp);
+
+} // end impl namespace
+
+} // end xslt namespace
+
+#endif // _xsltwrapp_file_stamp_h_
@@ -37,6 +37,10 @@
  */
 
 #include "xsltwrapp/init.h"
+#include "stylesheet_impl.h"
+#include "document_loader_impl.h"
+#include "../libxml/parallel.h"
+#include "../libxml/utility.h"
 
 #include <libxslt/xslt.h>
 #include <libxslt/xsltInternals.h>
@@ -44,59 +48,231 @@
 #include <libxslt/xsltutils.h>
 #include <libexslt/exslt.h>
 
+#include <cstdarg>
+#include <cstddef>
+
 extern "C"
 {
 
-static void xslt_error(void *, const char*, ...)
+static void xslt_error(void *, const char *message, ...)
 {
-    // don't do anything; we install context-specific error handler to
-    // catch errors while applying a stylesheet
+    // we install context-specific error handler to catch errors while
+    // applying a stylesheet, the other ones are only kept for
+    // xml::error_capture
+    va_list ap;
+    va_start(ap, message);
+    try
+    {
+        xml::impl::capture_message(XML_FROM_XSLT, message, ap);
+    }
+    catch (...) {}
+    va_end(ap);
+}
+
+static void xslt_debug(void *, const char*, ...)
+{
+    // don't do anything
 }
 
 } // extern "C"
 
 
-int xslt::init::ms_counter = 0;
+namespace
+{
+
+// see the comments in src/libxml/init.cxx
+volatile long g_lock = 0;
+long g_counter = 0;
+volatile long g_initialized = 0;
 
 
-xslt::init::init()
+// EXSLT modules and the functions registering them with libxslt
+struct exslt_module_info
 {
-    if ( ms_counter++ == 0 )
-        init_library();
-}
+    int module;
+    const xmlChar *ns;
+    void (*register_module)();
+};
+
+const exslt_module_info exslt_modules_info[] =
+{
+    { xslt::init::exslt_common,    EXSLT_COMMON_NAMESPACE,    exsltCommonRegister },
+    { xslt::init::exslt_math,      EXSLT_MATH_NAMESPACE,      exsltMathRegister },
+    { xslt::init::exslt_sets,      EXSLT_SETS_NAMESPACE,      exsltSetsRegister },
+    { xslt::init::exslt_functions, EXSLT_FUNCTIONS_NAMESPACE, exsltFuncRegister },
+    { xslt::init::exslt_strings,   EXSLT_STRINGS_NAMESPACE,   exsltStrRegister },
+    { xslt::init::exslt_dates,     EXSLT_DATE_NAMESPACE,      exsltDateRegister },
+    { xslt::init::exslt_dynamic,   EXSLT_DYNAMIC_NAMESPACE,   exsltDynRegister },
+    { xslt::init::exslt_saxon,     SAXON_NAMESPACE,           exsltSaxonRegister },
+    { xslt::init::exslt_crypto,    EXSLT_CRYPTO_NAMESPACE,    exsltCryptoRegister }
+};
 
+const std::size_t exslt_modules_count =
+    sizeof(exslt_modules_info) / sizeof(exslt_modules_info[0]);
 
-xslt::init::~init(void)
+// protects the variables below, which are set by xslt::init and used when
+// creating the stylesheets
+volatile long g_exslt_lock = 0;
+int g_exslt_enabled = xslt::init::exslt_all;
+bool g_exslt_on_demand = false;
+int g_exslt_registered = 0;
+
+
+// return the EXSLT modules whose namespace is declared in the document
+int find_exslt_modules(xmlDocPtr doc)
 {
-    if ( --ms_counter == 0 )
-        shutdown_library();
+    int modules = 0;
+
+    xmlNodePtr node = xmlDocGetRootElement(doc);
+    while (node)
+    {
+        if (node->type == XML_ELEMENT_NODE)
+        {
+            for (xmlNsPtr ns = node->nsDef; ns; ns = ns->next)
+            {
+                for (std::size_t i = 0; i < exslt_modules_count; ++i)
+                {
+                    if (xmlStrEqual(ns->href, exslt_modules_info[i].ns))
+                        modules |= exslt_modules_info[i].module;
+                }
+            }
+
+            if (node->children)
+            {
+                node = node->children;
+                continue;
+            }
+        }
+
+        while (node && !node->next)
+        {
+            node = node->parent;
+            if (node && node->type == XML_DOCUMENT_NODE)
+                node = 0;
+        }
+        if (node)
+            node = node->next;
+    }
+
+    return modules;
 }
 
 
-void xslt::init::init_library()
+// must be called with the lock held
+void init_library()
 {
     xsltInit();
 
     // set some defautls
-    process_xincludes(true);
+    xsltSetXIncludeDefault(1);
 
     // keep libxslt silent; we install context-specific error handler to
     // catch errors while applying a stylesheet
     xsltSetGenericErrorFunc(0, xslt_error);
-    xsltSetGenericDebugFunc(0, xslt_error);
+    xsltSetGenericDebugFunc(0, xslt_debug);
 
-    // load EXSLT
-    exsltRegisterAll();
+    // EXSLT modules are registered only when creating the stylesheets, see
+    // xslt::impl::register_exslt()
+
+    // the first call to xsltTimestamp() initializes its static state, do it
+    // now, before it can be used by several threads for the time limits
+    xsltTimestamp();
+
+    xml::impl::atomic_add(g_initialized, 1);
 }
 
 
-void xslt::init::shutdown_library()
+// must be called with the lock held
+void shutdown_library()
 {
+    xml::impl::atomic_add(g_initialized, -1);
+
+    // this unregisters all the extension modules as well
     xsltCleanupGlobals();
+
+    xml::impl::static_lock lock(g_exslt_lock);
+    g_exslt_registered = 0;
+}
+
+} // anonymous namespace
+
+
+void xslt::impl::ensure_initialized()
+{
+    xml::impl::ensure_initialized();
+
+    if (xml::impl::atomic_add(g_initialized, 0))
+        return;
+
+    // as for xml::init, this reference to the library is never released
+    xml::impl::static_lock lock(g_lock);
+    if (g_counter == 0)
+    {
+        g_counter = 1;
+        init_library();
+    }
+}
+
+
+xslt::init::init()
+{
+    xml::impl::static_lock lock(g_lock);
+    if (g_counter++ == 0)
+        init_library();
+}
+
+
+xslt::init::~init()
+{
+    xml::impl::static_lock lock(g_lock);
+    if (--g_counter == 0)
+        shutdown_library();
 }
 
 
 void xslt::init::process_xincludes(bool flag)
 {
+    impl::ensure_initialized();
     xsltSetXIncludeDefault(flag ? 1 : 0);
 }
+
+
+void xslt::impl::register_exslt(xmlDocPtr style_doc)
+{
+    xml::impl::static_lock lock(g_exslt_lock);
+
+    int modules = g_exslt_enabled & ~g_exslt_registered;
+    if (!modules)
+        return;
+
+    if (g_exslt_on_demand)
+        modules &= find_exslt_modules(style_doc);
+
+    for (std::size_t i = 0; i < exslt_modules_count; ++i)
+    {
+        if (modules & exslt_modules_info[i].module)
+            exslt_modules_info[i].register_module();
+    }
+
+    g_exslt_registered |= modules;
+}
+
+
+void xslt::init::exslt_modules(int modules)
+{
+    xml::impl::static_lock lock(g_exslt_lock);
+    g_exslt_enabled = modules & exslt_all;
+}
+
+
+void xslt::init::exslt_on_demand(bool flag)
+{
+    if (flag)
+    {
+        // imported and included stylesheets need to be checked too
+        document_loader::pimpl::install_hook();
+    }
+
+    xml::impl::static_lock lock(g_exslt_lock);
+    g_exslt_on_demand = flag;
+}
@@ -0,0 +1,185 @@
+/*
+ * Copyright (C) 2001-2003 Peter J Jones (pjones@pmade.org)
+ * All Rights Reserved
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name of the Author nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ * USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/**
+    @file
+
+    This file contains the implementation of the xslt::params class.
+ */
+
+// xmlwrapp includes
+#include "xsltwrapp/params.h"
+#include "xmlwrapp/exception.h"
+
+#include "params_impl.h"
+
+// libxml includes
+#include <libxml/xpath.h>
+
+// standard includes
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+
+// if the expression is just a string literal, return its value
+bool get_string_literal(const char *expr, std::string& value)
+{
+    while (*expr == ' ' || *expr == '\t' || *expr == '\r' || *expr == '\n')
+        ++expr;
+
+    const char quote = *expr;
+    if (quote != '\'' && quote != '"')
+        return false;
+
+    const char *end = std::strchr(expr + 1, quote);
+    if (!end)
+        return false;
+
+    for (const char *p = end + 1; *p; ++p)
+    {
+        if (*p != ' ' && *p != '\t' && *p != '\r' && *p != '\n')
+            return false;
+    }
+
+    value.assign(expr + 1, end);
+    return true;
+}
+
+} // anonymous namespace
+
+
+xslt::params::params()
+{
+    pimpl_ = new pimpl;
+}
+
+
+xslt::params::params(const std::map<std::string, std::string>& p)
+{
+    pimpl_ = new pimpl;
+
+    try
+    {
+        std::map<std::string, std::string>::const_iterator i = p.begin(), end = p.end();
+        for (; i != end; ++i)
+            set(i->first.c_str(), i->second.c_str());
+    }
+    catch (...)
+    {
+        delete pimpl_;
+        throw;
+    }
+}
+
+
+xslt::params::params(const params& other)
+{
+    pimpl_ = new pimpl(*other.pimpl_);
+}
+
+
+xslt::params& xslt::params::operator=(const params& other)
+{
+    params tmp(other);
+    swap(tmp);
+    return *this;
+}
+
+
+void xslt::params::swap(params& other)
+{
+    std::swap(pimpl_, other.pimpl_);
+}
+
+
+xslt::params::~params()
+{
+    delete pimpl_;
+}
+
+
+void xslt::params::set(const char *name, const char *expr)
+{
+    std::string value;
+    if (get_string_literal(expr, value))
+    {
+        set_string(name, value.c_str());
+        return;
+    }
+
+    xmlXPathCompExprPtr comp = xmlXPathCompile(reinterpret_cast<const xmlChar*>(expr));
+    if (!comp)
+        throw xml::exception(std::string("invalid XPath expression for parameter ") + name + ": " + expr);
+    xmlXPathFreeCompExpr(comp);
+
+    pimpl_->strings_.erase(name);
+    pimpl_->xpath_[name] = expr;
+    pimpl_->update_xpath_array();
+}
+
+
+void xslt::params::set_string(const char *name, const char *value)
+{
+    if (pimpl_->xpath_.erase(name))
+        pimpl_->update_xpath_array();
+    pimpl_->strings_[name] = value;
+}
+
+
+void xslt::params::erase(const char *name)
+{
+    if (pimpl_->xpath_.erase(name))
+        pimpl_->update_xpath_array();
+    pimpl_->strings_.erase(name);
+}
+
+
+void xslt::params::clear()
+{
+    pimpl_->xpath_.clear();
+    pimpl_->strings_.clear();
+    pimpl_->update_xpath_array();
+}
+
+
+std::size_t xslt::params::size() const
+{
+    return pimpl_->xpath_.size() + pimpl_->strings_.size();
+}
+
+
+bool xslt::params::empty() const
+{
+    return size() == 0;
+}
@@ -0,0 +1,88 @@
+/*
+ * Copyright (C) 2001-2003 Peter J Jones (pjones@pmade.org)
+ * All Rights Reserved
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name of the Author nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ * USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#ifndef _xsltwrapp_params_impl_h_
+#define _xsltwrapp_params_impl_h_
+
+// xmlwrapp includes
+#include "xsltwrapp/params.h"
+
+// standard includes
+#include <map>
+#include <string>
+#include <vector>
+
+// The parameters in the form used by libxslt: the XPath expressions are kept
+// in the NULL-terminated array of alternating names and values expected by
+// xsltApplyStylesheetUser(), which is rebuilt whenever they change, and the
+// string values are given to xsltQuoteOneUserParam() one by one.
+struct xslt::params::pimpl
+{
+    typedef std::map<std::string, std::string> values_map;
+
+    pimpl() { update_xpath_array(); }
+
+    pimpl(const pimpl& other)
+        : xpath_(other.xpath_), strings_(other.strings_)
+    {
+        update_xpath_array();
+    }
+
+    void update_xpath_array()
+    {
+        xpath_array_.clear();
+        xpath_array_.reserve(2 * xpath_.size() + 1);
+
+        for (values_map::const_iterator i = xpath_.begin(); i != xpath_.end(); ++i)
+        {
+            xpath_array_.push_back(i->first.c_str());
+            xpath_array_.push_back(i->second.c_str());
+        }
+
+        xpath_array_.push_back(0);
+    }
+
+    // NULL if there are no XPath parameters at all
+    const char** get_xpath_array() const
+    {
+        return xpath_.empty() ? 0 : const_cast<const char**>(&xpath_array_[0]);
+    }
+
+    values_map xpath_;
+    values_map strings_;
+    std::vector<const char*> xpath_array_;
+
+private:
+    pimpl& operator=(const pimpl&);
+};
+
+#endif // _xsltwrapp_params_impl_h_
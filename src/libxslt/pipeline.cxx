@@ -0,0 +1,192 @@
+/*
+ * Copyright (C) 2001-2003 Peter J Jones (pjones@pmade.org)
+ * All Rights Reserved
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name of the Author nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ * USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/**
+    @file
+
+    This file contains the implementation of the xslt::pipeline class.
+ */
+
+// xmlwrapp includes
+#include "xsltwrapp/pipeline.h"
+
+#include "stylesheet_impl.h"
+
+// libxslt includes
+#include <libxslt/xsltutils.h>
+
+// standard includes
+#include <sstream>
+#include <vector>
+
+using namespace xslt::impl;
+
+
+struct xslt::pipeline::pimpl
+{
+    struct stage
+    {
+        stage(const stylesheet *style, const params& with_params)
+            : style_(style), params_(with_params) { }
+
+        const stylesheet *style_;
+        params params_;
+    };
+
+    transform_result run(const xml::document& doc,
+                         std::ostream *stream,
+                         std::vector<double> *stage_times) const;
+
+    std::vector<stage> stages_;
+};
+
+
+xslt::transform_result
+xslt::pipeline::pimpl::run(const xml::document& doc,
+                           std::ostream *stream,
+                           std::vector<double> *stage_times) const
+{
+    transform_result result;
+
+    if (stage_times)
+        stage_times->clear();
+
+    if (stages_.empty())
+    {
+        result.pimpl_->error_ = "XSLT pipeline has no stages";
+        return result;
+    }
+
+    xmlDocPtr input = static_cast<xmlDocPtr>(doc.get_doc_data_read_only());
+    xmlDocPtr intermediate = 0;
+
+    for (std::size_t i = 0; i < stages_.size(); ++i)
+    {
+        xsltStylesheetPtr style = stages_[i].style_->pimpl_->ss_;
+        const params::pimpl *compiled = stages_[i].params_.pimpl_;
+        std::string& error = result.pimpl_->error_;
+
+        const long start = xsltTimestamp();
+
+        xmlDocPtr output;
+        if (stream && i == stages_.size() - 1)
+        {
+            output = transform_to_output(style, input, NULL, compiled,
+                                         create_ostream_output(*stream, style),
+                                         error);
+        }
+        else
+        {
+            output = apply_stylesheet(style, input, error, NULL, compiled);
+        }
+
+        if (stage_times)
+        {
+            stage_times->push_back(static_cast<double>(xsltTimestamp() - start) /
+                                   XSLT_TIMESTAMP_TICS_PER_SEC);
+        }
+
+        // the previous intermediate result is not needed any more
+        if (intermediate)
+            xmlFreeDoc(intermediate);
+
+        if (!output)
+        {
+            std::ostringstream msg;
+            msg << "XSLT pipeline stage " << i + 1 << " failed: " << error;
+            error = msg.str();
+            return result;
+        }
+
+        input = intermediate = output;
+    }
+
+    if (stream)
+    {
+        xmlFreeDoc(intermediate);
+    }
+    else
+    {
+        result.pimpl_->doc_.set_doc_data_from_xslt(
+            intermediate, make_result(intermediate, stages_.back().style_->pimpl_->ss_));
+    }
+
+    result.pimpl_->ok_ = true;
+    return result;
+}
+
+
+xslt::pipeline::pipeline()
+{
+    pimpl_ = new pimpl;
+}
+
+
+xslt::pipeline::~pipeline()
+{
+    delete pimpl_;
+}
+
+
+void xslt::pipeline::add_stage(const stylesheet& style)
+{
+    pimpl_->stages_.push_back(pimpl::stage(&style, params()));
+}
+
+
+void xslt::pipeline::add_stage(const stylesheet& style, const params& with_params)
+{
+    pimpl_->stages_.push_back(pimpl::stage(&style, with_params));
+}
+
+
+std::size_t xslt::pipeline::size() const
+{
+    return pimpl_->stages_.size();
+}
+
+
+xslt::transform_result
+xslt::pipeline::run(const xml::document& doc,
+                    std::vector<double> *stage_times) const
+{
+    return pimpl_->run(doc, NULL, stage_times);
+}
+
+
+xslt::transform_result
+xslt::pipeline::run_to(const xml::document& doc,
+                       std::ostream& stream,
+                       std::vector<double> *stage_times) const
+{
+    return pimpl_->run(doc, &stream, stage_times);
+}
@@ -0,0 +1,60 @@
+/*
+ * Copyright (C) 2001-2003 Peter J Jones (pjones@pmade.org)
+ * All Rights Reserved
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name of the Author nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ * USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#ifndef _xsltwrapp_profile_impl_h_
+#define _xsltwrapp_profile_impl_h_
+
+// xmlwrapp includes
+#include "xsltwrapp/profile_report.h"
+
+// libxslt includes
+#include <libxslt/xsltInternals.h>
+
+// libxslt keeps the profiling counters in the templates of the stylesheet
+// itself, so only one profiled transformation may run with a given
+// stylesheet at any time and the counters must be reset before it starts.
+struct xslt::profile_report::pimpl
+{
+    pimpl() : total_time_(0) { }
+
+    // reset the counters of all templates of the stylesheet and its imports
+    static void reset_counters(xsltStylesheetPtr style);
+
+    // fill this report from the counters of the stylesheet, total_ticks is
+    // the duration of the whole transformation as given by xsltTimestamp()
+    void collect(xsltStylesheetPtr style, long total_ticks);
+
+    templates_type templates_;
+    double total_time_;
+};
+
+#endif // _xsltwrapp_profile_impl_h_
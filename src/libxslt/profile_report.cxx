@@ -0,0 +1,260 @@
+/*
+ * Copyright (C) 2001-2003 Peter J Jones (pjones@pmade.org)
+ * All Rights Reserved
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name of the Author nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ * USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/**
+    @file
+
+    This file contains the implementation of the xslt::profile_report class.
+ */
+
+// xmlwrapp includes
+#include "xsltwrapp/profile_report.h"
+
+#include "profile_impl.h"
+
+// libxslt includes
+#include <libxslt/imports.h>
+#include <libxslt/xsltutils.h>
+
+// standard includes
+#include <algorithm>
+#include <map>
+#include <utility>
+#include <vector>
+
+namespace
+{
+
+double ticks_to_seconds(long ticks)
+{
+    return static_cast<double>(ticks) / XSLT_TIMESTAMP_TICS_PER_SEC;
+}
+
+
+std::string to_string(const xmlChar *s)
+{
+    return s ? std::string(reinterpret_cast<const char*>(s)) : std::string();
+}
+
+
+// The call graph of the templates called during the transformation, built
+// from the callers libxslt records for each template.
+class call_graph
+{
+public:
+    explicit call_graph(const std::vector<xsltTemplatePtr>& templates)
+        : templates_(templates),
+          callees_(templates.size()),
+          external_calls_(templates.size(), 0),
+          total_(templates.size(), 0.0),
+          state_(templates.size(), not_visited)
+    {
+        std::map<xsltTemplatePtr, std::size_t> index;
+        for (std::size_t i = 0; i < templates_.size(); ++i)
+            index[templates_[i]] = i;
+
+        for (std::size_t i = 0; i < templates_.size(); ++i)
+        {
+            xsltTemplatePtr templ = templates_[i];
+            for (int n = 0; n < templ->templNr; ++n)
+            {
+                xsltTemplatePtr caller = templ->templCalledTab[n];
+                const unsigned long count = templ->templCountTab[n];
+
+                if (caller == templ)
+                    continue;
+
+                external_calls_[i] += count;
+
+                std::map<xsltTemplatePtr, std::size_t>::const_iterator
+                    c = index.find(caller);
+                if (c != index.end())
+                    callees_[c->second].push_back(std::make_pair(i, count));
+            }
+        }
+    }
+
+    // Inclusive time of the template: its own time plus the share of the
+    // inclusive time of every template it called corresponding to the
+    // fraction of calls made by it. Calls closing a cycle are ignored.
+    double get_total_time(std::size_t i)
+    {
+        if (state_[i] == done)
+            return total_[i];
+        if (state_[i] == in_progress)
+            return 0;
+
+        state_[i] = in_progress;
+
+        double total = ticks_to_seconds(templates_[i]->time);
+
+        std::vector<std::pair<std::size_t, unsigned long> >::const_iterator
+            c = callees_[i].begin(), end = callees_[i].end();
+        for (; c != end; ++c)
+        {
+            if (external_calls_[c->first])
+            {
+                total += get_total_time(c->first) * c->second /
+                            external_calls_[c->first];
+            }
+        }
+
+        state_[i] = done;
+        total_[i] = total;
+        return total;
+    }
+
+private:
+    enum visit_state { not_visited, in_progress, done };
+
+    const std::vector<xsltTemplatePtr>& templates_;
+    std::vector<std::vector<std::pair<std::size_t, unsigned long> > > callees_;
+    std::vector<unsigned long> external_calls_;
+    std::vector<double> total_;
+    std::vector<visit_state> state_;
+};
+
+
+bool by_self_time(const xslt::profile_report::template_info& a,
+                  const xslt::profile_report::template_info& b)
+{
+    return a.self_time > b.self_time;
+}
+
+} // anonymous namespace
+
+
+// ------------------------------------------------------------------------
+// xslt::profile_report::pimpl
+// ------------------------------------------------------------------------
+
+void xslt::profile_report::pimpl::reset_counters(xsltStylesheetPtr style)
+{
+    for (; style; style = xsltNextImport(style))
+    {
+        for (xsltTemplatePtr templ = style->templates; templ; templ = templ->next)
+        {
+            templ->nbCalls = 0;
+            templ->time = 0;
+            templ->templNr = 0;
+        }
+    }
+}
+
+
+void xslt::profile_report::pimpl::collect(xsltStylesheetPtr style,
+                                          long total_ticks)
+{
+    std::vector<xsltTemplatePtr> called;
+    for (; style; style = xsltNextImport(style))
+    {
+        for (xsltTemplatePtr templ = style->templates; templ; templ = templ->next)
+        {
+            if (templ->nbCalls > 0)
+                called.push_back(templ);
+        }
+    }
+
+    call_graph graph(called);
+
+    templates_.clear();
+    templates_.reserve(called.size());
+
+    for (std::size_t i = 0; i < called.size(); ++i)
+    {
+        xsltTemplatePtr templ = called[i];
+
+        template_info info;
+        info.name = to_string(templ->name);
+        info.match = to_string(templ->match);
+        info.mode = to_string(templ->mode);
+        info.calls = templ->nbCalls;
+        info.self_time = ticks_to_seconds(templ->time);
+        info.total_time = graph.get_total_time(i);
+
+        templates_.push_back(info);
+    }
+
+    std::stable_sort(templates_.begin(), templates_.end(), by_self_time);
+
+    total_time_ = ticks_to_seconds(total_ticks);
+}
+
+
+// ------------------------------------------------------------------------
+// xslt::profile_report
+// ------------------------------------------------------------------------
+
+xslt::profile_report::profile_report()
+{
+    pimpl_ = new pimpl;
+}
+
+
+xslt::profile_report::profile_report(const profile_report& other)
+{
+    pimpl_ = new pimpl(*other.pimpl_);
+}
+
+
+xslt::profile_report&
+xslt::profile_report::operator=(const profile_report& other)
+{
+    profile_report tmp(other);
+    swap(tmp);
+    return *this;
+}
+
+
+void xslt::profile_report::swap(profile_report& other)
+{
+    std::swap(pimpl_, other.pimpl_);
+}
+
+
+xslt::profile_report::~profile_report()
+{
+    delete pimpl_;
+}
+
+
+const xslt::profile_report::templates_type&
+xslt::profile_report::get_templates() const
+{
+    return pimpl_->templates_;
+}
+
+
+double xslt::profile_report::get_total_time() const
+{
+    return pimpl_->total_time_;
+}
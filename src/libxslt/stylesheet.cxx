@@ -42,7 +42,12 @@
 #include "xmlwrapp/tree_parser.h"
 #include "xmlwrapp/exception.h"
 
+#include "document_loader_impl.h"
+#include "params_impl.h"
+#include "profile_impl.h"
 #include "result.h"
+#include "stylesheet_impl.h"
+#include "../libxml/parallel.h"
 #include "../libxml/utility.h"
 
 // libxslt includes
@@ -50,24 +55,21 @@
 #include <libxslt/xsltInternals.h>
 #include <libxslt/transform.h>
 #include <libxslt/xsltutils.h>
+#include <libxslt/imports.h>
+#include <libxslt/variables.h>
+
+// libxml includes
+#include <libxml/xmlIO.h>
 
 // standard includes
+#include <algorithm>
 #include <memory>
+#include <ostream>
 #include <string>
 #include <vector>
 #include <map>
 
 
-struct xslt::stylesheet::pimpl
-{
-    pimpl (void) : ss_(0), errors_occured_(false) { }
-
-    xsltStylesheetPtr ss_;
-    xml::document doc_;
-    std::string error_;
-    bool errors_occured_;
-};
-
 namespace
 {
 
@@ -121,23 +123,71 @@ void make_vector_param(std::vector<const char*> &v,
 }
 
 
+// errors reported during a single transformation: this is kept separately
+// from the stylesheet so that it can be used by several threads at once
+struct transform_errors
+{
+    transform_errors()
+        : errors_occured_(false),
+          type_(xslt::transform_result::error_transform),
+          limits_(0),
+          start_(0),
+          time_limit_(0),
+          checks_(0)
+    {
+    }
+
+    // stop the transformation because of the given error
+    void stop(xsltTransformContextPtr ctxt,
+              xslt::transform_result::error_type type,
+              const char *message)
+    {
+        ctxt->state = XSLT_STATE_STOPPED;
+
+        if ( errors_occured_ )
+            error_.append("\n");
+        errors_occured_ = true;
+        error_.append(message);
+
+        if ( type_ == xslt::transform_result::error_transform )
+            type_ = type;
+    }
+
+    std::string error_;
+    bool errors_occured_;
+    xslt::transform_result::error_type type_;
+
+    // the limits are only checked if they include a time limit or a
+    // cancellation token, the time is measured in xsltTimestamp() ticks
+    const xslt::transform_limits::pimpl *limits_;
+    unsigned long start_;
+    unsigned long time_limit_;
+    unsigned checks_;
+};
+
+
+// checking the clock takes longer than executing a simple instruction, so
+// the limits are only checked before every CHECK_INTERVAL-th one
+const unsigned CHECK_INTERVAL = 16;
+
+
 extern "C"
 {
 
 static void error_cb(void *c, const char *message, ...)
 {
     xsltTransformContextPtr ctxt = static_cast<xsltTransformContextPtr>(c);
-    xslt::stylesheet::pimpl *impl = static_cast<xslt::stylesheet::pimpl*>(ctxt->_private);
-
-    impl->errors_occured_ = true;
+    transform_errors *errors = static_cast<transform_errors*>(ctxt->_private);
 
     // tell the processor to stop when it gets a chance:
     if ( ctxt->state == XSLT_STATE_OK )
         ctxt->state = XSLT_STATE_STOPPED;
 
     // concatenate all error messages:
-    if ( impl->errors_occured_ )
-        impl->error_.append("\n");
+    if ( errors->errors_occured_ )
+        errors->error_.append("\n");
+
+    errors->errors_occured_ = true;
 
     std::string formatted;
 
@@ -146,36 +196,219 @@ static void error_cb(void *c, const char *message, ...)
     xml::impl::printf2string(formatted, message, ap);
     va_end(ap);
 
-    impl->error_.append(formatted);
+    errors->error_.append(formatted);
+
+    // libxslt reports exceeding its recursion limits as a generic error
+    // right after comparing its counters with them, so the counters tell
+    // whether this is the error being reported
+    if ( errors->type_ == xslt::transform_result::error_transform )
+    {
+        if ( ctxt->depth >= ctxt->maxTemplateDepth )
+            errors->type_ = xslt::transform_result::error_template_depth;
+        else if ( ctxt->varsNr >= ctxt->maxTemplateVars )
+            errors->type_ = xslt::transform_result::error_variable_depth;
+    }
+}
+
+// called by libxslt before executing every instruction of the
+// transformations with the debugger enabled, i.e. those with a time limit or
+// a cancellation token, as the debugger is never enabled globally
+static void limits_check_cb(xmlNodePtr /* cur */,
+                            xmlNodePtr /* node */,
+                            xsltTemplatePtr /* templ */,
+                            xsltTransformContextPtr ctxt)
+{
+    transform_errors *errors = static_cast<transform_errors*>(ctxt->_private);
+    if ( !errors || !errors->limits_ || ctxt->state != XSLT_STATE_OK )
+        return;
+
+    if ( errors->checks_++ % CHECK_INTERVAL )
+        return;
+
+    const xslt::cancellation_token *token = errors->limits_->token_;
+    if ( token && token->is_cancelled() )
+    {
+        errors->stop(ctxt, xslt::transform_result::error_cancelled,
+                     "XSLT transformation was cancelled");
+        return;
+    }
+
+    if ( errors->time_limit_ &&
+         static_cast<unsigned long>(xsltTimestamp()) - errors->start_ >= errors->time_limit_ )
+    {
+        errors->stop(ctxt, xslt::transform_result::error_time_limit,
+                     "XSLT transformation time limit exceeded");
+    }
+}
+
+static int limits_add_call_cb(xsltTemplatePtr /* templ */,
+                              xmlNodePtr /* source */)
+{
+    // nothing to drop later
+    return 0;
+}
+
+static void limits_drop_call_cb()
+{
 }
 
 } // extern "C"
 
-xmlDocPtr apply_stylesheet(xslt::stylesheet::pimpl *impl,
-                           xmlDocPtr doc,
-                           const xslt::stylesheet::param_type *p = NULL)
+
+xml::impl::mutex limits_callbacks_mutex;
+bool limits_callbacks_installed = false;
+
+// install the callbacks checking the limits as the libxslt debugger, this
+// only needs to be done once but returns false if libxslt was built without
+// the debugger support
+bool install_limits_callbacks()
 {
-    xsltStylesheetPtr style = impl->ss_;
+    xml::impl::mutex_lock lock(limits_callbacks_mutex);
 
+    if ( !limits_callbacks_installed )
+    {
+        struct
+        {
+            xsltHandleDebuggerCallback handler;
+            xsltAddCallCallback add;
+            xsltDropCallCallback drop;
+        } callbacks = { limits_check_cb, limits_add_call_cb, limits_drop_call_cb };
+
+        limits_callbacks_installed =
+            xsltSetDebuggerCallbacks(3, &callbacks) == 0;
+    }
+
+    return limits_callbacks_installed;
+}
+
+
+// give the context back to the stylesheet owning it, if any, or free it
+void release_context(xslt::stylesheet::pimpl *owner,
+                     xsltTransformContextPtr ctxt,
+                     bool successful)
+{
+    if ( owner )
+        owner->contexts_.release(ctxt, successful);
+    else
+        xsltFreeTransformContext(ctxt);
+}
+
+} // end of anonymous namespace
+
+
+namespace xslt
+{
+
+namespace impl
+{
+
+xmlDocPtr apply_stylesheet(xsltStylesheetPtr style,
+                           xmlDocPtr doc,
+                           std::string& error,
+                           const xslt::stylesheet::param_type *p,
+                           const xslt::params::pimpl *compiled,
+                           xslt::profile_report::pimpl *profile,
+                           const xslt::transform_limits::pimpl *limits,
+                           xslt::transform_result::error_type *type)
+{
     std::vector<const char*> v;
     if (p)
         make_vector_param(v, *p);
 
-    xsltTransformContextPtr ctxt = xsltNewTransformContext(style, doc);
-    ctxt->_private = impl;
+    const char **xpath_params = p ? &v[0] : 0;
+    if (compiled)
+        xpath_params = compiled->get_xpath_array();
+
+    transform_errors errors;
+
+    // the transformation contexts are reused if the stylesheet has an owner
+    xslt::stylesheet::pimpl *owner =
+        static_cast<xslt::stylesheet::pimpl*>(style->_private);
+
+    xsltTransformContextPtr ctxt = owner ? owner->contexts_.acquire(style, doc)
+                                         : xsltNewTransformContext(style, doc);
+    if ( !ctxt )
+    {
+        error = "failed to create XSLT transformation context";
+        return NULL;
+    }
+
+    ctxt->_private = &errors;
     xsltSetTransformErrorFunc(ctxt, ctxt, error_cb);
 
-    // clear the error flag before applying the stylesheet
-    impl->errors_occured_ = false;
+    if (limits)
+    {
+        if (limits->max_template_depth_)
+            ctxt->maxTemplateDepth = limits->max_template_depth_;
+        if (limits->max_variable_depth_)
+            ctxt->maxTemplateVars = limits->max_variable_depth_;
+
+        if (limits->needs_checks())
+        {
+            if (!install_limits_callbacks())
+            {
+                release_context(owner, ctxt, false);
+                error = "XSLT time limits and cancellation require libxslt "
+                        "built with debugger support";
+                return NULL;
+            }
+
+            errors.limits_ = limits;
+            errors.start_ = static_cast<unsigned long>(xsltTimestamp());
+            errors.time_limit_ = static_cast<unsigned long>(
+                limits->time_limit_ * XSLT_TIMESTAMP_TICS_PER_SEC);
+            if (limits->time_limit_ > 0 && !errors.time_limit_)
+                errors.time_limit_ = 1;
+            ctxt->debugStatus = XSLT_DEBUG_RUN;
+        }
+    }
+    register_functions(ctxt, style);
+
+    // the documents of the loader are shared with other transformations and
+    // so can't be given to libxslt if it needs to modify them; XIncludes are
+    // processed by the loader itself
+    xslt::document_loader::pimpl::entries_list shared_docs;
+    if (owner && owner->loader_ && !xsltNeedElemSpaceHandling(ctxt))
+        owner->loader_->attach(ctxt, shared_docs);
+
+    // string parameters don't need any XPath evaluation and are simply
+    // registered with the context before running the transformation
+    if (compiled)
+    {
+        xslt::params::pimpl::values_map::const_iterator
+            i = compiled->strings_.begin(), end = compiled->strings_.end();
+        for (; i != end; ++i)
+        {
+            xsltQuoteOneUserParam(ctxt,
+                                  reinterpret_cast<const xmlChar*>(i->first.c_str()),
+                                  reinterpret_cast<const xmlChar*>(i->second.c_str()));
+        }
+    }
+
+    long start = 0;
+    if (profile)
+    {
+        xslt::profile_report::pimpl::reset_counters(style);
+        ctxt->profile = 1;
+        start = xsltTimestamp();
+    }
 
     xmlDocPtr result =
-        xsltApplyStylesheetUser(style, doc, p ? &v[0] : 0, NULL, NULL, ctxt);
+        xsltApplyStylesheetUser(style, doc, xpath_params, NULL, NULL, ctxt);
+
+    if (profile)
+        profile->collect(style, xsltTimestamp() - start);
 
-    xsltFreeTransformContext(ctxt);
+    release_context(owner, ctxt, result && !errors.errors_occured_);
+    xslt::document_loader::pimpl::release(shared_docs);
+
+    error.swap(errors.error_);
+    if (type)
+        *type = errors.type_;
 
     // it's possible there was an error that didn't prevent creation of some
     // (incorrect) document
-    if ( result && impl->errors_occured_ )
+    if ( result && errors.errors_occured_ )
     {
         xmlFreeDoc(result);
         return NULL;
@@ -184,23 +417,251 @@ xmlDocPtr apply_stylesheet(xslt::stylesheet::pimpl *impl,
     if ( !result )
     {
         // set generic error message if nothing more specific is known
-        if ( impl->error_.empty() )
-            impl->error_ = "unknown XSLT transformation error";
+        if ( error.empty() )
+            error = "unknown XSLT transformation error";
         return NULL;
     }
 
     return result;
 }
 
+
+extern "C"
+{
+
+static int ostream_write_cb(void *ctx, const char *buf, int len)
+{
+    std::ostream *stream = static_cast<std::ostream*>(ctx);
+
+    try
+    {
+        stream->write(buf, len);
+    }
+    catch ( ... )
+    {
+        return -1;
+    }
+
+    return stream->good() ? len : -1;
+}
+
+static int ostream_close_cb(void * /* ctx */)
+{
+    return 0;
+}
+
+} // extern "C"
+
+
+xmlCharEncodingHandlerPtr get_output_encoder(xsltStylesheetPtr style)
+{
+    const xmlChar *encoding;
+    XSLT_GET_IMPORT_PTR(encoding, style, encoding)
+
+    if ( !encoding )
+        return NULL;
+
+    xmlCharEncodingHandlerPtr encoder =
+        xmlFindCharEncodingHandler(reinterpret_cast<const char*>(encoding));
+    if ( encoder &&
+         xmlStrEqual(reinterpret_cast<const xmlChar*>(encoder->name),
+                     reinterpret_cast<const xmlChar*>("UTF-8")) )
+    {
+        encoder = NULL;
+    }
+
+    return encoder;
+}
+
+
+xmlOutputBufferPtr create_ostream_output(std::ostream& stream,
+                                         xsltStylesheetPtr style)
+{
+    return xmlOutputBufferCreateIO(ostream_write_cb, ostream_close_cb, &stream,
+                                   get_output_encoder(style));
+}
+
+
+xslt::impl::result* make_result(xmlDocPtr doc, xsltStylesheetPtr style)
+{
+    return new result_impl(doc, style);
+}
+
+
+xmlDocPtr transform_to_output(xsltStylesheetPtr style,
+                              xmlDocPtr doc,
+                              const xslt::stylesheet::param_type *p,
+                              const xslt::params::pimpl *compiled,
+                              xmlOutputBufferPtr output,
+                              std::string& error,
+                              const xslt::transform_limits::pimpl *limits,
+                              xslt::transform_result::error_type *type)
+{
+    if ( !output )
+    {
+        error = "failed to create XSLT output buffer";
+        return NULL;
+    }
+
+    xmlDocPtr result = apply_stylesheet(style, doc, error, p, compiled, NULL,
+                                        limits, type);
+    if ( !result )
+    {
+        xmlOutputBufferClose(output);
+        return NULL;
+    }
+
+    const int rc_save = xsltSaveResultTo(output, result, style);
+    const int rc_close = xmlOutputBufferClose(output);
+
+    if ( rc_save < 0 || rc_close < 0 )
+    {
+        xmlFreeDoc(result);
+        error = "failed to write XSLT output";
+        return NULL;
+    }
+
+    return result;
+}
+
+} // end impl namespace
+
+} // end xslt namespace
+
+
+namespace
+{
+
+// Transforms the items of a batch: all tasks share the counter of the next
+// item to process, so that the threads which happen to get the quickly
+// transformed items just process more of them.
+class batch_task : public xml::impl::parallel_task
+{
+public:
+    batch_task(const xslt::stylesheet& style,
+               const xslt::params& with_params,
+               const std::vector<xml::document> *docs,
+               const std::vector<std::string> *filenames,
+               const std::vector<std::size_t>& items,
+               volatile long& next_item,
+               std::vector<xslt::transform_result>& results,
+               std::vector<std::string>& errors)
+        : style_(style),
+          params_(with_params),
+          docs_(docs),
+          filenames_(filenames),
+          items_(items),
+          next_item_(next_item),
+          results_(results),
+          errors_(errors)
+    {
+    }
+
+    virtual void run()
+    {
+        for ( ;; )
+        {
+            const std::size_t n = xml::impl::atomic_add(next_item_, 1) - 1;
+            if ( n >= items_.size() )
+                break;
+
+            const std::size_t i = items_[n];
+
+            try
+            {
+                transform(i);
+            }
+            catch ( std::exception& e )
+            {
+                errors_[i] = *e.what() ? e.what() : "unknown error";
+            }
+            catch ( ... )
+            {
+                errors_[i] = "unknown error";
+            }
+        }
+    }
+
+private:
+    void transform(std::size_t i)
+    {
+        if ( docs_ )
+        {
+            results_[i] = style_.transform((*docs_)[i], params_);
+            return;
+        }
+
+        xml::tree_parser parser((*filenames_)[i].c_str(), false);
+        if ( !parser )
+        {
+            errors_[i] = parser.get_error_message();
+            if ( errors_[i].empty() )
+                errors_[i] = "failed to parse " + (*filenames_)[i];
+            return;
+        }
+
+        results_[i] = style_.transform(parser.get_document(), params_);
+    }
+
+    const xslt::stylesheet& style_;
+    const xslt::params& params_;
+    const std::vector<xml::document> *docs_;
+    const std::vector<std::string> *filenames_;
+    const std::vector<std::size_t>& items_;
+    volatile long& next_item_;
+    std::vector<xslt::transform_result>& results_;
+    std::vector<std::string>& errors_;
+};
+
+
+void run_batch(const xslt::stylesheet& style,
+               const xslt::params& with_params,
+               const std::vector<xml::document> *docs,
+               const std::vector<std::string> *filenames,
+               const std::vector<std::size_t>& items,
+               unsigned thread_count,
+               std::vector<xslt::transform_result>& results,
+               std::vector<std::string>& errors)
+{
+    if ( items.empty() )
+        return;
+
+    if ( !thread_count )
+        thread_count = xml::impl::cpu_count();
+    if ( thread_count > items.size() )
+        thread_count = static_cast<unsigned>(items.size());
+
+    volatile long next_item = 0;
+
+    std::vector<batch_task> tasks;
+    tasks.reserve(thread_count);
+    for ( unsigned n = 0; n < thread_count; ++n )
+    {
+        tasks.push_back(batch_task(style, with_params, docs, filenames,
+                                   items, next_item, results, errors));
+    }
+
+    std::vector<xml::impl::parallel_task*> task_ptrs;
+    for ( unsigned n = 0; n < thread_count; ++n )
+        task_ptrs.push_back(&tasks[n]);
+
+    xml::impl::run_in_parallel(&task_ptrs[0], task_ptrs.size());
+}
+
 } // end of anonymous namespace
 
+using namespace xslt::impl;
+
 
 xslt::stylesheet::stylesheet(const char *filename)
 {
+    impl::ensure_initialized();
+
     std::auto_ptr<pimpl> ap(pimpl_ = new pimpl);
 
     xml::tree_parser parser(filename);
     xmlDocPtr xmldoc = static_cast<xmlDocPtr>(parser.get_document().get_doc_data());
+    register_exslt(xmldoc);
 
     if ( (pimpl_->ss_ = xsltParseStylesheetDoc(xmldoc)) == 0)
     {
@@ -213,13 +674,18 @@ xslt::stylesheet::stylesheet(const char *filename)
     // if we got this far, the xmldoc we gave to xsltParseStylesheetDoc is
     // now owned by the stylesheet and will be cleaned up in our destructor.
     parser.get_document().release_doc_data();
+    // this is how the extension functions find their stylesheet
+    pimpl_->ss_->_private = pimpl_;
     ap.release();
 }
 
 
 xslt::stylesheet::stylesheet(xml::document doc)
 {
+    impl::ensure_initialized();
+
     xmlDocPtr xmldoc = static_cast<xmlDocPtr>(doc.get_doc_data());
+    register_exslt(xmldoc);
     std::auto_ptr<pimpl> ap(pimpl_ = new pimpl);
 
     if ( (pimpl_->ss_ = xsltParseStylesheetDoc(xmldoc)) == 0)
@@ -233,12 +699,15 @@ xslt::stylesheet::stylesheet(xml::document doc)
     // if we got this far, the xmldoc we gave to xsltParseStylesheetDoc is
     // now owned by the stylesheet and will be cleaned up in our destructor.
     doc.release_doc_data();
+    // this is how the extension functions find their stylesheet
+    pimpl_->ss_->_private = pimpl_;
     ap.release();
 }
 
 
 xslt::stylesheet::~stylesheet()
 {
+    pimpl_->contexts_.clear();
     if (pimpl_->ss_)
         xsltFreeStylesheet(pimpl_->ss_);
     delete pimpl_;
@@ -248,11 +717,11 @@ xslt::stylesheet::~stylesheet()
 bool xslt::stylesheet::apply(const xml::document &doc, xml::document &result)
 {
     xmlDocPtr input = static_cast<xmlDocPtr>(doc.get_doc_data_read_only());
-    xmlDocPtr xmldoc = apply_stylesheet(pimpl_, input);
+    xmlDocPtr xmldoc = apply_stylesheet(pimpl_->ss_, input, pimpl_->error_);
 
     if (xmldoc)
     {
-        result.set_doc_data_from_xslt(xmldoc, new result_impl(xmldoc, pimpl_->ss_));
+        result.set_doc_data_from_xslt(xmldoc, make_result(xmldoc, pimpl_->ss_));
         return true;
     }
 
@@ -264,11 +733,27 @@ bool xslt::stylesheet::apply(const xml::document &doc, xml::document &result,
                             const param_type &with_params)
 {
     xmlDocPtr input = static_cast<xmlDocPtr>(doc.get_doc_data_read_only());
-    xmlDocPtr xmldoc = apply_stylesheet(pimpl_, input, &with_params);
+    xmlDocPtr xmldoc = apply_stylesheet(pimpl_->ss_, input, pimpl_->error_, &with_params);
+
+    if (xmldoc)
+    {
+        result.set_doc_data_from_xslt(xmldoc, make_result(xmldoc, pimpl_->ss_));
+        return true;
+    }
+
+    return false;
+}
+
+
+bool xslt::stylesheet::apply(const xml::document &doc, xml::document &result,
+                            const params &with_params)
+{
+    xmlDocPtr input = static_cast<xmlDocPtr>(doc.get_doc_data_read_only());
+    xmlDocPtr xmldoc = apply_stylesheet(pimpl_->ss_, input, pimpl_->error_, NULL, with_params.pimpl_);
 
     if (xmldoc)
     {
-        result.set_doc_data_from_xslt(xmldoc, new result_impl(xmldoc, pimpl_->ss_));
+        result.set_doc_data_from_xslt(xmldoc, make_result(xmldoc, pimpl_->ss_));
         return true;
     }
 
@@ -279,12 +764,12 @@ bool xslt::stylesheet::apply(const xml::document &doc, xml::document &result,
 xml::document& xslt::stylesheet::apply(const xml::document &doc)
 {
     xmlDocPtr input = static_cast<xmlDocPtr>(doc.get_doc_data_read_only());
-    xmlDocPtr xmldoc = apply_stylesheet(pimpl_, input);
+    xmlDocPtr xmldoc = apply_stylesheet(pimpl_->ss_, input, pimpl_->error_);
 
     if ( !xmldoc )
         throw xml::exception(pimpl_->error_);
 
-    pimpl_->doc_.set_doc_data_from_xslt(xmldoc, new result_impl(xmldoc, pimpl_->ss_));
+    pimpl_->doc_.set_doc_data_from_xslt(xmldoc, make_result(xmldoc, pimpl_->ss_));
     return pimpl_->doc_;
 }
 
@@ -293,17 +778,461 @@ xml::document& xslt::stylesheet::apply(const xml::document &doc,
                                        const param_type &with_params)
 {
     xmlDocPtr input = static_cast<xmlDocPtr>(doc.get_doc_data_read_only());
-    xmlDocPtr xmldoc = apply_stylesheet(pimpl_, input, &with_params);
+    xmlDocPtr xmldoc = apply_stylesheet(pimpl_->ss_, input, pimpl_->error_, &with_params);
 
     if ( !xmldoc )
         throw xml::exception(pimpl_->error_);
 
-    pimpl_->doc_.set_doc_data_from_xslt(xmldoc, new result_impl(xmldoc, pimpl_->ss_));
+    pimpl_->doc_.set_doc_data_from_xslt(xmldoc, make_result(xmldoc, pimpl_->ss_));
     return pimpl_->doc_;
 }
 
 
+xml::document& xslt::stylesheet::apply(const xml::document &doc,
+                                       const params &with_params)
+{
+    xmlDocPtr input = static_cast<xmlDocPtr>(doc.get_doc_data_read_only());
+    xmlDocPtr xmldoc = apply_stylesheet(pimpl_->ss_, input, pimpl_->error_, NULL, with_params.pimpl_);
+
+    if ( !xmldoc )
+        throw xml::exception(pimpl_->error_);
+
+    pimpl_->doc_.set_doc_data_from_xslt(xmldoc, make_result(xmldoc, pimpl_->ss_));
+    return pimpl_->doc_;
+}
+
+
+bool xslt::stylesheet::apply(const xml::document &doc, xml::document &result,
+                             profile_report &report)
+{
+    xmlDocPtr input = static_cast<xmlDocPtr>(doc.get_doc_data_read_only());
+
+    xml::impl::mutex_lock lock(pimpl_->profile_mutex_);
+    xmlDocPtr xmldoc = apply_stylesheet(pimpl_->ss_, input, pimpl_->error_,
+                                        NULL, NULL, report.pimpl_);
+
+    if (xmldoc)
+    {
+        result.set_doc_data_from_xslt(xmldoc, make_result(xmldoc, pimpl_->ss_));
+        return true;
+    }
+
+    return false;
+}
+
+
+xslt::transform_result
+xslt::stylesheet::transform(const xml::document &doc) const
+{
+    transform_result result;
+    xmlDocPtr input = static_cast<xmlDocPtr>(doc.get_doc_data_read_only());
+    xmlDocPtr xmldoc = apply_stylesheet(pimpl_->ss_, input, result.pimpl_->error_);
+
+    if (xmldoc)
+    {
+        result.pimpl_->doc_.set_doc_data_from_xslt(xmldoc, make_result(xmldoc, pimpl_->ss_));
+        result.pimpl_->ok_ = true;
+    }
+
+    return result;
+}
+
+
+xslt::transform_result
+xslt::stylesheet::transform(const xml::document &doc,
+                            const param_type &with_params) const
+{
+    transform_result result;
+    xmlDocPtr input = static_cast<xmlDocPtr>(doc.get_doc_data_read_only());
+    xmlDocPtr xmldoc = apply_stylesheet(pimpl_->ss_, input, result.pimpl_->error_, &with_params);
+
+    if (xmldoc)
+    {
+        result.pimpl_->doc_.set_doc_data_from_xslt(xmldoc, make_result(xmldoc, pimpl_->ss_));
+        result.pimpl_->ok_ = true;
+    }
+
+    return result;
+}
+
+
+xslt::transform_result
+xslt::stylesheet::transform(const xml::document &doc,
+                            const params &with_params) const
+{
+    transform_result result;
+    xmlDocPtr input = static_cast<xmlDocPtr>(doc.get_doc_data_read_only());
+    xmlDocPtr xmldoc = apply_stylesheet(pimpl_->ss_, input, result.pimpl_->error_, NULL, with_params.pimpl_);
+
+    if (xmldoc)
+    {
+        result.pimpl_->doc_.set_doc_data_from_xslt(xmldoc, make_result(xmldoc, pimpl_->ss_));
+        result.pimpl_->ok_ = true;
+    }
+
+    return result;
+}
+
+
+xslt::transform_result
+xslt::stylesheet::transform(const xml::document &doc,
+                            const params &with_params,
+                            profile_report &report) const
+{
+    transform_result result;
+    xmlDocPtr input = static_cast<xmlDocPtr>(doc.get_doc_data_read_only());
+
+    xml::impl::mutex_lock lock(pimpl_->profile_mutex_);
+    xmlDocPtr xmldoc = apply_stylesheet(pimpl_->ss_, input, result.pimpl_->error_,
+                                        NULL, with_params.pimpl_, report.pimpl_);
+
+    if (xmldoc)
+    {
+        result.pimpl_->doc_.set_doc_data_from_xslt(xmldoc, make_result(xmldoc, pimpl_->ss_));
+        result.pimpl_->ok_ = true;
+    }
+
+    return result;
+}
+
+
+xslt::transform_result
+xslt::stylesheet::transform(const xml::document &doc,
+                            const params &with_params,
+                            const transform_limits &limits) const
+{
+    transform_result result;
+    xmlDocPtr input = static_cast<xmlDocPtr>(doc.get_doc_data_read_only());
+    xmlDocPtr xmldoc = apply_stylesheet(pimpl_->ss_, input, result.pimpl_->error_,
+                                        NULL, with_params.pimpl_, NULL,
+                                        limits.pimpl_, &result.pimpl_->type_);
+
+    if (xmldoc)
+    {
+        result.pimpl_->doc_.set_doc_data_from_xslt(xmldoc, make_result(xmldoc, pimpl_->ss_));
+        result.pimpl_->ok_ = true;
+    }
+
+    return result;
+}
+
+
+std::vector<xslt::transform_result>
+xslt::stylesheet::transform_batch(const std::vector<xml::document> &docs,
+                                  const params &with_params,
+                                  unsigned thread_count) const
+{
+    std::vector<transform_result> results;
+    results.reserve(docs.size());
+    for (std::size_t i = 0; i < docs.size(); ++i)
+        results.push_back(transform_result());
+
+    std::vector<std::size_t> items(docs.size());
+    for (std::size_t i = 0; i < items.size(); ++i)
+        items[i] = i;
+
+    std::vector<std::string> errors(docs.size());
+    run_batch(*this, with_params, &docs, NULL, items, thread_count, results, errors);
+
+    for (std::size_t i = 0; i < errors.size(); ++i)
+    {
+        if (!errors[i].empty())
+            results[i].pimpl_->error_ = errors[i];
+    }
+
+    return results;
+}
+
+
+std::vector<xslt::transform_result>
+xslt::stylesheet::transform_batch(const std::vector<std::string> &filenames,
+                                  const params &with_params,
+                                  unsigned thread_count) const
+{
+    std::vector<transform_result> results;
+    results.reserve(filenames.size());
+    for (std::size_t i = 0; i < filenames.size(); ++i)
+        results.push_back(transform_result());
+
+    std::vector<std::size_t> items(filenames.size());
+    for (std::size_t i = 0; i < items.size(); ++i)
+        items[i] = i;
+
+    std::vector<std::string> errors(filenames.size());
+    run_batch(*this, with_params, NULL, &filenames, items, thread_count, results, errors);
+
+    for (std::size_t i = 0; i < errors.size(); ++i)
+    {
+        if (!errors[i].empty())
+            results[i].pimpl_->error_ = errors[i];
+    }
+
+    return results;
+}
+
+
+xslt::transform_result
+xslt::stylesheet::transform_to(const xml::document &doc,
+                               std::ostream &stream,
+                               bool keep_result) const
+{
+    return transform_to(doc, stream, param_type(), keep_result);
+}
+
+
+xslt::transform_result
+xslt::stylesheet::transform_to(const xml::document &doc,
+                               std::ostream &stream,
+                               const param_type &with_params,
+                               bool keep_result) const
+{
+    transform_result result;
+    xmlDocPtr input = static_cast<xmlDocPtr>(doc.get_doc_data_read_only());
+
+    xmlOutputBufferPtr output = create_ostream_output(stream, pimpl_->ss_);
+    xmlDocPtr xmldoc = transform_to_output(pimpl_->ss_, input, &with_params, NULL,
+                                           output, result.pimpl_->error_);
+
+    if (xmldoc)
+    {
+        if (keep_result)
+            result.pimpl_->doc_.set_doc_data_from_xslt(xmldoc, make_result(xmldoc, pimpl_->ss_));
+        else
+            xmlFreeDoc(xmldoc);
+        result.pimpl_->ok_ = true;
+    }
+
+    return result;
+}
+
+
+xslt::transform_result
+xslt::stylesheet::transform_to(const xml::document &doc,
+                               std::ostream &stream,
+                               const params &with_params,
+                               bool keep_result) const
+{
+    transform_result result;
+    xmlDocPtr input = static_cast<xmlDocPtr>(doc.get_doc_data_read_only());
+
+    xmlOutputBufferPtr output = create_ostream_output(stream, pimpl_->ss_);
+    xmlDocPtr xmldoc = transform_to_output(pimpl_->ss_, input, NULL, with_params.pimpl_,
+                                           output, result.pimpl_->error_);
+
+    if (xmldoc)
+    {
+        if (keep_result)
+            result.pimpl_->doc_.set_doc_data_from_xslt(xmldoc, make_result(xmldoc, pimpl_->ss_));
+        else
+            xmlFreeDoc(xmldoc);
+        result.pimpl_->ok_ = true;
+    }
+
+    return result;
+}
+
+
+xslt::transform_result
+xslt::stylesheet::transform_to(const xml::document &doc,
+                               std::ostream &stream,
+                               const params &with_params,
+                               const transform_limits &limits,
+                               bool keep_result) const
+{
+    transform_result result;
+    xmlDocPtr input = static_cast<xmlDocPtr>(doc.get_doc_data_read_only());
+
+    xmlOutputBufferPtr output = create_ostream_output(stream, pimpl_->ss_);
+    xmlDocPtr xmldoc = transform_to_output(pimpl_->ss_, input, NULL, with_params.pimpl_,
+                                           output, result.pimpl_->error_,
+                                           limits.pimpl_, &result.pimpl_->type_);
+
+    if (xmldoc)
+    {
+        if (keep_result)
+            result.pimpl_->doc_.set_doc_data_from_xslt(xmldoc, make_result(xmldoc, pimpl_->ss_));
+        else
+            xmlFreeDoc(xmldoc);
+        result.pimpl_->ok_ = true;
+    }
+
+    return result;
+}
+
+
+xslt::transform_result
+xslt::stylesheet::transform_to(const xml::document &doc,
+                               int fd,
+                               bool keep_result) const
+{
+    return transform_to(doc, fd, param_type(), keep_result);
+}
+
+
+xslt::transform_result
+xslt::stylesheet::transform_to(const xml::document &doc,
+                               int fd,
+                               const param_type &with_params,
+                               bool keep_result) const
+{
+    transform_result result;
+    xmlDocPtr input = static_cast<xmlDocPtr>(doc.get_doc_data_read_only());
+
+    xmlOutputBufferPtr output =
+        xmlOutputBufferCreateFd(fd, get_output_encoder(pimpl_->ss_));
+    xmlDocPtr xmldoc = transform_to_output(pimpl_->ss_, input, &with_params, NULL,
+                                           output, result.pimpl_->error_);
+
+    if (xmldoc)
+    {
+        if (keep_result)
+            result.pimpl_->doc_.set_doc_data_from_xslt(xmldoc, make_result(xmldoc, pimpl_->ss_));
+        else
+            xmlFreeDoc(xmldoc);
+        result.pimpl_->ok_ = true;
+    }
+
+    return result;
+}
+
+
+xslt::transform_result
+xslt::stylesheet::transform_to(const xml::document &doc,
+                               int fd,
+                               const params &with_params,
+                               bool keep_result) const
+{
+    transform_result result;
+    xmlDocPtr input = static_cast<xmlDocPtr>(doc.get_doc_data_read_only());
+
+    xmlOutputBufferPtr output =
+        xmlOutputBufferCreateFd(fd, get_output_encoder(pimpl_->ss_));
+    xmlDocPtr xmldoc = transform_to_output(pimpl_->ss_, input, NULL, with_params.pimpl_,
+                                           output, result.pimpl_->error_);
+
+    if (xmldoc)
+    {
+        if (keep_result)
+            result.pimpl_->doc_.set_doc_data_from_xslt(xmldoc, make_result(xmldoc, pimpl_->ss_));
+        else
+            xmlFreeDoc(xmldoc);
+        result.pimpl_->ok_ = true;
+    }
+
+    return result;
+}
+
+
+void xslt::stylesheet::register_function(const char *uri,
+                                         const char *name,
+                                         extension_function& func)
+{
+    pimpl::functions_type::iterator i = pimpl_->functions_.begin(),
+                                    end = pimpl_->functions_.end();
+    for (; i != end; ++i)
+    {
+        if (i->uri_ == uri && i->name_ == name)
+        {
+            i->func_ = &func;
+            return;
+        }
+    }
+
+    pimpl::function_entry entry;
+    entry.uri_ = uri;
+    entry.name_ = name;
+    entry.func_ = &func;
+    pimpl_->functions_.push_back(entry);
+}
+
+
+void xslt::stylesheet::set_document_loader(document_loader *loader)
+{
+    if (loader)
+        document_loader::pimpl::install_hook();
+
+    pimpl_->loader_ = loader ? loader->pimpl_ : 0;
+}
+
+
 const std::string& xslt::stylesheet::get_error_message() const
 {
     return pimpl_->error_;
 }
+
+
+void* xslt::stylesheet::get_stylesheet_data() const
+{
+    return pimpl_->ss_;
+}
+
+
+// ------------------------------------------------------------------------
+// xslt::transform_result
+// ------------------------------------------------------------------------
+
+xslt::transform_result::transform_result()
+{
+    pimpl_ = new pimpl;
+}
+
+
+// copying the document would lose the XSLT output settings used for saving
+// it, so the copies share it instead
+xslt::transform_result::transform_result(const transform_result& other)
+    : pimpl_(other.pimpl_)
+{
+    xml::impl::atomic_add(pimpl_->refs_, 1);
+}
+
+
+xslt::transform_result&
+xslt::transform_result::operator=(const transform_result& other)
+{
+    transform_result tmp(other);
+    swap(tmp);
+    return *this;
+}
+
+
+void xslt::transform_result::swap(transform_result& other)
+{
+    std::swap(pimpl_, other.pimpl_);
+}
+
+
+xslt::transform_result::~transform_result()
+{
+    if (xml::impl::atomic_add(pimpl_->refs_, -1) == 0)
+        delete pimpl_;
+}
+
+
+bool xslt::transform_result::is_successful() const
+{
+    return pimpl_->ok_;
+}
+
+
+const xml::document& xslt::transform_result::get_document() const
+{
+    return pimpl_->doc_;
+}
+
+
+xml::document& xslt::transform_result::get_document()
+{
+    return pimpl_->doc_;
+}
+
+
+const std::string& xslt::transform_result::get_error_message() const
+{
+    return pimpl_->error_;
+}
+
+
+xslt::transform_result::error_type xslt::transform_result::get_error_type() const
+{
+    return pimpl_->ok_ ? error_none : pimpl_->type_;
+}
@@ -0,0 +1,325 @@
+/*
+ * Copyright (C) 2001-2003 Peter J Jones (pjones@pmade.org)
+ * All Rights Reserved
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name of the Author nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ * USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/**
+    @file
+
+    This file contains the implementation of the xslt::stylesheet_cache class.
+ */
+
+// xmlwrapp includes
+#include "xsltwrapp/stylesheet_cache.h"
+
+#include "file_stamp.h"
+#include "../libxml/parallel.h"
+
+// libxslt includes
+#include <libxslt/xsltInternals.h>
+
+// standard includes
+#include <algorithm>
+#include <ctime>
+#include <list>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+using xml::impl::atomic_add;
+using xml::impl::mutex;
+using xml::impl::mutex_lock;
+using xslt::impl::file_stamp;
+using xslt::impl::url_to_path;
+using xslt::impl::update_stamp;
+
+
+struct xslt::stylesheet_cache::handle::holder
+{
+    explicit holder(stylesheet *ss) : ss_(ss), refs_(1) { }
+    ~holder() { delete ss_; }
+
+    stylesheet *ss_;
+    volatile long refs_;
+};
+
+
+namespace
+{
+
+void add_stamp(std::vector<file_stamp>& files, const xmlChar *url)
+{
+    if (!url)
+        return;
+
+    file_stamp stamp;
+    if (!url_to_path(reinterpret_cast<const char*>(url), stamp.path_))
+        return;
+
+    for (std::size_t i = 0; i < files.size(); ++i)
+    {
+        if (files[i].path_ == stamp.path_)
+            return;
+    }
+
+    update_stamp(stamp);
+    files.push_back(stamp);
+}
+
+
+// collect the files included or imported by the stylesheet, recursively
+void add_dependencies(std::vector<file_stamp>& files, xsltStylesheetPtr style)
+{
+    if (style->doc)
+        add_stamp(files, style->doc->URL);
+
+    for (xsltDocumentPtr d = style->docList; d; d = d->next)
+    {
+        if (d->doc)
+            add_stamp(files, d->doc->URL);
+    }
+
+    for (xsltStylesheetPtr imp = style->imports; imp; imp = imp->next)
+        add_dependencies(files, imp);
+}
+
+
+bool is_up_to_date(const std::vector<file_stamp>& files)
+{
+    for (std::size_t i = 0; i < files.size(); ++i)
+    {
+        file_stamp current;
+        current.path_ = files[i].path_;
+        update_stamp(current);
+
+        if (!(current == files[i]))
+            return false;
+    }
+
+    return true;
+}
+
+} // anonymous namespace
+
+
+struct xslt::stylesheet_cache::pimpl
+{
+    // the most recently used file names are at the front
+    typedef std::list<std::string> lru_list;
+
+    struct entry
+    {
+        handle style_;
+        std::vector<file_stamp> files_;
+        lru_list::iterator lru_;
+    };
+
+    typedef std::map<std::string, entry> entries_map;
+
+    explicit pimpl(std::size_t max_size) : max_size_(max_size) { }
+
+    void erase(entries_map::iterator i)
+    {
+        lru_.erase(i->second.lru_);
+        entries_.erase(i);
+    }
+
+    std::size_t max_size_;
+    entries_map entries_;
+    lru_list lru_;
+    mutex mutex_;
+};
+
+
+// ------------------------------------------------------------------------
+// xslt::stylesheet_cache::handle
+// ------------------------------------------------------------------------
+
+xslt::stylesheet_cache::handle::handle() : holder_(0)
+{
+}
+
+
+xslt::stylesheet_cache::handle::handle(holder *h) : holder_(h)
+{
+}
+
+
+xslt::stylesheet_cache::handle::handle(const handle& other)
+    : holder_(other.holder_)
+{
+    if (holder_)
+        atomic_add(holder_->refs_, 1);
+}
+
+
+xslt::stylesheet_cache::handle&
+xslt::stylesheet_cache::handle::operator=(const handle& other)
+{
+    handle tmp(other);
+    swap(tmp);
+    return *this;
+}
+
+
+void xslt::stylesheet_cache::handle::swap(handle& other)
+{
+    std::swap(holder_, other.holder_);
+}
+
+
+xslt::stylesheet_cache::handle::~handle()
+{
+    if (holder_ && atomic_add(holder_->refs_, -1) == 0)
+        delete holder_;
+}
+
+
+const xslt::stylesheet* xslt::stylesheet_cache::handle::get() const
+{
+    return holder_ ? holder_->ss_ : 0;
+}
+
+
+// ------------------------------------------------------------------------
+// xslt::stylesheet_cache
+// ------------------------------------------------------------------------
+
+xslt::stylesheet_cache::stylesheet_cache(std::size_t max_size)
+{
+    pimpl_ = new pimpl(max_size);
+}
+
+
+xslt::stylesheet_cache::~stylesheet_cache()
+{
+    delete pimpl_;
+}
+
+
+xslt::stylesheet_cache::handle
+xslt::stylesheet_cache::get(const char *filename)
+{
+    const std::string key(filename);
+
+    {
+        handle style;
+        std::vector<file_stamp> files;
+
+        {
+            mutex_lock lock(pimpl_->mutex_);
+
+            pimpl::entries_map::iterator i = pimpl_->entries_.find(key);
+            if (i != pimpl_->entries_.end())
+            {
+                style = i->second.style_;
+                files = i->second.files_;
+                pimpl_->lru_.splice(pimpl_->lru_.begin(), pimpl_->lru_, i->second.lru_);
+            }
+        }
+
+        // checking the files can take a while, so don't block the other
+        // threads while doing it
+        if (style.get() && is_up_to_date(files))
+            return style;
+    }
+
+    // stat the main file before loading it: if it's modified while we're
+    // compiling it, it will be just compiled again the next time
+    std::vector<file_stamp> files;
+    file_stamp main_file;
+    if (url_to_path(filename, main_file.path_))
+    {
+        update_stamp(main_file);
+        files.push_back(main_file);
+    }
+
+    std::auto_ptr<stylesheet> ss(new stylesheet(filename));
+    add_dependencies(files,
+                     static_cast<xsltStylesheetPtr>(ss->get_stylesheet_data()));
+
+    handle style(new handle::holder(ss.get()));
+    ss.release();
+
+    mutex_lock lock(pimpl_->mutex_);
+
+    pimpl::entries_map::iterator i = pimpl_->entries_.find(key);
+    if (i == pimpl_->entries_.end())
+    {
+        pimpl_->lru_.push_front(key);
+        i = pimpl_->entries_.insert(std::make_pair(key, pimpl::entry())).first;
+        i->second.lru_ = pimpl_->lru_.begin();
+    }
+    else
+    {
+        pimpl_->lru_.splice(pimpl_->lru_.begin(), pimpl_->lru_, i->second.lru_);
+    }
+
+    i->second.style_ = style;
+    i->second.files_.swap(files);
+
+    while (pimpl_->entries_.size() > pimpl_->max_size_)
+        pimpl_->erase(pimpl_->entries_.find(pimpl_->lru_.back()));
+
+    return style;
+}
+
+
+void xslt::stylesheet_cache::remove(const char *filename)
+{
+    mutex_lock lock(pimpl_->mutex_);
+
+    pimpl::entries_map::iterator i = pimpl_->entries_.find(filename);
+    if (i != pimpl_->entries_.end())
+        pimpl_->erase(i);
+}
+
+
+void xslt::stylesheet_cache::clear()
+{
+    mutex_lock lock(pimpl_->mutex_);
+
+    pimpl_->entries_.clear();
+    pimpl_->lru_.clear();
+}
+
+
+std::size_t xslt::stylesheet_cache::size() const
+{
+    mutex_lock lock(pimpl_->mutex_);
+    return pimpl_->entries_.size();
+}
+
+
+std::size_t xslt::stylesheet_cache::get_max_size() const
+{
+    return pimpl_->max_size_;
+}
@@ -0,0 +1,164 @@
+/*
+ * Copyright (C) 2001-2003 Peter J Jones (pjones@pmade.org)
+ * All Rights Reserved
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name of the Author nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ * USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#ifndef _xsltwrapp_stylesheet_impl_h_
+#define _xsltwrapp_stylesheet_impl_h_
+
+// xmlwrapp includes
+#include "xsltwrapp/stylesheet.h"
+#include "xsltwrapp/transform_result.h"
+#include "xmlwrapp/document.h"
+
+#include "context_pool.h"
+#include "params_impl.h"
+#include "profile_impl.h"
+#include "transform_limits_impl.h"
+#include "result.h"
+#include "../libxml/parallel.h"
+
+// libxslt includes
+#include <libxslt/xsltInternals.h>
+
+// libxml includes
+#include <libxml/xmlIO.h>
+
+// standard includes
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+struct xslt::stylesheet::pimpl
+{
+    pimpl (void) : ss_(0), loader_(0) { }
+
+    // extension function registered with the stylesheet
+    struct function_entry
+    {
+        std::string uri_;
+        std::string name_;
+        extension_function *func_;
+    };
+    typedef std::vector<function_entry> functions_type;
+
+    // find the function with the given name, return NULL if none
+    extension_function* find_function(const xmlChar *uri,
+                                      const xmlChar *name) const;
+
+    xsltStylesheetPtr ss_;
+    xml::document doc_;
+    std::string error_;
+    functions_type functions_;
+    document_loader::pimpl *loader_;
+
+    // the transformation contexts kept for reuse
+    impl::context_pool contexts_;
+
+    // serializes the profiled transformations, see profile_impl.h
+    xml::impl::mutex profile_mutex_;
+};
+
+
+struct xslt::transform_result::pimpl
+{
+    pimpl() : type_(error_transform), ok_(false), refs_(1) { }
+
+    xml::document doc_;
+    std::string error_;
+    error_type type_;
+    bool ok_;
+    volatile long refs_;
+};
+
+
+namespace xslt
+{
+
+namespace impl
+{
+
+// Initialize libxml2 and libxslt if they aren't initialized yet, this is
+// needed when XMLWRAPP_LAZY_INIT is used and there are no xslt::init objects.
+void ensure_initialized();
+
+// Register the EXSLT modules selected by xslt::init::exslt_modules() before
+// compiling the stylesheet document: all of them or, in on demand mode, only
+// those whose namespace is declared in it.
+void register_exslt(xmlDocPtr style_doc);
+
+// Apply the stylesheet to the document using the given parameters, if any,
+// and return the result tree or NULL, in which case the error is set. Only
+// the transformation context created for this call is modified, so this
+// may be used concurrently with the same stylesheet. If the limits are given,
+// the transformation is stopped when exceeding them and the type of the error
+// is returned in the last argument, if it's not NULL.
+xmlDocPtr apply_stylesheet(xsltStylesheetPtr style,
+                           xmlDocPtr doc,
+                           std::string& error,
+                           const stylesheet::param_type *p = NULL,
+                           const params::pimpl *compiled = NULL,
+                           profile_report::pimpl *profile = NULL,
+                           const transform_limits::pimpl *limits = NULL,
+                           transform_result::error_type *type = NULL);
+
+// Transform the document and write the result to the given output buffer,
+// which is always closed; returns the result tree on success.
+xmlDocPtr transform_to_output(xsltStylesheetPtr style,
+                              xmlDocPtr doc,
+                              const stylesheet::param_type *p,
+                              const params::pimpl *compiled,
+                              xmlOutputBufferPtr output,
+                              std::string& error,
+                              const transform_limits::pimpl *limits = NULL,
+                              transform_result::error_type *type = NULL);
+
+// Get the encoder for the output encoding specified by the stylesheet, if
+// any; this mirrors what xsltSaveResultToFilename() does.
+xmlCharEncodingHandlerPtr get_output_encoder(xsltStylesheetPtr style);
+
+// Create an output buffer writing to the stream using the output encoding
+// of the stylesheet.
+xmlOutputBufferPtr create_ostream_output(std::ostream& stream,
+                                         xsltStylesheetPtr style);
+
+// Register the extension functions of the stylesheet, if any, with the
+// transformation context.
+void register_functions(xsltTransformContextPtr ctxt, xsltStylesheetPtr style);
+
+// Create the object to pass to xml::document::set_doc_data_from_xslt() for
+// the result tree produced by the stylesheet.
+result* make_result(xmlDocPtr doc, xsltStylesheetPtr style);
+
+} // end impl namespace
+
+} // end xslt namespace
+
+#endif // _xsltwrapp_stylesheet_impl_h_
@@ -0,0 +1,161 @@
+/*
+ * Copyright (C) 2001-2003 Peter J Jones (pjones@pmade.org)
+ * All Rights Reserved
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name of the Author nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ * USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/**
+    @file
+
+    This file contains the implementation of the xslt::transform_limits and
+    xslt::cancellation_token classes.
+ */
+
+// xmlwrapp includes
+#include "xsltwrapp/transform_limits.h"
+
+#include "transform_limits_impl.h"
+#include "../libxml/parallel.h"
+
+// standard includes
+#include <algorithm>
+
+using xml::impl::atomic_add;
+
+
+// ------------------------------------------------------------------------
+// xslt::cancellation_token
+// ------------------------------------------------------------------------
+
+xslt::cancellation_token::cancellation_token() : cancelled_(0)
+{
+}
+
+
+xslt::cancellation_token::~cancellation_token()
+{
+}
+
+
+void xslt::cancellation_token::cancel()
+{
+    atomic_add(cancelled_, 1);
+}
+
+
+bool xslt::cancellation_token::is_cancelled() const
+{
+    return atomic_add(cancelled_, 0) != 0;
+}
+
+
+// ------------------------------------------------------------------------
+// xslt::transform_limits
+// ------------------------------------------------------------------------
+
+xslt::transform_limits::transform_limits()
+{
+    pimpl_ = new pimpl;
+}
+
+
+xslt::transform_limits::transform_limits(const transform_limits& other)
+{
+    pimpl_ = new pimpl(*other.pimpl_);
+}
+
+
+xslt::transform_limits&
+xslt::transform_limits::operator=(const transform_limits& other)
+{
+    transform_limits tmp(other);
+    swap(tmp);
+    return *this;
+}
+
+
+void xslt::transform_limits::swap(transform_limits& other)
+{
+    std::swap(pimpl_, other.pimpl_);
+}
+
+
+xslt::transform_limits::~transform_limits()
+{
+    delete pimpl_;
+}
+
+
+void xslt::transform_limits::set_max_template_depth(int depth)
+{
+    pimpl_->max_template_depth_ = depth > 0 ? depth : 0;
+}
+
+
+int xslt::transform_limits::get_max_template_depth() const
+{
+    return pimpl_->max_template_depth_;
+}
+
+
+void xslt::transform_limits::set_max_variable_depth(int depth)
+{
+    pimpl_->max_variable_depth_ = depth > 0 ? depth : 0;
+}
+
+
+int xslt::transform_limits::get_max_variable_depth() const
+{
+    return pimpl_->max_variable_depth_;
+}
+
+
+void xslt::transform_limits::set_time_limit(double seconds)
+{
+    pimpl_->time_limit_ = seconds > 0 ? seconds : 0;
+}
+
+
+double xslt::transform_limits::get_time_limit() const
+{
+    return pimpl_->time_limit_;
+}
+
+
+void xslt::transform_limits::set_cancellation_token(const cancellation_token *token)
+{
+    pimpl_->token_ = token;
+}
+
+
+const xslt::cancellation_token*
+xslt::transform_limits::get_cancellation_token() const
+{
+    return pimpl_->token_;
+}
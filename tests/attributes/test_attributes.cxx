@@ -203,6 +203,168 @@ BOOST_AUTO_TEST_CASE( find_dtd_default_attr )
 }
 
 
+/*
+ * Test that DTD default attributes with a namespace prefix keep it in
+ * their name.
+ */
+
+BOOST_AUTO_TEST_CASE( find_dtd_default_prefixed )
+{
+    xml::tree_parser parser(test_file_path("attributes/data/13.xml").c_str());
+    const xml::attributes &attrs =
+        parser.get_document().get_root_node().get_attributes();
+
+    xml::attributes::const_iterator i = attrs.find("p:x");
+    BOOST_REQUIRE( i != attrs.end() );
+    BOOST_CHECK_EQUAL( i->get_name(), "p:x" );
+    BOOST_CHECK_EQUAL( i->get_name(), "p:x" );
+    BOOST_CHECK_EQUAL( i->get_value(), "prefixed" );
+
+    i = attrs.find("y");
+    BOOST_REQUIRE( i != attrs.end() );
+    BOOST_CHECK_EQUAL( i->get_name(), "y" );
+
+    static const char *names[] = { "y", "p:x" };
+    const xml::attributes::name_set name_set(names, 2);
+    xml::attributes::const_iterator results[2];
+    BOOST_CHECK_EQUAL( attrs.find(name_set, results), 2 );
+    BOOST_REQUIRE( results[1] != attrs.end() );
+    BOOST_CHECK_EQUAL( results[1]->get_name(), "p:x" );
+}
+
+
+/*
+ * Test looking up several attributes at once, including DTD defaults.
+ */
+
+BOOST_AUTO_TEST_CASE( find_many )
+{
+    xml::tree_parser parser(test_file_path("attributes/data/09.xml").c_str());
+    xml::attributes &attrs =
+        parser.get_document().get_root_node().get_attributes();
+
+    static const char *names[] = { "three", "missing", "one", "two" };
+    const xml::attributes::name_set name_set(names, 4);
+    BOOST_CHECK_EQUAL( name_set.size(), 4 );
+    BOOST_CHECK_EQUAL( name_set.get_name(1), "missing" );
+
+    xml::attributes::iterator results[4];
+    BOOST_CHECK_EQUAL( attrs.find(name_set, results), 3 );
+
+    BOOST_REQUIRE( results[0] != attrs.end() );
+    BOOST_CHECK_EQUAL( results[0]->get_value(), "three" );
+    BOOST_CHECK( results[1] == attrs.end() );
+    BOOST_REQUIRE( results[2] != attrs.end() );
+    BOOST_CHECK_EQUAL( results[2]->get_value(), "1" );
+    BOOST_REQUIRE( results[3] != attrs.end() );
+    BOOST_CHECK_EQUAL( results[3]->get_name(), "two" );
+    BOOST_CHECK_EQUAL( results[3]->get_value(), "two" );
+
+    const xml::attributes &const_attrs = attrs;
+    xml::attributes::const_iterator const_results[4];
+    BOOST_CHECK_EQUAL( const_attrs.find(name_set, const_results), 3 );
+    BOOST_CHECK( const_results[2] == const_attrs.find("one") );
+}
+
+
+/*
+ * Test that the internal DTD subset overrides the external one in the same
+ * way for single and multiple lookups, even when it declares no default.
+ */
+
+BOOST_AUTO_TEST_CASE( find_many_subsets )
+{
+    xml::tree_parser parser(test_file_path("attributes/data/14.xml").c_str());
+    const xml::attributes &attrs =
+        parser.get_document().get_root_node().get_attributes();
+
+    BOOST_CHECK( attrs.find("one") == attrs.end() );
+    BOOST_REQUIRE( attrs.find("two") != attrs.end() );
+    BOOST_CHECK_EQUAL( attrs.find("two")->get_value(), "ext-two" );
+
+    static const char *names[] = { "one", "two" };
+    const xml::attributes::name_set name_set(names, 2);
+    xml::attributes::const_iterator results[2];
+    BOOST_CHECK_EQUAL( attrs.find(name_set, results), 1 );
+    BOOST_CHECK( results[0] == attrs.end() );
+    BOOST_REQUIRE( results[1] != attrs.end() );
+    BOOST_CHECK_EQUAL( results[1]->get_value(), "ext-two" );
+}
+
+
+/*
+ * Test looking up duplicate names and attributes which were added after
+ * parsing, whose names are not in the document dictionary.
+ */
+
+BOOST_AUTO_TEST_CASE( find_many_added )
+{
+    xml::tree_parser parser(test_file_path("attributes/data/09.xml").c_str());
+    xml::attributes &attrs =
+        parser.get_document().get_root_node().get_attributes();
+
+    attrs.insert("added", "new value");
+
+    xml::attributes::name_set name_set;
+    name_set.add("added");
+    name_set.add("three");
+    name_set.add("added");
+    name_set.add("never-used-anywhere");
+
+    xml::attributes::iterator results[4];
+    BOOST_CHECK_EQUAL( attrs.find(name_set, results), 3 );
+
+    BOOST_REQUIRE( results[0] != attrs.end() );
+    BOOST_CHECK_EQUAL( results[0]->get_value(), "new value" );
+    BOOST_REQUIRE( results[1] != attrs.end() );
+    BOOST_CHECK_EQUAL( results[1]->get_value(), "three" );
+    BOOST_CHECK( results[2] == results[0] );
+    BOOST_CHECK( results[3] == attrs.end() );
+
+    // the name wasn't in the dictionary the last time, but it is now
+    attrs.insert("never-used-anywhere", "late");
+    BOOST_CHECK_EQUAL( attrs.find(name_set, results), 4 );
+    BOOST_REQUIRE( results[3] != attrs.end() );
+    BOOST_CHECK_EQUAL( results[3]->get_value(), "late" );
+
+    // and the same set can be used with another document
+    xml::tree_parser parser2(test_file_path("attributes/data/09.xml").c_str());
+    xml::attributes &attrs2 =
+        parser2.get_document().get_root_node().get_attributes();
+    BOOST_CHECK_EQUAL( attrs2.find(name_set, results), 1 );
+    BOOST_REQUIRE( results[1] != attrs2.end() );
+    BOOST_CHECK_EQUAL( results[1]->get_value(), "three" );
+}
+
+
+/*
+ * Test that DTD defaults can be ignored and that the defaults found after
+ * validating the document against another DTD come from the new one.
+ */
+
+BOOST_AUTO_TEST_CASE( dtd_default_revalidate )
+{
+    xml::tree_parser parser(test_file_path("attributes/data/09.xml").c_str());
+    xml::document& doc = parser.get_document();
+    const xml::attributes &attrs = doc.get_root_node().get_attributes();
+
+    BOOST_CHECK( attrs.find("two", xml::attributes::ignore_dtd_defaults) == attrs.end() );
+    BOOST_CHECK( attrs.find("one", xml::attributes::ignore_dtd_defaults) != attrs.end() );
+
+    xml::attributes::const_iterator two = attrs.find("two");
+    BOOST_REQUIRE( two != attrs.end() );
+    BOOST_CHECK_EQUAL( two->get_value(), "two" );
+    BOOST_CHECK( attrs.find("four") == attrs.end() );
+
+    BOOST_REQUIRE( doc.validate(test_file_path("attributes/data/12.dtd").c_str()) );
+
+    two = attrs.find("two");
+    BOOST_REQUIRE( two != attrs.end() );
+    BOOST_CHECK_EQUAL( two->get_value(), "deux" );
+    BOOST_CHECK( attrs.find("three") == attrs.end() );
+}
+
+
 /*
  * Test to see if xml::attributes::find() will die when DTD default
  * attributes are really implied.
@@ -241,6 +403,36 @@ BOOST_AUTO_TEST_CASE( attr_copy_ctor )
     BOOST_CHECK( is_same_as_file(ostr, "attributes/data/08.out") );
 }
 
+
+/*
+ * Test that values made of several nodes (entity references) are read
+ * correctly and that iterator copies don't share the value buffer.
+ */
+
+BOOST_AUTO_TEST_CASE( read_entity_refs )
+{
+    // keep entity references in the tree
+    xml::init::substitute_entities(false);
+    xml::tree_parser parser(test_file_path("attributes/data/11.xml").c_str());
+    xml::init::substitute_entities(true);
+
+    std::ostringstream ostr;
+    const xml::attributes &attrs = parser.get_document().get_root_node().get_attributes();
+    for (xml::attributes::const_iterator i = attrs.begin(); i != attrs.end(); ++i)
+        ostr << i->get_name() << "=" << i->get_value() << "\n";
+
+    BOOST_CHECK( is_same_as_file(ostr, "attributes/data/11.out") );
+
+    xml::attributes::const_iterator mixed = attrs.find("mixed");
+    BOOST_REQUIRE( mixed != attrs.end() );
+    const char *value = mixed->get_value();
+
+    xml::attributes::const_iterator copy(mixed);
+    BOOST_CHECK_EQUAL( copy->get_value(), "using xmlwrapp here" );
+    BOOST_CHECK_EQUAL( value, "using xmlwrapp here" );
+    BOOST_CHECK( copy == mixed );
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 
@@ -35,6 +35,10 @@
 
 #include <boost/iostreams/filtering_stream.hpp>
 #include <boost/iostreams/filter/gzip.hpp>
+#include <boost/thread/thread.hpp>
+
+#include <string>
+#include <vector>
 
 BOOST_AUTO_TEST_SUITE( document )
 
@@ -124,6 +128,37 @@ BOOST_AUTO_TEST_CASE( assignment_operator )
 }
 
 
+/*
+ * This test checks that copies of a document are independent of each other
+ * and of the node references obtained before copying.
+ */
+
+BOOST_AUTO_TEST_CASE( copy_independent )
+{
+    xml::node n("root", "pcdata");
+    xml::document doc(n);
+    const xml::document& doc_ref = doc;
+    const xml::node& root = doc_ref.get_root_node();
+
+    xml::document doc_copy(doc);
+    doc.set_version("1.1");
+    doc_copy.get_root_node().set_name("changed");
+
+    BOOST_CHECK_EQUAL( root.get_name(), std::string("root") );
+    BOOST_CHECK( &root == &doc_ref.get_root_node() );
+    BOOST_CHECK_EQUAL( doc_copy.get_root_node().get_name(), std::string("changed") );
+
+    // modifying the original must not affect its copies neither
+    xml::node& root_rw = doc.get_root_node();
+    xml::document doc_copy2(doc);
+    root_rw.set_name("other");
+    doc.set_is_standalone(true);
+
+    BOOST_CHECK_EQUAL( doc_copy2.get_root_node().get_name(), std::string("root") );
+    BOOST_CHECK( !doc_copy2.get_is_standalone() );
+}
+
+
 /*
  * This test checks xml::document::get_root_node.
  */
@@ -436,4 +471,257 @@ BOOST_AUTO_TEST_CASE( save_to_file_gzip )
 #endif // !__SUNPRO_CC
 
 
+/*
+ * These tests check that saving documents using several threads gives the
+ * same output as saving them in a single thread.
+ */
+
+namespace
+{
+
+const char *const parallel_save_files[] =
+{
+    "23a", // encoding, DTD, namespaces, nodes before and after the root
+    "23b", // root with mixed content
+    "23c", // deep nesting
+    "23d", // UTF-8
+    "23e"  // no encoding and characters escaped by libxml2
+};
+
+const unsigned parallel_save_threads[] = { 2, 3, 64 };
+
+} // anonymous namespace
+
+BOOST_AUTO_TEST_CASE( save_to_string_parallel )
+{
+    xml::init::substitute_entities(true);
+
+    for (std::size_t i = 0; i < sizeof(parallel_save_files) / sizeof(parallel_save_files[0]); ++i)
+    {
+        const std::string name = std::string("document/data/") + parallel_save_files[i];
+        xml::tree_parser parser(test_file_path(name + ".xml").c_str());
+        const xml::document& doc = parser.get_document();
+
+        for (std::size_t j = 0; j < sizeof(parallel_save_threads) / sizeof(parallel_save_threads[0]); ++j)
+        {
+            std::string xml;
+            doc.save_to_string_parallel(xml, parallel_save_threads[j]);
+            BOOST_CHECK( is_same_as_file(xml, name + ".out") );
+        }
+    }
+}
+
+
+BOOST_AUTO_TEST_CASE( save_to_string_parallel_settings )
+{
+    xml::tree_parser parser(test_file_path("document/data/23c.xml").c_str());
+    const xml::document& doc = parser.get_document();
+
+    // the threads saving the document must use the settings of this one
+    xml::init::indent_output(false);
+
+    std::string sequential, parallel;
+    doc.save_to_string(sequential);
+    doc.save_to_string_parallel(parallel, 4);
+
+    xml::init::indent_output(true);
+
+    BOOST_CHECK_EQUAL( parallel, sequential );
+}
+
+
+BOOST_AUTO_TEST_CASE( save_to_file_parallel )
+{
+    xml::init::substitute_entities(true);
+
+    for (std::size_t i = 0; i < sizeof(parallel_save_files) / sizeof(parallel_save_files[0]); ++i)
+    {
+        const std::string name = std::string("document/data/") + parallel_save_files[i];
+        xml::tree_parser parser(test_file_path(name + ".xml").c_str());
+
+        BOOST_CHECK( parser.get_document().save_to_file_parallel(TEST_FILE, 3) );
+
+        std::ifstream stream(TEST_FILE);
+        BOOST_CHECK( is_same_as_file(read_file_into_string(stream), name + ".out") );
+    }
+
+    remove(TEST_FILE);
+}
+
+
+/*
+ * This test checks that a const document can be read from several threads
+ * at the same time.
+ */
+
+namespace
+{
+
+// read everything using the const API
+void read_node(const xml::node& n, std::string& out)
+{
+    // CDATA nodes have no name
+    if (const char *name = n.get_name())
+        out += name;
+
+    if (const char *content = n.get_content())
+        out += content;
+
+    if (n.get_type() != xml::node::type_element)
+        return;
+
+    const xml::attributes& attrs = n.get_attributes();
+    for (xml::attributes::const_iterator i = attrs.begin(); i != attrs.end(); ++i)
+    {
+        out += i->get_name();
+        out += i->get_value();
+    }
+
+    xml::attributes::const_iterator kind = attrs.find("kind");
+    if (kind != attrs.end())
+        out += kind->get_value();
+
+    for (xml::node::const_iterator i = n.begin(); i != n.end(); ++i)
+        read_node(*i, out);
+}
+
+
+class concurrent_reader
+{
+public:
+    concurrent_reader(const xml::document& doc,
+                      const xml::const_nodes_view& items,
+                      const xml::node::const_iterator& shared_it,
+                      std::string& result)
+        : doc_(doc), items_(items), shared_it_(shared_it), result_(result) {}
+
+    void operator()()
+    {
+        for (int n = 0; n < 20; ++n)
+        {
+            std::string out, xml;
+
+            read_node(doc_.get_root_node(), out);
+
+            for (xml::const_nodes_view::const_iterator i = items_.begin(); i != items_.end(); ++i)
+                read_node(*i, out);
+
+            read_node(*shared_it_, out);
+            shared_it_->node_to_string(xml);
+            out += xml;
+
+            out += doc_.get_encoding();
+            doc_.save_to_string(xml);
+            out += xml;
+
+            if (n == 0)
+            {
+                result_ = out;
+            }
+            else if (out != result_)
+            {
+                result_ = "different results in the same thread";
+                return;
+            }
+        }
+    }
+
+private:
+    const xml::document& doc_;
+    const xml::const_nodes_view& items_;
+    const xml::node::const_iterator& shared_it_;
+    std::string& result_;
+};
+
+} // anonymous namespace
+
+BOOST_AUTO_TEST_CASE( concurrent_const_access )
+{
+    // keep entity references in the tree, so that their values must be
+    // assembled when they are read
+    xml::init::substitute_entities(false);
+    xml::tree_parser parser(test_file_path("document/data/22.xml").c_str());
+    xml::init::substitute_entities(true);
+
+    const xml::document& doc = parser.get_document();
+    const xml::node& root = doc.get_root_node();
+    const xml::const_nodes_view items(root.elements("item"));
+    const xml::node::const_iterator shared_it = root.find("group");
+
+    std::string expected;
+    concurrent_reader(doc, items, shared_it, expected)();
+
+    const int thread_count = 64;
+    std::vector<std::string> results(thread_count);
+
+    boost::thread_group threads;
+    for (int i = 0; i < thread_count; ++i)
+        threads.create_thread(concurrent_reader(doc, items, shared_it, results[i]));
+    threads.join_all();
+
+    for (int i = 0; i < thread_count; ++i)
+        BOOST_CHECK( results[i] == expected );
+
+    // reading must not have modified the document
+    BOOST_CHECK( is_same_as_file(doc, "document/data/22.out") );
+}
+
+
+/*
+ * This test checks that copies of the same document can be modified from
+ * several threads at the same time.
+ */
+
+namespace
+{
+
+class concurrent_writer
+{
+public:
+    concurrent_writer(const xml::document& doc, int id, std::string& result)
+        : doc_(doc), id_(id), result_(result) {}
+
+    void operator()()
+    {
+        xml::document copy(doc_);
+
+        std::ostringstream name;
+        name << "thread" << id_;
+        copy.get_root_node().set_name(name.str().c_str());
+
+        copy.save_to_string(result_);
+    }
+
+private:
+    const xml::document& doc_;
+    int id_;
+    std::string& result_;
+};
+
+} // anonymous namespace
+
+BOOST_AUTO_TEST_CASE( concurrent_copy_modify )
+{
+    xml::node n("root", "pcdata");
+    const xml::document doc(n);
+
+    const int thread_count = 32;
+    std::vector<std::string> results(thread_count);
+
+    boost::thread_group threads;
+    for (int i = 0; i < thread_count; ++i)
+        threads.create_thread(concurrent_writer(doc, i, results[i]));
+    threads.join_all();
+
+    for (int i = 0; i < thread_count; ++i)
+    {
+        std::ostringstream expected;
+        expected << "<?xml version=\"1.0\"?>\n<thread" << i << ">pcdata</thread" << i << ">\n";
+        BOOST_CHECK_EQUAL( results[i], expected.str() );
+    }
+
+    BOOST_CHECK( is_same_as_file( doc, "document/data/04.out") );
+}
+
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,188 @@
+/*
+ * Copyright (C) 2001-2003 Peter J Jones (pjones@pmade.org)
+ * Copyright (C) 2009      Vaclav Slavik (vslavik@gmail.com)
+ * All Rights Reserved
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name of the Author nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ * USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include "../test.h"
+
+#include <boost/thread/thread.hpp>
+
+namespace
+{
+
+const std::string BAD_XML = "<root>\n<a>\n</root>";
+
+bool parse_bad_xml()
+{
+    xml::tree_parser parser(BAD_XML.c_str(), BAD_XML.size(), false);
+    return !parser;
+}
+
+// parses bad XML in another thread and checks that its errors are kept
+// separately
+struct error_thread
+{
+    error_thread(bool& ok) : ok_(ok) { }
+
+    void operator()()
+    {
+        ok_ = xml::error_capture::get_total() == 0 &&
+              parse_bad_xml() &&
+              xml::error_capture::get_total() != 0;
+    }
+
+    bool& ok_;
+};
+
+} // anonymous namespace
+
+
+BOOST_AUTO_TEST_SUITE( errors )
+
+/*
+ * Test that parsing errors are captured and still reported by the parser.
+ */
+
+BOOST_AUTO_TEST_CASE( capture_parser_errors )
+{
+    xml::error_capture::clear();
+    const unsigned long before = xml::error_capture::get_total();
+
+    xml::tree_parser parser(BAD_XML.c_str(), BAD_XML.size(), false);
+    BOOST_CHECK( !parser );
+    BOOST_CHECK( parser.get_error_message().find("mismatch") != std::string::npos );
+
+    BOOST_CHECK( xml::error_capture::get_total() > before );
+
+    const xml::error_capture::errors_type errors = xml::error_capture::get_errors();
+    BOOST_REQUIRE( !errors.empty() );
+    BOOST_CHECK_EQUAL( errors[0].level, xml::error_capture::level_fatal );
+    BOOST_CHECK_EQUAL( errors[0].line, 3 );
+    BOOST_CHECK( errors[0].code != 0 );
+    BOOST_CHECK( errors[0].domain != 0 );
+    BOOST_CHECK( errors[0].message.find("mismatch") != std::string::npos );
+    BOOST_CHECK( errors[0].message[errors[0].message.size() - 1] != '\n' );
+}
+
+/*
+ * Test that the errors are captured by the event parser too.
+ */
+
+class test_event_parser : public xml::event_parser
+{
+private:
+    bool start_element(const std::string&, const attrs_type&) { return true; }
+    bool end_element(const std::string&) { return true; }
+    bool text(const std::string&) { return true; }
+};
+
+BOOST_AUTO_TEST_CASE( capture_event_parser_errors )
+{
+    xml::error_capture::clear();
+
+    test_event_parser parser;
+    BOOST_CHECK( !parser.parse_chunk(BAD_XML.c_str(), BAD_XML.size()) );
+    BOOST_CHECK( parser.get_error_message().find("mismatch") != std::string::npos );
+
+    BOOST_CHECK( !xml::error_capture::get_errors().empty() );
+}
+
+/*
+ * Test that DTD validation errors are captured and still reported.
+ */
+
+BOOST_AUTO_TEST_CASE( capture_validation_errors )
+{
+    const std::string data =
+        "<!DOCTYPE root [ <!ELEMENT root (a)> <!ELEMENT a EMPTY> ]>\n"
+        "<root><b/></root>";
+
+    xml::tree_parser parser(data.c_str(), data.size());
+    BOOST_REQUIRE( parser );
+
+    xml::error_capture::clear();
+
+    BOOST_CHECK( !parser.get_document().validate() );
+
+    const xml::error_capture::errors_type errors = xml::error_capture::get_errors();
+    BOOST_REQUIRE( !errors.empty() );
+    BOOST_CHECK_EQUAL( errors.back().level, xml::error_capture::level_error );
+    BOOST_CHECK( !errors.back().message.empty() );
+}
+
+/*
+ * Test that only the most recent errors are kept.
+ */
+
+BOOST_AUTO_TEST_CASE( capacity )
+{
+    BOOST_CHECK_EQUAL( xml::error_capture::get_capacity(),
+                       xml::error_capture::default_capacity );
+
+    xml::error_capture::clear();
+    xml::error_capture::set_capacity(2);
+    BOOST_CHECK_EQUAL( xml::error_capture::get_capacity(), 2 );
+
+    const unsigned long before = xml::error_capture::get_total();
+    for ( int i = 0; i < 5; ++i )
+        BOOST_CHECK( parse_bad_xml() );
+
+    BOOST_CHECK( xml::error_capture::get_total() - before >= 5 );
+    BOOST_CHECK_EQUAL( xml::error_capture::get_errors().size(), 2 );
+
+    xml::error_capture::set_capacity(1);
+    BOOST_CHECK_EQUAL( xml::error_capture::get_errors().size(), 1 );
+
+    xml::error_capture::set_capacity(0);
+    BOOST_CHECK( xml::error_capture::get_errors().empty() );
+    BOOST_CHECK( parse_bad_xml() );
+    BOOST_CHECK( xml::error_capture::get_errors().empty() );
+
+    xml::error_capture::set_capacity(xml::error_capture::default_capacity);
+}
+
+/*
+ * Test that the errors are kept separately for each thread.
+ */
+
+BOOST_AUTO_TEST_CASE( per_thread )
+{
+    xml::error_capture::clear();
+
+    bool ok = false;
+    boost::thread thread((error_thread(ok)));
+    thread.join();
+
+    BOOST_CHECK( ok );
+    BOOST_CHECK( xml::error_capture::get_errors().empty() );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
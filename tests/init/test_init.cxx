@@ -0,0 +1,97 @@
+/*
+ * Copyright (C) 2001-2003 Peter J Jones (pjones@pmade.org)
+ * Copyright (C) 2009      Vaclav Slavik (vslavik@gmail.com)
+ * All Rights Reserved
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name of the Author nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ * USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+// this file doesn't create the static xml::init object, check that the
+// headers can be used in this way
+#define XMLWRAPP_LAZY_INIT
+
+#include "../test.h"
+
+#include <boost/thread/thread.hpp>
+
+#include <vector>
+
+namespace
+{
+
+const std::string XMLDATA =
+    "<root><a>text</a><b attr='value'/></root>";
+
+// creates and destroys xml::init objects while parsing documents
+struct init_user
+{
+    init_user(bool& ok) : ok_(ok) { }
+
+    void operator()()
+    {
+        ok_ = true;
+        for ( int i = 0; i < 200; ++i )
+        {
+            xml::init init;
+
+            xml::tree_parser parser(XMLDATA.c_str(), XMLDATA.size());
+            if ( !parser || parser.get_document().get_root_node().size() != 2 )
+                ok_ = false;
+        }
+    }
+
+    bool& ok_;
+};
+
+} // anonymous namespace
+
+
+BOOST_AUTO_TEST_SUITE( initialization )
+
+/*
+ * Test that xml::init objects can be used from several threads.
+ */
+
+BOOST_AUTO_TEST_CASE( concurrent_init )
+{
+    const int thread_count = 8;
+    bool ok[thread_count];
+
+    boost::thread_group threads;
+    for ( int i = 0; i < thread_count; ++i )
+        threads.create_thread(init_user(ok[i]));
+    threads.join_all();
+
+    for ( int i = 0; i < thread_count; ++i )
+        BOOST_CHECK( ok[i] );
+
+    xml::tree_parser parser(XMLDATA.c_str(), XMLDATA.size());
+    BOOST_CHECK( parser );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,88 @@
+/*
+ * Copyright (C) 2001-2003 Peter J Jones (pjones@pmade.org)
+ * Copyright (C) 2009      Vaclav Slavik (vslavik@gmail.com)
+ * All Rights Reserved
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name of the Author nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ * USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include "../test.h"
+
+#include <cstdlib>
+
+namespace
+{
+
+void* test_allocate(std::size_t size) { return std::malloc(size); }
+void* test_reallocate(void *ptr, std::size_t size) { return std::realloc(ptr, size); }
+void test_deallocate(void *ptr) { std::free(ptr); }
+
+} // anonymous namespace
+
+
+BOOST_AUTO_TEST_SUITE( memory )
+
+/*
+ * Test that the allocator can't be changed once the library is initialized,
+ * as it is by the static xml::init objects here.
+ */
+
+BOOST_AUTO_TEST_CASE( too_late )
+{
+    xml::memory::allocator alloc = { test_allocate, test_reallocate, test_deallocate };
+
+    BOOST_CHECK_THROW( xml::memory::set_allocator(alloc), xml::exception );
+    BOOST_CHECK_THROW( xml::memory::enable_statistics(), xml::exception );
+    BOOST_CHECK( !xml::memory::statistics_enabled() );
+}
+
+BOOST_AUTO_TEST_CASE( incomplete_allocator )
+{
+    xml::memory::allocator alloc = { test_allocate, 0, test_deallocate };
+
+    BOOST_CHECK_THROW( xml::memory::set_allocator(alloc), xml::exception );
+}
+
+/*
+ * Test that nothing is counted unless the statistics are enabled.
+ */
+
+BOOST_AUTO_TEST_CASE( no_statistics )
+{
+    xml::document doc("root");
+    doc.get_root_node().push_back(xml::node("child", "text"));
+
+    const xml::memory::statistics stats = xml::memory::get_statistics();
+    BOOST_CHECK_EQUAL( stats.allocations, 0 );
+    BOOST_CHECK_EQUAL( stats.deallocations, 0 );
+    BOOST_CHECK_EQUAL( stats.allocated_bytes, 0 );
+    BOOST_CHECK_EQUAL( stats.current_bytes, 0 );
+    BOOST_CHECK_EQUAL( stats.peak_bytes, 0 );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -33,7 +33,12 @@
 
 #include "../test.h"
 
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <functional>
+#include <stdexcept>
+#include <vector>
 
 
 BOOST_AUTO_TEST_SUITE( node )
@@ -333,6 +338,243 @@ BOOST_AUTO_TEST_CASE( erase_returned_iter )
 }
 
 
+BOOST_AUTO_TEST_CASE( erase_by_name )
+{
+    xml::tree_parser parser(test_file_path("node/data/04.xml").c_str());
+
+    xml::node &root = parser.get_document().get_root_node();
+
+    BOOST_CHECK_EQUAL( root.erase("to_remove"), 1 );
+    BOOST_CHECK( is_same_as_file(root, "node/data/04a.out") );
+
+    BOOST_CHECK_EQUAL( root.erase("to_remove"), 0 );
+}
+
+
+/*
+ * This test checks xml::node::remove_if()
+ */
+
+namespace
+{
+
+struct lives_in_state : public std::unary_function<xml::node, bool>
+{
+    lives_in_state(char first) : first_(first) {}
+
+    bool operator() (const xml::node &n)
+    {
+        if (n.get_type() != xml::node::type_element)
+            return false;
+
+        xml::node::const_iterator state = n.find("state");
+        return state != n.end() && state->get_content()[0] == first_;
+    }
+
+    char first_;
+};
+
+}
+
+BOOST_AUTO_TEST_CASE( remove_if )
+{
+    xml::tree_parser parser(test_file_path("node/data/02.xml").c_str());
+
+    xml::node &root = parser.get_document().get_root_node();
+
+    BOOST_CHECK_EQUAL( root.remove_if(lives_in_state('C')), 2 );
+    BOOST_CHECK( is_same_as_file(root, "node/data/02h.out") );
+
+    BOOST_CHECK_EQUAL( root.remove_if(lives_in_state('C')), 0 );
+}
+
+
+/*
+ * These tests check xml::node::insert() and append() with ranges of nodes
+ */
+
+BOOST_AUTO_TEST_CASE( insert_range )
+{
+    xml::tree_parser parser(test_file_path("node/data/04.xml").c_str());
+    xml::node &source = parser.get_document().get_root_node();
+
+    xml::node root("root");
+    root.push_back(xml::node("first"));
+    xml::node::iterator last = root.insert(xml::node("last"));
+
+    xml::node::iterator i = root.insert(last, source.begin(), source.end());
+    BOOST_REQUIRE( i != root.end() );
+    BOOST_CHECK_EQUAL( i->get_name(), std::string("to_remove") );
+
+    // inserting an empty range does nothing
+    i = root.insert(last, source.end(), source.end());
+    BOOST_CHECK( i == last );
+
+    // inserting children of the node itself
+    root.insert(root.end(), root.begin(), root.end());
+
+    BOOST_CHECK( is_same_as_file(root, "node/data/04d.out") );
+}
+
+
+BOOST_AUTO_TEST_CASE( insert_range_text )
+{
+    xml::node root("root");
+    root.push_back(xml::node(xml::node::text("a")));
+    xml::node::iterator e = root.insert(xml::node("e"));
+    xml::node::iterator z = root.insert(xml::node(xml::node::text("z")));
+
+    std::vector<xml::node> nodes;
+    nodes.push_back(xml::node(xml::node::text("b")));
+    nodes.push_back(xml::node("x"));
+    nodes.push_back(xml::node(xml::node::text("c")));
+
+    // text at the start of the range is merged with the preceding text
+    xml::node::iterator i = root.insert(e, nodes.begin(), nodes.end());
+    BOOST_REQUIRE( i == root.begin() );
+    BOOST_CHECK_EQUAL( i->get_content(), std::string("ab") );
+
+    // adjacent text nodes in the range are merged together and then with
+    // the text node they're inserted before
+    nodes.clear();
+    nodes.push_back(xml::node(xml::node::text("1")));
+    nodes.push_back(xml::node(xml::node::text("2")));
+    i = root.insert(z, nodes.begin(), nodes.end());
+    BOOST_CHECK( i == z );
+    BOOST_CHECK_EQUAL( z->get_content(), std::string("12z") );
+
+    std::string children;
+    for (i = root.begin(); i != root.end(); ++i)
+    {
+        children += i->is_text() ? i->get_content() : i->get_name();
+        children += '|';
+    }
+    BOOST_CHECK_EQUAL( children, "ab|x|c|e|12z|" );
+}
+
+
+BOOST_AUTO_TEST_CASE( append_range )
+{
+    std::vector<xml::node> nodes;
+    nodes.push_back(xml::node("one", "1"));
+    nodes.push_back(xml::node("two", "2"));
+
+    xml::node root("root");
+    root.append(nodes);
+
+    xml::tree_parser parser(test_file_path("node/data/02.xml").c_str());
+    root.append(parser.get_document().get_root_node().elements("person"));
+
+    BOOST_CHECK( is_same_as_file(root, "node/data/04e.out") );
+}
+
+
+/*
+ * These tests check xml::node::adopt_from()
+ */
+
+BOOST_AUTO_TEST_CASE( adopt_from )
+{
+    xml::document target("merged");
+    xml::node &root = target.get_root_node();
+    xml::node::iterator end_marker = root.insert(xml::node("end"));
+
+    {
+        xml::tree_parser parser(test_file_path("node/data/15.xml").c_str());
+        xml::document &source = parser.get_document();
+        xml::node &source_root = source.get_root_node();
+
+        xml::node::iterator first = source_root.find("section");
+        BOOST_REQUIRE( first != source_root.end() );
+        xml::node::iterator second = first;
+        second = source_root.find("section", ++second);
+        BOOST_REQUIRE( second != source_root.end() );
+
+        xml::node::iterator i = root.adopt_from(source, second);
+        BOOST_CHECK_EQUAL( i->get_name(), std::string("section") );
+        root.adopt_from(end_marker, source, first);
+
+        BOOST_CHECK( source_root.find("section") == source_root.end() );
+
+        // the source document is destroyed here, the moved nodes must not
+        // refer to it any more
+    }
+
+    BOOST_CHECK( is_same_as_file(target, "node/data/15.out") );
+}
+
+
+BOOST_AUTO_TEST_CASE( adopt_from_text )
+{
+    xml::document source("source");
+    xml::node &source_root = source.get_root_node();
+    // use a separator to avoid merging the two text nodes
+    source_root.push_back(xml::node(xml::node::text("one")));
+    source_root.push_back(xml::node("sep"));
+    source_root.push_back(xml::node(xml::node::text("two")));
+    source_root.erase(source_root.find("sep"));
+
+    xml::document target("target");
+    xml::node &root = target.get_root_node();
+    root.push_back(xml::node(xml::node::text("start")));
+
+    // the adopted text nodes are merged with the existing ones and freed,
+    // the returned iterators must point to the nodes they were merged into
+    xml::node::iterator i = root.adopt_from(source, source_root.begin());
+    BOOST_CHECK( i == root.begin() );
+    BOOST_CHECK_EQUAL( i->get_content(), std::string("startone") );
+
+    root.push_back(xml::node("e"));
+    xml::node::iterator end_text = root.insert(xml::node(xml::node::text("end")));
+    i = root.adopt_from(end_text, source, source_root.begin());
+    BOOST_CHECK( i == end_text );
+    BOOST_CHECK_EQUAL( i->get_content(), std::string("twoend") );
+
+    // the same applies to inserting copies
+    i = root.insert(xml::node(xml::node::text("!")));
+    BOOST_CHECK( i == end_text );
+    BOOST_CHECK_EQUAL( i->get_content(), std::string("twoend!") );
+
+    BOOST_CHECK( source_root.begin() == source_root.end() );
+    BOOST_CHECK_EQUAL( root.get_content(), std::string("startonetwoend!") );
+}
+
+
+BOOST_AUTO_TEST_CASE( adopt_from_invalid )
+{
+    xml::tree_parser parser(test_file_path("node/data/15.xml").c_str());
+    xml::document &source = parser.get_document();
+    xml::node &source_root = source.get_root_node();
+
+    xml::document target("merged");
+    xml::node &root = target.get_root_node();
+
+    // root nodes can't be moved
+    BOOST_CHECK_THROW
+    (
+        root.adopt_from(source, source_root.self()),
+        xml::exception
+    );
+
+    // node not in the given document
+    xml::node::iterator end_marker = root.insert(xml::node("end"));
+    BOOST_CHECK_THROW
+    (
+        root.adopt_from(source, end_marker),
+        xml::exception
+    );
+
+    // node's own ancestor
+    xml::node::iterator section = source_root.find("section");
+    xml::node::iterator title = section->find("title");
+    BOOST_CHECK_THROW
+    (
+        title->adopt_from(source, section),
+        xml::exception
+    );
+}
+
+
 BOOST_AUTO_TEST_CASE( clear )
 {
     xml::tree_parser parser(test_file_path("node/data/04.xml").c_str());
@@ -502,6 +744,80 @@ BOOST_AUTO_TEST_CASE( sort_by_attr )
 }
 
 
+/*
+ * This test checks xml::node::sort() with xml::node::sort_keys
+ */
+
+static void do_sort_by_keys(const xml::node::sort_keys& keys, const char *outfile)
+{
+    xml::init::remove_whitespace(true);
+
+    xml::tree_parser parser(test_file_path("node/data/07c.xml").c_str());
+
+    xml::node &root = parser.get_document().get_root_node();
+    root.sort("book", keys);
+
+    BOOST_CHECK( is_same_as_file(parser.get_document(), outfile) );
+
+    // FIXME: don't rely on the default being 'false', read the current value
+    //        from xml::init
+    xml::init::remove_whitespace(false);
+}
+
+BOOST_AUTO_TEST_CASE( sort_by_keys )
+{
+    xml::node::sort_keys keys("price", xml::node::sort_keys::number);
+    keys.add("title");
+    BOOST_CHECK_EQUAL( keys.size(), 2 );
+    do_sort_by_keys(keys, "node/data/07c.out");
+
+    xml::node::sort_keys desc("price",
+                              xml::node::sort_keys::number,
+                              xml::node::sort_keys::descending);
+    desc.set_stable(true);
+    do_sort_by_keys(desc, "node/data/07d.out");
+}
+
+BOOST_AUTO_TEST_CASE( sort_parallel )
+{
+    xml::node seq("root");
+    for (int i = 0; i < 10000; ++i)
+    {
+        char key[16], id[16];
+        std::sprintf(key, "%d", (i * 7919) % 97);
+        std::sprintf(id, "%d", i);
+
+        xml::node::iterator n = seq.insert(xml::node("item"));
+        n->get_attributes().insert("key", key);
+        n->get_attributes().insert("id", id);
+    }
+    xml::node par(seq);
+
+    xml::node::sort_keys keys("key", xml::node::sort_keys::number);
+    keys.set_stable(true);
+    seq.sort("item", keys);
+
+    keys.set_parallel_threshold(1);
+    par.sort("item", keys);
+
+    std::string seq_str, par_str;
+    seq.node_to_string(seq_str);
+    par.node_to_string(par_str);
+    BOOST_CHECK( seq_str == par_str );
+
+    // with equal keys the original order must be preserved
+    int last_key = -1, last_id = -1;
+    for (xml::node::const_iterator i = par.begin(); i != par.end(); ++i)
+    {
+        int key = std::atoi(i->get_attributes().find("key")->get_value());
+        int id = std::atoi(i->get_attributes().find("id")->get_value());
+        BOOST_CHECK( key > last_key || (key == last_key && id > last_id) );
+        last_key = key;
+        last_id = id;
+    }
+}
+
+
 /*
  * This test checks xml::node::sort_fo
  */
@@ -538,6 +854,42 @@ BOOST_AUTO_TEST_CASE( sort_with_predicate )
     xml::init::remove_whitespace(false);
 }
 
+namespace
+{
+
+struct throwing_sort_cmp : public std::binary_function<xml::node, xml::node, bool>
+{
+    throwing_sort_cmp() : calls_(0) {}
+
+    bool operator() (const xml::node &lhs, const xml::node &rhs)
+    {
+        if (++calls_ == 3)
+            throw std::runtime_error("comparison failed");
+        return std::strcmp(lhs.get_name(), rhs.get_name()) < 0;
+    }
+
+    int calls_;
+};
+
+}
+
+BOOST_AUTO_TEST_CASE( sort_with_throwing_predicate )
+{
+    xml::tree_parser parser(test_file_path("node/data/08a.xml").c_str());
+
+    xml::node &root = parser.get_document().get_root_node();
+    std::string before;
+    root.node_to_string(before);
+
+    throwing_sort_cmp cmp;
+    BOOST_CHECK_THROW( root.sort(cmp), std::runtime_error );
+
+    // the children must not be lost or reordered
+    std::string after;
+    root.node_to_string(after);
+    BOOST_CHECK( before == after );
+}
+
 
 /*
  * This test checks xml::node::node(text)
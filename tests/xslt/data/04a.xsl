@@ -0,0 +1,7 @@
+<xsl:stylesheet version="1.0" xmlns:xsl="http://www.w3.org/1999/XSL/Transform">
+<xsl:output method="xml"/>
+<xsl:template match="/"><out><xsl:apply-templates/></out></xsl:template>
+<xsl:template match="root"><xsl:apply-templates select="child"/></xsl:template>
+<xsl:template match="child"><xsl:call-template name="item"/></xsl:template>
+<xsl:template name="item"><item/></xsl:template>
+</xsl:stylesheet>
@@ -0,0 +1,5 @@
+<xsl:stylesheet version="1.0" xmlns:xsl="http://www.w3.org/1999/XSL/Transform">
+<xsl:output method="xml"/>
+<xsl:template match="root[@fail]"><xsl:message terminate="yes">failure requested</xsl:message></xsl:template>
+<xsl:template match="root"><out><xsl:value-of select="count(child)"/></out></xsl:template>
+</xsl:stylesheet>
@@ -0,0 +1,4 @@
+<xsl:stylesheet version="1.0" xmlns:xsl="http://www.w3.org/1999/XSL/Transform">
+<xsl:output method="xml"/>
+<xsl:template match="/root"><list><xsl:for-each select="child"><entry n="{position()}"/></xsl:for-each></list></xsl:template>
+</xsl:stylesheet>
@@ -0,0 +1,5 @@
+<xsl:stylesheet version="1.0" xmlns:xsl="http://www.w3.org/1999/XSL/Transform">
+<xsl:output method="html" indent="no" encoding="us-ascii"/>
+<xsl:param name="title" select="'none'"/>
+<xsl:template match="/list"><HTML><BODY><H1><xsl:value-of select="$title"/></H1><xsl:for-each select="entry"><P><xsl:value-of select="@n"/></P></xsl:for-each></BODY></HTML></xsl:template>
+</xsl:stylesheet>
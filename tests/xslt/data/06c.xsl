@@ -0,0 +1,4 @@
+<xsl:stylesheet version="1.0" xmlns:xsl="http://www.w3.org/1999/XSL/Transform">
+<xsl:output method="xml"/>
+<xsl:template match="/"><count><xsl:value-of select="count(HTML/BODY/H3)"/></count></xsl:template>
+</xsl:stylesheet>
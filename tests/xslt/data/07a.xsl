@@ -0,0 +1,17 @@
+<xsl:stylesheet version="1.0"
+    xmlns:xsl="http://www.w3.org/1999/XSL/Transform"
+    xmlns:my="http://xmlwrapp.example/ext"
+    exclude-result-prefixes="my">
+<xsl:output method="xml"/>
+<xsl:template match="/root">
+<out>
+<upper><xsl:value-of select="my:upper(@name)"/></upper>
+<sum><xsl:value-of select="my:sum(2, 3.5, child)"/></sum>
+<types><xsl:value-of select="my:types(child, true(), 1, 'x')"/></types>
+<tokens><xsl:for-each select="my:split('a,b,c', ',')"><t><xsl:value-of select="."/></t></xsl:for-each></tokens>
+<last><xsl:value-of select="my:last(child)/@n"/></last>
+<empty><xsl:value-of select="my:nothing()"/></empty>
+<available><xsl:value-of select="function-available('my:upper')"/></available>
+</out>
+</xsl:template>
+</xsl:stylesheet>
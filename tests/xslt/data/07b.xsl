@@ -0,0 +1,5 @@
+<xsl:stylesheet version="1.0"
+    xmlns:xsl="http://www.w3.org/1999/XSL/Transform"
+    xmlns:my="http://xmlwrapp.example/ext">
+<xsl:template match="/"><out><xsl:value-of select="my:fail()"/></out></xsl:template>
+</xsl:stylesheet>
@@ -0,0 +1,40 @@
+<xsl:stylesheet version="1.0" xmlns:xsl="http://www.w3.org/1999/XSL/Transform">
+<xsl:output method="xml"/>
+<xsl:param name="depth" select="10"/>
+<xsl:param name="vars" select="0"/>
+<xsl:param name="calls" select="0"/>
+
+<xsl:template match="/">
+  <out>
+    <xsl:call-template name="nested"><xsl:with-param name="n" select="$depth"/></xsl:call-template>
+    <xsl:call-template name="variables"><xsl:with-param name="n" select="$vars"/></xsl:call-template>
+    <xsl:call-template name="exponential"><xsl:with-param name="n" select="$calls"/></xsl:call-template>
+  </out>
+</xsl:template>
+
+<xsl:template name="nested">
+  <xsl:param name="n"/>
+  <xsl:if test="$n > 0">
+    <xsl:call-template name="nested"><xsl:with-param name="n" select="$n - 1"/></xsl:call-template>
+  </xsl:if>
+</xsl:template>
+
+<xsl:template name="variables">
+  <xsl:param name="n"/>
+  <xsl:variable name="a" select="1"/>
+  <xsl:variable name="b" select="2"/>
+  <xsl:variable name="c" select="3"/>
+  <xsl:if test="$n > 0">
+    <xsl:call-template name="variables"><xsl:with-param name="n" select="$n - 1"/></xsl:call-template>
+  </xsl:if>
+</xsl:template>
+
+<xsl:template name="exponential">
+  <xsl:param name="n"/>
+  <xsl:if test="$n > 0">
+    <xsl:call-template name="exponential"><xsl:with-param name="n" select="$n - 1"/></xsl:call-template>
+    <xsl:call-template name="exponential"><xsl:with-param name="n" select="$n - 1"/></xsl:call-template>
+  </xsl:if>
+</xsl:template>
+
+</xsl:stylesheet>
@@ -0,0 +1,17 @@
+<xsl:stylesheet version="1.0" xmlns:xsl="http://www.w3.org/1999/XSL/Transform">
+<xsl:output method="text"/>
+<xsl:key name="by-group" match="item" use="@group"/>
+<xsl:param name="label" select="'none'"/>
+<xsl:variable name="count" select="count(//item)"/>
+<xsl:variable name="first"><name><xsl:value-of select="//item[1]/@name"/></name></xsl:variable>
+
+<xsl:template match="/">
+  <xsl:if test="//item[@fail]"><xsl:message terminate="yes">failure requested</xsl:message></xsl:if>
+  <xsl:value-of select="concat($label, ':', $count, ':', $first, ':', count(key('by-group', 'a')), ':')"/>
+  <xsl:apply-templates select="list/item"/>
+</xsl:template>
+
+<xsl:template match="item[2]">[<xsl:value-of select="@name"/>]</xsl:template>
+<xsl:template match="item"><xsl:value-of select="@name"/></xsl:template>
+
+</xsl:stylesheet>
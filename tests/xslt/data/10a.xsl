@@ -0,0 +1,5 @@
+<xsl:stylesheet version="1.0" xmlns:xsl="http://www.w3.org/1999/XSL/Transform">
+<xsl:import href="10b.xsl"/>
+<xsl:output method="xml"/>
+<xsl:template match="/root"><result><xsl:call-template name="exslt"/></result></xsl:template>
+</xsl:stylesheet>
@@ -0,0 +1,6 @@
+<xsl:stylesheet version="1.0" xmlns:xsl="http://www.w3.org/1999/XSL/Transform"
+                xmlns:math="http://exslt.org/math"
+                xmlns:str="http://exslt.org/strings"
+                exclude-result-prefixes="math str">
+<xsl:template name="exslt"><max><xsl:value-of select="math:max(str:tokenize('3 17 5'))"/></max><count><xsl:value-of select="count(child)"/></count></xsl:template>
+</xsl:stylesheet>
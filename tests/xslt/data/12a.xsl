@@ -0,0 +1,12 @@
+<xsl:stylesheet version="1.0" xmlns:xsl="http://www.w3.org/1999/XSL/Transform">
+<xsl:output method="xml" omit-xml-declaration="yes"/>
+
+<xsl:template match="/">
+  <out><xsl:apply-templates select="list/item"/></out>
+</xsl:template>
+
+<xsl:template match="item">
+  <xsl:element name="{@name}"><xsl:value-of select="@group"/></xsl:element>
+</xsl:template>
+
+</xsl:stylesheet>
@@ -0,0 +1,17 @@
+<xsl:stylesheet version="1.0" xmlns:xsl="http://www.w3.org/1999/XSL/Transform">
+<xsl:output method="xml" omit-xml-declaration="yes"/>
+<xsl:key name="by-group" match="item" use="@group"/>
+<xsl:param name="label" select="'none'"/>
+<xsl:variable name="count" select="count(//item)"/>
+<xsl:variable name="names"><xsl:for-each select="//item"><n><xsl:value-of select="@name"/></n></xsl:for-each></xsl:variable>
+
+<xsl:template match="/">
+  <out label="{$label}" count="{$count}" id="{generate-id(list)}">
+    <xsl:for-each select="key('by-group', 'a')">
+      <a id="{generate-id()}"><xsl:value-of select="@name"/></a>
+    </xsl:for-each>
+    <xsl:copy-of select="$names"/>
+  </out>
+</xsl:template>
+
+</xsl:stylesheet>
@@ -35,6 +35,17 @@
 
 #include <xsltwrapp/xsltwrapp.h>
 
+#include <boost/thread/thread.hpp>
+
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
 BOOST_AUTO_TEST_SUITE( xslt )
 
 
@@ -65,6 +76,19 @@ BOOST_AUTO_TEST_CASE( creation_fail2 )
     );
 }
 
+BOOST_AUTO_TEST_CASE( creation_fail_captured )
+{
+    xml::error_capture::clear();
+
+    BOOST_CHECK_THROW
+    (
+        xslt::stylesheet style1(test_file_path("xslt/data/01a.xsl").c_str()),
+        xml::exception
+    );
+
+    BOOST_CHECK( !xml::error_capture::get_errors().empty() );
+}
+
 
 /*
  * Test the first form of apply()
@@ -157,4 +181,1424 @@ BOOST_AUTO_TEST_CASE( xsl_with_errors_throw )
 }
 
 
+/*
+ * Test transform() returning the result and errors of each call
+ */
+
+BOOST_AUTO_TEST_CASE( transform )
+{
+    const xslt::stylesheet style(test_file_path("xslt/data/02a.xsl").c_str());
+    xml::tree_parser parser(test_file_path("xslt/data/input.xml").c_str());
+
+    xslt::transform_result result = style.transform(parser.get_document());
+    BOOST_CHECK( result.is_successful() );
+    BOOST_CHECK( result.get_error_message().empty() );
+    BOOST_CHECK( is_same_as_file(result.get_document(), "xslt/data/02a.out") );
+}
+
+/*
+ * Test that transforming a copy of a document doesn't modify the tree it
+ * shared with the original: libxslt removes the whitespace-only text nodes
+ * of its input for xsl:strip-space.
+ */
+
+BOOST_AUTO_TEST_CASE( transform_shared_copy )
+{
+    const xslt::stylesheet style(test_file_path("xslt/data/11a.xsl").c_str());
+    xml::tree_parser parser(test_file_path("xslt/data/input.xml").c_str());
+    const xml::document& doc = parser.get_document();
+
+    std::string before;
+    doc.save_to_string(before);
+
+    const xml::document copy(doc);
+    BOOST_CHECK( style.transform(copy).is_successful() );
+
+    std::ostringstream ostr;
+    style.transform_to(xml::document(doc), ostr);
+    BOOST_CHECK_EQUAL( ostr.str(), "2" );
+
+    xml::document result;
+    xslt::stylesheet style_apply(test_file_path("xslt/data/11a.xsl").c_str());
+    BOOST_CHECK( style_apply.apply(xml::document(doc), result) );
+
+    std::string after;
+    doc.save_to_string(after);
+    BOOST_CHECK_EQUAL( before, after );
+    BOOST_CHECK_EQUAL( doc.get_root_node().size(), 5 );
+}
+
+BOOST_AUTO_TEST_CASE( transform_params )
+{
+    const xslt::stylesheet style(test_file_path("xslt/data/03a.xsl").c_str());
+    xml::tree_parser parser(test_file_path("xslt/data/input.xml").c_str());
+
+    xslt::stylesheet::param_type params;
+    params["foo"] = "'bar'";
+
+    xslt::transform_result result = style.transform(parser.get_document(), params);
+    BOOST_CHECK( result.is_successful() );
+    BOOST_CHECK( is_same_as_file(result.get_document(), "xslt/data/03a.out") );
+}
+
+BOOST_AUTO_TEST_CASE( transform_with_errors )
+{
+    const xslt::stylesheet style(test_file_path("xslt/data/with_errors.xsl").c_str());
+    xml::tree_parser parser(test_file_path("xslt/data/input.xml").c_str());
+
+    xslt::transform_result result1 = style.transform(parser.get_document());
+    BOOST_CHECK( !result1.is_successful() );
+    BOOST_CHECK( !result1.get_error_message().empty() );
+
+    // errors of the previous transformation must not be repeated
+    xslt::transform_result result2 = style.transform(parser.get_document());
+    BOOST_CHECK_EQUAL( result2.get_error_message(), result1.get_error_message() );
+}
+
+
+/*
+ * This test checks that a single stylesheet can be used to transform
+ * documents from several threads at the same time.
+ */
+
+namespace
+{
+
+class concurrent_transformer
+{
+public:
+    concurrent_transformer(const xslt::stylesheet& style,
+                           const xslt::stylesheet& style_with_errors,
+                           int id,
+                           std::string& result,
+                           std::string& error)
+        : style_(style),
+          style_with_errors_(style_with_errors),
+          id_(id),
+          result_(result),
+          error_(error)
+    {
+    }
+
+    void operator()()
+    {
+        // libxslt modifies the input document, so each thread needs its own
+        xml::tree_parser parser(test_file_path("xslt/data/input.xml").c_str());
+        const xml::document& input = parser.get_document();
+
+        std::ostringstream value;
+        value << "'thread" << id_ << "'";
+
+        xslt::stylesheet::param_type params;
+        params["foo"] = value.str();
+
+        xslt::params string_params;
+        string_params.set_string("foo", value.str().substr(1, value.str().size() - 2).c_str());
+
+        for ( int i = 0; i < 10; ++i )
+        {
+            xslt::transform_result r = i % 2 ? style_.transform(input, params)
+                                             : style_.transform(input, string_params);
+            if ( !r.is_successful() )
+            {
+                result_ = r.get_error_message();
+                return;
+            }
+            r.get_document().save_to_string(result_);
+
+            r = style_with_errors_.transform(input);
+            if ( r.is_successful() )
+            {
+                error_.clear();
+                return;
+            }
+            error_ = r.get_error_message();
+        }
+    }
+
+private:
+    const xslt::stylesheet& style_;
+    const xslt::stylesheet& style_with_errors_;
+    int id_;
+    std::string& result_;
+    std::string& error_;
+};
+
+} // anonymous namespace
+
+BOOST_AUTO_TEST_CASE( concurrent_transform )
+{
+    const xslt::stylesheet style(test_file_path("xslt/data/03a.xsl").c_str());
+    const xslt::stylesheet
+        style_with_errors(test_file_path("xslt/data/with_errors.xsl").c_str());
+
+    xml::tree_parser parser(test_file_path("xslt/data/input.xml").c_str());
+    const std::string expected_error =
+        style_with_errors.transform(parser.get_document()).get_error_message();
+
+    const int thread_count = 16;
+    std::vector<std::string> results(thread_count);
+    std::vector<std::string> errors(thread_count);
+
+    boost::thread_group threads;
+    for ( int i = 0; i < thread_count; ++i )
+    {
+        threads.create_thread(concurrent_transformer(style, style_with_errors,
+                                                     i, results[i], errors[i]));
+    }
+    threads.join_all();
+
+    for ( int i = 0; i < thread_count; ++i )
+    {
+        std::ostringstream expected;
+        expected << "<HTML><BODY>foo == thread" << i << "<H1>root</H1>\n"
+                    "    <H3>child</H3>\n"
+                    "    <H3>child</H3>\n"
+                    "</BODY></HTML>\n";
+        BOOST_CHECK_EQUAL( results[i], expected.str() );
+        BOOST_CHECK_EQUAL( errors[i], expected_error );
+    }
+}
+
+
+/*
+ * Test reusing the transformation contexts for different documents
+ */
+
+namespace
+{
+
+xml::document make_items_document(int n, bool fail)
+{
+    xml::document doc("list");
+    for ( int i = 0; i < n; ++i )
+    {
+        std::ostringstream name;
+        name << "i" << n << "_" << i;
+
+        xml::node item("item");
+        item.get_attributes().insert("name", name.str().c_str());
+        item.get_attributes().insert("group", i % 2 ? "b" : "a");
+        if ( fail )
+            item.get_attributes().insert("fail", "yes");
+        doc.get_root_node().push_back(item);
+    }
+    return doc;
+}
+
+std::string expected_items_output(int n, const std::string& label)
+{
+    std::ostringstream out;
+    out << label << ":" << n << ":i" << n << "_0:" << (n + 1) / 2 << ":";
+    for ( int i = 0; i < n; ++i )
+    {
+        if ( i == 1 )
+            out << "[i" << n << "_1]";
+        else
+            out << "i" << n << "_" << i;
+    }
+    return out.str();
+}
+
+} // anonymous namespace
+
+BOOST_AUTO_TEST_CASE( transform_reuse_context )
+{
+    const xslt::stylesheet style(test_file_path("xslt/data/09a.xsl").c_str());
+
+    for ( int n = 1; n < 50; ++n )
+    {
+        std::ostringstream label;
+        label << "run" << n;
+        xslt::params params;
+        params.set_string("label", label.str().c_str());
+
+        xslt::transform_result r = style.transform(make_items_document(n, false), params);
+        BOOST_REQUIRE( r.is_successful() );
+
+        std::string output;
+        r.get_document().save_to_string(output);
+        BOOST_CHECK_EQUAL( output, expected_items_output(n, label.str()) );
+
+        // failed transformations must not affect the following ones
+        if ( n % 10 == 0 )
+        {
+            r = style.transform(make_items_document(n, true));
+            BOOST_CHECK( !r.is_successful() );
+        }
+    }
+
+    xslt::transform_result r = style.transform(make_items_document(3, false));
+    std::string output;
+    r.get_document().save_to_string(output);
+    BOOST_CHECK_EQUAL( output, expected_items_output(3, "none") );
+}
+
+
+BOOST_AUTO_TEST_CASE( transform_reuse_context_fresh )
+{
+    const std::string path = test_file_path("xslt/data/13a.xsl");
+    const xslt::stylesheet pooled(path.c_str());
+
+    for ( int n = 1; n < 10; ++n )
+    {
+        std::ostringstream label;
+        label << "run" << n;
+        xslt::params params;
+        params.set_string("label", label.str().c_str());
+
+        // every transformation after the first one reuses the context, which
+        // used keys, global variables and generate-id() the last time
+        const xml::document doc = make_items_document(n, false);
+        xslt::transform_result r = pooled.transform(doc, params);
+        BOOST_REQUIRE( r.is_successful() );
+
+        std::string output;
+        r.get_document().save_to_string(output);
+
+        const xslt::stylesheet fresh(path.c_str());
+        xslt::transform_result r_fresh = fresh.transform(doc, params);
+        BOOST_REQUIRE( r_fresh.is_successful() );
+
+        std::string output_fresh;
+        r_fresh.get_document().save_to_string(output_fresh);
+
+        BOOST_CHECK_EQUAL( output, output_fresh );
+    }
+}
+
+
+namespace
+{
+
+std::string expected_elements_output(int n, const std::string& extra)
+{
+    std::ostringstream out;
+    out << "<out>";
+    for ( int i = 0; i < n; ++i )
+        out << "<i" << n << "_" << i << ">" << (i % 2 ? "b" : "a")
+            << "</i" << n << "_" << i << ">";
+    out << extra << "</out>\n";
+    return out.str();
+}
+
+// modifies a result created by another thread while transforming new
+// documents, reusing the context which produced that result
+class result_modifier
+{
+public:
+    result_modifier(const xslt::stylesheet& style,
+                    xslt::transform_result& old,
+                    int id,
+                    std::string& old_output,
+                    std::string& error)
+        : style_(style), old_(old), id_(id),
+          old_output_(old_output), error_(error)
+    {
+    }
+
+    void operator()()
+    {
+        xml::node& root = old_.get_document().get_root_node();
+        for ( int i = 0; i < 20; ++i )
+        {
+            // new names must be added to the dictionary of the old result
+            std::ostringstream name;
+            name << "t" << id_ << "_" << i;
+            xml::node::iterator it = root.insert(xml::node(name.str().c_str()));
+            it->get_attributes().insert(name.str().c_str(), "x");
+
+            const int n = 10 + id_ * 20 + i;
+            xslt::transform_result r = style_.transform(make_items_document(n, false));
+            std::string output;
+            r.get_document().save_to_string(output);
+            if ( output != expected_elements_output(n, "") )
+            {
+                error_ = output;
+                return;
+            }
+        }
+
+        old_.get_document().save_to_string(old_output_);
+    }
+
+private:
+    const xslt::stylesheet& style_;
+    xslt::transform_result& old_;
+    int id_;
+    std::string& old_output_;
+    std::string& error_;
+};
+
+} // anonymous namespace
+
+BOOST_AUTO_TEST_CASE( transform_reuse_context_threads )
+{
+    const xslt::stylesheet style(test_file_path("xslt/data/12a.xsl").c_str());
+
+    // keep the results alive while their contexts are reused by other threads
+    const int thread_count = 8;
+    std::vector<xslt::transform_result> results;
+    for ( int i = 0; i < thread_count; ++i )
+    {
+        results.push_back(style.transform(make_items_document(i + 1, false)));
+        BOOST_REQUIRE( results.back().is_successful() );
+    }
+
+    std::vector<std::string> outputs(thread_count);
+    std::vector<std::string> errors(thread_count);
+
+    boost::thread_group threads;
+    for ( int i = 0; i < thread_count; ++i )
+    {
+        threads.create_thread(result_modifier(style, results[i], i,
+                                              outputs[i], errors[i]));
+    }
+    threads.join_all();
+
+    for ( int i = 0; i < thread_count; ++i )
+    {
+        std::ostringstream extra;
+        for ( int j = 0; j < 20; ++j )
+            extra << "<t" << i << "_" << j << " t" << i << "_" << j << "=\"x\"/>";
+
+        BOOST_CHECK_EQUAL( errors[i], "" );
+        BOOST_CHECK_EQUAL( outputs[i], expected_elements_output(i + 1, extra.str()) );
+    }
+}
+
+
+/*
+ * Test transform_to() writing the output directly
+ */
+
+BOOST_AUTO_TEST_CASE( transform_to_stream )
+{
+    const xslt::stylesheet style(test_file_path("xslt/data/02a.xsl").c_str());
+    xml::tree_parser parser(test_file_path("xslt/data/input.xml").c_str());
+
+    std::ostringstream output;
+    xslt::transform_result result = style.transform_to(parser.get_document(), output);
+    BOOST_CHECK( result.is_successful() );
+    BOOST_CHECK( is_same_as_file(output, "xslt/data/02a.out") );
+
+    // the result tree is not kept by default
+    BOOST_CHECK( result.get_document().get_root_node().get_name() == std::string("blank") );
+}
+
+BOOST_AUTO_TEST_CASE( transform_to_stream_params )
+{
+    const xslt::stylesheet style(test_file_path("xslt/data/03a.xsl").c_str());
+    xml::tree_parser parser(test_file_path("xslt/data/input.xml").c_str());
+
+    xslt::stylesheet::param_type params;
+    params["foo"] = "'bar'";
+
+    std::ostringstream output;
+    xslt::transform_result result =
+        style.transform_to(parser.get_document(), output, params, true);
+    BOOST_CHECK( result.is_successful() );
+    BOOST_CHECK( is_same_as_file(output, "xslt/data/03a.out") );
+    BOOST_CHECK( is_same_as_file(result.get_document(), "xslt/data/03a.out") );
+}
+
+BOOST_AUTO_TEST_CASE( transform_to_stream_errors )
+{
+    const xslt::stylesheet style(test_file_path("xslt/data/with_errors.xsl").c_str());
+    xml::tree_parser parser(test_file_path("xslt/data/input.xml").c_str());
+
+    std::ostringstream output;
+    xslt::transform_result result = style.transform_to(parser.get_document(), output);
+    BOOST_CHECK( !result.is_successful() );
+    BOOST_CHECK( !result.get_error_message().empty() );
+    BOOST_CHECK( output.str().empty() );
+}
+
+BOOST_AUTO_TEST_CASE( transform_to_bad_stream )
+{
+    const xslt::stylesheet style(test_file_path("xslt/data/02a.xsl").c_str());
+    xml::tree_parser parser(test_file_path("xslt/data/input.xml").c_str());
+
+    std::ostringstream output;
+    output.setstate(std::ios::badbit);
+
+    xslt::transform_result result = style.transform_to(parser.get_document(), output);
+    BOOST_CHECK( !result.is_successful() );
+    BOOST_CHECK( !result.get_error_message().empty() );
+}
+
+BOOST_AUTO_TEST_CASE( transform_to_fd )
+{
+    static const char *TEST_FILE = "test_temp_file";
+
+    const xslt::stylesheet style(test_file_path("xslt/data/02a.xsl").c_str());
+    xml::tree_parser parser(test_file_path("xslt/data/input.xml").c_str());
+
+    std::FILE *f = std::fopen(TEST_FILE, "wb");
+    BOOST_REQUIRE( f );
+    xslt::transform_result result = style.transform_to(parser.get_document(), fileno(f));
+    std::fclose(f);
+
+    BOOST_CHECK( result.is_successful() );
+
+    std::ifstream stream(TEST_FILE);
+    BOOST_CHECK( is_same_as_file(read_file_into_string(stream), "xslt/data/02a.out") );
+    stream.close();
+
+    remove(TEST_FILE);
+}
+
+
+/*
+ * Test xslt::params
+ */
+
+namespace
+{
+
+std::string expected_03a_output(const std::string& foo)
+{
+    return "<HTML><BODY>foo == " + foo + "<H1>root</H1>\n"
+           "    <H3>child</H3>\n"
+           "    <H3>child</H3>\n"
+           "</BODY></HTML>\n";
+}
+
+} // anonymous namespace
+
+BOOST_AUTO_TEST_CASE( params_xpath )
+{
+    const xslt::stylesheet style(test_file_path("xslt/data/03a.xsl").c_str());
+    xml::tree_parser parser(test_file_path("xslt/data/input.xml").c_str());
+
+    xslt::params params;
+    BOOST_CHECK( params.empty() );
+
+    params.set("foo", "'bar'");
+    BOOST_CHECK_EQUAL( params.size(), 1 );
+
+    xslt::transform_result result = style.transform(parser.get_document(), params);
+    BOOST_CHECK( is_same_as_file(result.get_document(), "xslt/data/03a.out") );
+
+    params.set("foo", "6 * 7");
+    BOOST_CHECK_EQUAL( params.size(), 1 );
+
+    std::ostringstream output;
+    style.transform_to(parser.get_document(), output, params);
+    BOOST_CHECK_EQUAL( output.str(), expected_03a_output("42") );
+}
+
+BOOST_AUTO_TEST_CASE( params_string )
+{
+    const xslt::stylesheet style(test_file_path("xslt/data/03a.xsl").c_str());
+    xml::tree_parser parser(test_file_path("xslt/data/input.xml").c_str());
+
+    // no quoting is needed, so any characters can be used
+    xslt::params params;
+    params.set_string("foo", "it's \"quoted\"");
+
+    std::ostringstream output;
+    style.transform_to(parser.get_document(), output, params);
+    BOOST_CHECK_EQUAL( output.str(), expected_03a_output("it's \"quoted\"") );
+
+    params.erase("foo");
+    BOOST_CHECK( params.empty() );
+
+    std::ostringstream output_default;
+    style.transform_to(parser.get_document(), output_default, params);
+    BOOST_CHECK_EQUAL( output_default.str(), expected_03a_output("default") );
+}
+
+BOOST_AUTO_TEST_CASE( params_from_map )
+{
+    xslt::stylesheet style(test_file_path("xslt/data/03a.xsl").c_str());
+    xml::tree_parser parser(test_file_path("xslt/data/input.xml").c_str());
+
+    xslt::stylesheet::param_type map;
+    map["foo"] = "'bar'";
+    const xslt::params params(map);
+
+    // the same parameters can be used any number of times
+    for ( int i = 0; i < 3; ++i )
+    {
+        xml::document result;
+        BOOST_CHECK( style.apply(parser.get_document(), result, params) );
+        BOOST_CHECK( is_same_as_file(result, "xslt/data/03a.out") );
+
+        BOOST_CHECK( is_same_as_file(style.apply(parser.get_document(), params),
+                                     "xslt/data/03a.out") );
+    }
+
+    xslt::params copy(params);
+    copy.clear();
+    BOOST_CHECK( copy.empty() );
+    BOOST_CHECK_EQUAL( params.size(), 1 );
+}
+
+BOOST_AUTO_TEST_CASE( params_invalid )
+{
+    xslt::params params;
+
+    BOOST_CHECK_THROW( params.set("foo", "1 +"), xml::exception );
+    BOOST_CHECK( params.empty() );
+}
+
+
+/*
+ * Test profiling
+ */
+
+namespace
+{
+
+const xslt::profile_report::template_info*
+find_template(const xslt::profile_report& report,
+              const std::string& name,
+              const std::string& match)
+{
+    const xslt::profile_report::templates_type& templates = report.get_templates();
+    for ( std::size_t i = 0; i < templates.size(); ++i )
+    {
+        if ( templates[i].name == name && templates[i].match == match )
+            return &templates[i];
+    }
+    return 0;
+}
+
+void check_profile(const xslt::profile_report& report)
+{
+    BOOST_REQUIRE_EQUAL( report.get_templates().size(), 4 );
+
+    const xslt::profile_report::template_info *top = find_template(report, "", "/");
+    const xslt::profile_report::template_info *root = find_template(report, "", "root");
+    const xslt::profile_report::template_info *child = find_template(report, "", "child");
+    const xslt::profile_report::template_info *item = find_template(report, "item", "");
+    BOOST_REQUIRE( top && root && child && item );
+
+    BOOST_CHECK_EQUAL( top->calls, 1 );
+    BOOST_CHECK_EQUAL( root->calls, 1 );
+    BOOST_CHECK_EQUAL( child->calls, 2 );
+    BOOST_CHECK_EQUAL( item->calls, 2 );
+
+    // the template at the top includes the time of all the others
+    double self_sum = 0;
+    for ( std::size_t i = 0; i < report.get_templates().size(); ++i )
+    {
+        const xslt::profile_report::template_info& t = report.get_templates()[i];
+        // libxslt measures time in units of 10us, so these tiny templates
+        // may well take no time at all
+        BOOST_CHECK( t.self_time >= 0 );
+        BOOST_CHECK( t.total_time >= t.self_time );
+        self_sum += t.self_time;
+
+        if ( i > 0 )
+            BOOST_CHECK( report.get_templates()[i - 1].self_time >= t.self_time );
+    }
+
+    BOOST_CHECK_SMALL( top->total_time - self_sum, 1e-9 );
+    BOOST_CHECK_SMALL( item->total_time - item->self_time, 1e-9 );
+    BOOST_CHECK( report.get_total_time() >= 0 );
+}
+
+} // anonymous namespace
+
+BOOST_AUTO_TEST_CASE( profile_apply )
+{
+    xslt::stylesheet style(test_file_path("xslt/data/04a.xsl").c_str());
+    xml::tree_parser parser(test_file_path("xslt/data/input.xml").c_str());
+
+    xslt::profile_report report;
+    BOOST_CHECK( report.get_templates().empty() );
+
+    xml::document result;
+    BOOST_CHECK( style.apply(parser.get_document(), result, report) );
+    BOOST_CHECK( is_same_as_file(result, "xslt/data/04a.out") );
+    check_profile(report);
+
+    // the counters must not accumulate over several transformations
+    xml::document result2;
+    BOOST_CHECK( style.apply(parser.get_document(), result2, report) );
+    check_profile(report);
+}
+
+BOOST_AUTO_TEST_CASE( profile_transform )
+{
+    const xslt::stylesheet style(test_file_path("xslt/data/04a.xsl").c_str());
+    xml::tree_parser parser(test_file_path("xslt/data/input.xml").c_str());
+
+    xslt::profile_report report;
+    xslt::transform_result result =
+        style.transform(parser.get_document(), xslt::params(), report);
+    BOOST_CHECK( result.is_successful() );
+    BOOST_CHECK( is_same_as_file(result.get_document(), "xslt/data/04a.out") );
+    check_profile(report);
+
+    xslt::profile_report copy(report);
+    BOOST_CHECK_EQUAL( copy.get_templates().size(), 4 );
+}
+
+
+/*
+ * Test transforming batches of documents
+ */
+
+namespace
+{
+
+std::string expected_05a_output(std::size_t count)
+{
+    std::ostringstream s;
+    s << "<?xml version=\"1.0\"?>\n<out>" << count << "</out>\n";
+    return s.str();
+}
+
+} // anonymous namespace
+
+BOOST_AUTO_TEST_CASE( transform_batch_docs )
+{
+    const xslt::stylesheet style(test_file_path("xslt/data/05a.xsl").c_str());
+
+    std::vector<xml::document> docs;
+    for ( std::size_t i = 0; i < 50; ++i )
+    {
+        xml::document doc("root");
+        for ( std::size_t n = 0; n < i; ++n )
+            doc.get_root_node().push_back(xml::node("child"));
+        if ( i % 7 == 3 )
+            doc.get_root_node().get_attributes().insert("fail", "yes");
+        docs.push_back(doc);
+    }
+
+    // the same document may be given several times, as separate copies
+    docs.push_back(docs[10]);
+    docs.push_back(docs[10]);
+
+    std::vector<xslt::transform_result> results =
+        style.transform_batch(docs, xslt::params(), 4);
+    BOOST_REQUIRE_EQUAL( results.size(), docs.size() );
+
+    for ( std::size_t i = 0; i < results.size(); ++i )
+    {
+        const std::size_t n = i < 50 ? i : 10;
+        if ( n % 7 == 3 )
+        {
+            BOOST_CHECK( !results[i].is_successful() );
+            BOOST_CHECK( !results[i].get_error_message().empty() );
+        }
+        else
+        {
+            BOOST_CHECK( results[i].is_successful() );
+
+            std::string output;
+            results[i].get_document().save_to_string(output);
+            BOOST_CHECK_EQUAL( output, expected_05a_output(n) );
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE( transform_batch_files )
+{
+    const xslt::stylesheet style(test_file_path("xslt/data/02a.xsl").c_str());
+
+    std::vector<std::string> filenames;
+    filenames.push_back(test_file_path("xslt/data/input.xml"));
+    filenames.push_back(test_file_path("xslt/data/no_such_file.xml"));
+    filenames.push_back(test_file_path("xslt/data/input.xml"));
+
+    std::vector<xslt::transform_result> results =
+        style.transform_batch(filenames, xslt::params());
+    BOOST_REQUIRE_EQUAL( results.size(), 3 );
+
+    BOOST_CHECK( results[0].is_successful() );
+    BOOST_CHECK( is_same_as_file(results[0].get_document(), "xslt/data/02a.out") );
+
+    BOOST_CHECK( !results[1].is_successful() );
+    BOOST_CHECK( !results[1].get_error_message().empty() );
+
+    BOOST_CHECK( results[2].is_successful() );
+    BOOST_CHECK( is_same_as_file(results[2].get_document(), "xslt/data/02a.out") );
+
+    BOOST_CHECK( style.transform_batch(std::vector<std::string>(), xslt::params()).empty() );
+}
+
+
+/*
+ * Test xslt::pipeline
+ */
+
+BOOST_AUTO_TEST_CASE( pipeline_run )
+{
+    const xslt::stylesheet style1(test_file_path("xslt/data/06a.xsl").c_str());
+    const xslt::stylesheet style2(test_file_path("xslt/data/06b.xsl").c_str());
+    xml::tree_parser parser(test_file_path("xslt/data/input.xml").c_str());
+
+    xslt::params p;
+    p.set_string("title", "pipeline");
+
+    xslt::pipeline pipe;
+    pipe.add_stage(style1);
+    pipe.add_stage(style2, p);
+    BOOST_CHECK_EQUAL( pipe.size(), 2 );
+
+    std::vector<double> times;
+    xslt::transform_result result = pipe.run(parser.get_document(), &times);
+    BOOST_REQUIRE( result.is_successful() );
+    BOOST_CHECK( is_same_as_file(result.get_document(), "xslt/data/06a.out") );
+
+    BOOST_REQUIRE_EQUAL( times.size(), 2 );
+    BOOST_CHECK( times[0] >= 0 );
+    BOOST_CHECK( times[1] >= 0 );
+
+    std::ostringstream ostr;
+    xslt::transform_result result_to = pipe.run_to(parser.get_document(), ostr);
+    BOOST_CHECK( result_to.is_successful() );
+    BOOST_CHECK( is_same_as_file(ostr, "xslt/data/06a.out") );
+}
+
+BOOST_AUTO_TEST_CASE( pipeline_html_intermediate )
+{
+    const xslt::stylesheet style1(test_file_path("xslt/data/02a.xsl").c_str());
+    const xslt::stylesheet style2(test_file_path("xslt/data/06c.xsl").c_str());
+    xml::tree_parser parser(test_file_path("xslt/data/input.xml").c_str());
+
+    xslt::pipeline pipe;
+    pipe.add_stage(style1);
+    pipe.add_stage(style2);
+
+    xslt::transform_result result = pipe.run(parser.get_document());
+    BOOST_REQUIRE( result.is_successful() );
+    BOOST_CHECK( is_same_as_file(result.get_document(), "xslt/data/06c.out") );
+}
+
+BOOST_AUTO_TEST_CASE( pipeline_errors )
+{
+    const xslt::stylesheet style1(test_file_path("xslt/data/06a.xsl").c_str());
+    const xslt::stylesheet style2(test_file_path("xslt/data/with_errors.xsl").c_str());
+    xml::tree_parser parser(test_file_path("xslt/data/input.xml").c_str());
+
+    xslt::pipeline empty;
+    BOOST_CHECK_EQUAL( empty.size(), 0 );
+    BOOST_CHECK( !empty.run(parser.get_document()).is_successful() );
+
+    xslt::pipeline pipe;
+    pipe.add_stage(style1);
+    pipe.add_stage(style2);
+    pipe.add_stage(style1);
+
+    std::vector<double> times;
+    xslt::transform_result result = pipe.run(parser.get_document(), &times);
+    BOOST_CHECK( !result.is_successful() );
+    BOOST_CHECK( result.get_error_message().find("stage 2") != std::string::npos );
+
+    // the stage after the failed one is not run
+    BOOST_CHECK_EQUAL( times.size(), 2 );
+}
+
+
+/*
+ * Test extension functions
+ */
+
+namespace
+{
+
+const char *EXT_NS = "http://xmlwrapp.example/ext";
+
+struct upper_function : public xslt::extension_function
+{
+    virtual void execute(xslt::extension_call& call)
+    {
+        std::string s = call.get_string(0);
+        for ( std::string::iterator i = s.begin(); i != s.end(); ++i )
+            *i = std::toupper(*i);
+        call.return_string(s);
+    }
+};
+
+struct sum_function : public xslt::extension_function
+{
+    virtual void execute(xslt::extension_call& call)
+    {
+        double sum = 0;
+        for ( std::size_t i = 0; i < call.size(); ++i )
+        {
+            if ( call.get_type(i) != xslt::extension_call::type_node_set )
+            {
+                sum += call.get_number(i);
+                continue;
+            }
+
+            for ( std::size_t n = 0; n < call.get_node_count(i); ++n )
+                sum += std::atof(call.get_node_string(i, n).c_str());
+        }
+        call.return_number(sum);
+    }
+};
+
+struct types_function : public xslt::extension_function
+{
+    virtual void execute(xslt::extension_call& call)
+    {
+        std::string types;
+        for ( std::size_t i = 0; i < call.size(); ++i )
+        {
+            switch ( call.get_type(i) )
+            {
+                case xslt::extension_call::type_node_set: types += 'n'; break;
+                case xslt::extension_call::type_boolean:  types += 'b'; break;
+                case xslt::extension_call::type_number:   types += 'n'; break;
+                case xslt::extension_call::type_string:   types += 's'; break;
+                default:                                  types += '?'; break;
+            }
+        }
+        call.return_string(types);
+    }
+};
+
+struct split_function : public xslt::extension_function
+{
+    virtual void execute(xslt::extension_call& call)
+    {
+        const std::string s = call.get_string(0);
+        const std::string sep = call.get_string(1);
+
+        std::string::size_type start = 0;
+        for ( ;; )
+        {
+            const std::string::size_type end = s.find(sep, start);
+            call.add_result_node(xml::node("token", s.substr(start, end - start).c_str()));
+            if ( end == std::string::npos )
+                break;
+            start = end + sep.length();
+        }
+    }
+};
+
+struct last_function : public xslt::extension_function
+{
+    virtual void execute(xslt::extension_call& call)
+    {
+        const std::size_t count = call.get_node_count(0);
+        if ( count )
+            call.add_result_node(0, count - 1);
+        else
+            call.return_boolean(false);
+    }
+};
+
+struct nothing_function : public xslt::extension_function
+{
+    virtual void execute(xslt::extension_call&) { }
+};
+
+struct fail_function : public xslt::extension_function
+{
+    virtual void execute(xslt::extension_call&)
+    {
+        throw std::runtime_error("deliberate failure");
+    }
+};
+
+xml::document make_07a_input()
+{
+    xml::document doc("root");
+    doc.get_root_node().get_attributes().insert("name", "abc");
+    for ( int i = 1; i <= 3; ++i )
+    {
+        std::ostringstream n;
+        n << i;
+        xml::node child("child", n.str().c_str());
+        child.get_attributes().insert("n", n.str().c_str());
+        doc.get_root_node().push_back(child);
+    }
+    return doc;
+}
+
+} // anonymous namespace
+
+BOOST_AUTO_TEST_CASE( extension_functions )
+{
+    upper_function upper;
+    sum_function sum;
+    types_function types;
+    split_function split;
+    last_function last;
+    nothing_function nothing;
+
+    xslt::stylesheet style(test_file_path("xslt/data/07a.xsl").c_str());
+    style.register_function(EXT_NS, "upper", sum);
+    style.register_function(EXT_NS, "upper", upper); // replaces the previous one
+    style.register_function(EXT_NS, "sum", sum);
+    style.register_function(EXT_NS, "types", types);
+    style.register_function(EXT_NS, "split", split);
+    style.register_function(EXT_NS, "last", last);
+    style.register_function(EXT_NS, "nothing", nothing);
+
+    const xml::document doc(make_07a_input());
+
+    xslt::transform_result result = style.transform(doc);
+    BOOST_REQUIRE_MESSAGE( result.is_successful(), result.get_error_message() );
+    BOOST_CHECK( is_same_as_file(result.get_document(), "xslt/data/07a.out") );
+
+    // the functions are available from all threads using the stylesheet
+    std::vector<xml::document> docs(20, doc);
+    std::vector<xslt::transform_result> results =
+        style.transform_batch(docs, xslt::params(), 4);
+    for ( std::size_t i = 0; i < results.size(); ++i )
+    {
+        BOOST_REQUIRE( results[i].is_successful() );
+        BOOST_CHECK( is_same_as_file(results[i].get_document(), "xslt/data/07a.out") );
+    }
+}
+
+BOOST_AUTO_TEST_CASE( extension_function_error )
+{
+    fail_function fail;
+
+    xslt::stylesheet style(test_file_path("xslt/data/07b.xsl").c_str());
+    style.register_function(EXT_NS, "fail", fail);
+
+    xslt::transform_result result = style.transform(make_07a_input());
+    BOOST_CHECK( !result.is_successful() );
+    BOOST_CHECK( result.get_error_message().find("deliberate failure") != std::string::npos );
+}
+
+/*
+ * Test xslt::stylesheet_cache
+ */
+
+BOOST_AUTO_TEST_CASE( cache_get )
+{
+    xslt::stylesheet_cache cache;
+    const std::string filename = test_file_path("xslt/data/02a.xsl");
+
+    xslt::stylesheet_cache::handle style1 = cache.get(filename.c_str());
+    xslt::stylesheet_cache::handle style2 = cache.get(filename.c_str());
+    BOOST_CHECK( style1.get() != 0 );
+    BOOST_CHECK( style1.get() == style2.get() );
+    BOOST_CHECK_EQUAL( cache.size(), 1 );
+
+    xml::tree_parser parser(test_file_path("xslt/data/input.xml").c_str());
+    xslt::transform_result result = style1->transform(parser.get_document());
+    BOOST_CHECK( is_same_as_file(result.get_document(), "xslt/data/02a.out") );
+
+    cache.clear();
+    BOOST_CHECK_EQUAL( cache.size(), 0 );
+
+    // the handle must remain usable after the stylesheet left the cache
+    result = style2->transform(parser.get_document());
+    BOOST_CHECK( is_same_as_file(result.get_document(), "xslt/data/02a.out") );
+}
+
+BOOST_AUTO_TEST_CASE( cache_get_fail )
+{
+    xslt::stylesheet_cache cache;
+
+    BOOST_CHECK_THROW
+    (
+        cache.get(test_file_path("xslt/data/01a.xsl").c_str()),
+        xml::exception
+    );
+    BOOST_CHECK_EQUAL( cache.size(), 0 );
+}
+
+BOOST_AUTO_TEST_CASE( cache_lru )
+{
+    xslt::stylesheet_cache cache(2);
+    BOOST_CHECK_EQUAL( cache.get_max_size(), 2 );
+
+    const std::string file1 = test_file_path("xslt/data/01b.xsl");
+    const std::string file2 = test_file_path("xslt/data/02a.xsl");
+    const std::string file3 = test_file_path("xslt/data/03a.xsl");
+
+    xslt::stylesheet_cache::handle style1 = cache.get(file1.c_str());
+    xslt::stylesheet_cache::handle style2 = cache.get(file2.c_str());
+    cache.get(file1.c_str());
+    cache.get(file3.c_str());
+    BOOST_CHECK_EQUAL( cache.size(), 2 );
+
+    // the least recently used stylesheet was evicted
+    BOOST_CHECK( cache.get(file1.c_str()).get() == style1.get() );
+    BOOST_CHECK( cache.get(file2.c_str()).get() != style2.get() );
+
+    cache.remove(file1.c_str());
+    BOOST_CHECK_EQUAL( cache.size(), 1 );
+}
+
+namespace
+{
+
+const char *CACHE_MAIN_FILE = "test_cache_main.xsl";
+const char *CACHE_IMPORTED_FILE = "test_cache_imported.xsl";
+
+void write_imported_stylesheet(const char *text)
+{
+    std::ofstream f(CACHE_IMPORTED_FILE);
+    f << "<xsl:stylesheet version=\"1.0\" xmlns:xsl=\"http://www.w3.org/1999/XSL/Transform\">\n"
+         "<xsl:template match=\"/\"><out>" << text << "</out></xsl:template>\n"
+         "</xsl:stylesheet>\n";
+}
+
+std::string transform_to_string(const xslt::stylesheet& style)
+{
+    xml::document input("root");
+    std::string s;
+    style.transform(input).get_document().save_to_string(s);
+    return s;
+}
+
+} // anonymous namespace
+
+BOOST_AUTO_TEST_CASE( cache_reload_imported )
+{
+    {
+        std::ofstream f(CACHE_MAIN_FILE);
+        f << "<xsl:stylesheet version=\"1.0\" xmlns:xsl=\"http://www.w3.org/1999/XSL/Transform\">\n"
+             "<xsl:import href=\"" << CACHE_IMPORTED_FILE << "\"/>\n"
+             "</xsl:stylesheet>\n";
+    }
+    write_imported_stylesheet("one");
+
+    xslt::stylesheet_cache cache;
+
+    xslt::stylesheet_cache::handle style1 = cache.get(CACHE_MAIN_FILE);
+    BOOST_CHECK_EQUAL( transform_to_string(*style1),
+                       "<?xml version=\"1.0\"?>\n<out>one</out>\n" );
+    BOOST_CHECK( cache.get(CACHE_MAIN_FILE).get() == style1.get() );
+
+    // changing only the imported file must be noticed too
+    write_imported_stylesheet("second");
+
+    xslt::stylesheet_cache::handle style2 = cache.get(CACHE_MAIN_FILE);
+    BOOST_CHECK( style2.get() != style1.get() );
+    BOOST_CHECK_EQUAL( transform_to_string(*style2),
+                       "<?xml version=\"1.0\"?>\n<out>second</out>\n" );
+    BOOST_CHECK_EQUAL( cache.size(), 1 );
+
+    // the old stylesheet is still usable
+    BOOST_CHECK_EQUAL( transform_to_string(*style1),
+                       "<?xml version=\"1.0\"?>\n<out>one</out>\n" );
+
+    remove(CACHE_MAIN_FILE);
+    remove(CACHE_IMPORTED_FILE);
+}
+
+namespace
+{
+
+class concurrent_cache_user
+{
+public:
+    concurrent_cache_user(xslt::stylesheet_cache& cache, int id, std::string& result)
+        : cache_(cache), id_(id), result_(result) {}
+
+    void operator()()
+    {
+        const char *files[] = { "xslt/data/01b.xsl", "xslt/data/02a.xsl", "xslt/data/03a.xsl" };
+
+        xml::tree_parser parser(test_file_path("xslt/data/input.xml").c_str());
+
+        for ( int i = 0; i < 30; ++i )
+        {
+            const std::string filename = test_file_path(files[(id_ + i) % 3]);
+            xslt::stylesheet_cache::handle style = cache_.get(filename.c_str());
+
+            if ( filename == test_file_path("xslt/data/02a.xsl") )
+                style->transform(parser.get_document()).get_document().save_to_string(result_);
+        }
+    }
+
+private:
+    xslt::stylesheet_cache& cache_;
+    int id_;
+    std::string& result_;
+};
+
+} // anonymous namespace
+
+BOOST_AUTO_TEST_CASE( cache_concurrent )
+{
+    // use a cache smaller than the number of stylesheets to exercise eviction
+    xslt::stylesheet_cache cache(2);
+
+    const int thread_count = 16;
+    std::vector<std::string> results(thread_count);
+
+    boost::thread_group threads;
+    for ( int i = 0; i < thread_count; ++i )
+        threads.create_thread(concurrent_cache_user(cache, i, results[i]));
+    threads.join_all();
+
+    BOOST_CHECK_EQUAL( cache.size(), 2 );
+    for ( int i = 0; i < thread_count; ++i )
+        BOOST_CHECK( is_same_as_file(results[i], "xslt/data/02a.out") );
+}
+
+
+
+/*
+ * Test xslt::document_loader
+ */
+
+namespace
+{
+
+const char *LOADER_STYLESHEET_FILE = "test_loader.xsl";
+const char *LOADER_STRIP_FILE = "test_loader_strip.xsl";
+const char *LOADER_LOOKUP_FILE = "test_loader_lookup.xml";
+
+void write_loader_stylesheet(const char *filename, const char *top, const char *select)
+{
+    std::ofstream f(filename);
+    f << "<xsl:stylesheet version=\"1.0\" xmlns:xsl=\"http://www.w3.org/1999/XSL/Transform\">\n"
+      << top
+      << "<xsl:template match=\"/\"><out><xsl:value-of select=\"" << select << "\"/></out></xsl:template>\n"
+         "</xsl:stylesheet>\n";
+}
+
+void write_lookup(const char *value)
+{
+    std::ofstream f(LOADER_LOOKUP_FILE);
+    f << "<lookup value=\"" << value << "\">\n  <item/>\n</lookup>\n";
+}
+
+std::string loader_output(const char *text)
+{
+    return std::string("<?xml version=\"1.0\"?>\n<out>") + text + "</out>\n";
+}
+
+} // anonymous namespace
+
+BOOST_AUTO_TEST_CASE( loader_cache )
+{
+    write_loader_stylesheet(LOADER_STYLESHEET_FILE, "",
+        "concat(document('test_loader_lookup.xml')/lookup/@value, '/', "
+               "document('urn:xmlwrapp:preloaded')/data/@value, '/', "
+               "count(document('test_loader_lookup.xml')/lookup/node()))");
+    write_lookup("one");
+
+    xslt::document_loader loader;
+
+    xml::document preloaded("data");
+    preloaded.get_root_node().get_attributes().insert("value", "pre");
+    loader.preload("urn:xmlwrapp:preloaded", preloaded);
+    BOOST_CHECK_EQUAL( loader.size(), 1 );
+
+    xslt::stylesheet style(LOADER_STYLESHEET_FILE);
+    style.set_document_loader(&loader);
+
+    const xml::document input("root");
+    BOOST_CHECK_EQUAL( transform_to_string(style), loader_output("one/pre/3") );
+    BOOST_CHECK_EQUAL( loader.size(), 2 );
+
+    // this time the documents come from the loader
+    BOOST_CHECK_EQUAL( transform_to_string(style), loader_output("one/pre/3") );
+
+    std::vector<xml::document> docs(20, input);
+    std::vector<xslt::transform_result> results =
+        style.transform_batch(docs, xslt::params(), 4);
+    for ( std::size_t i = 0; i < results.size(); ++i )
+    {
+        BOOST_REQUIRE( results[i].is_successful() );
+        std::string s;
+        results[i].get_document().save_to_string(s);
+        BOOST_CHECK_EQUAL( s, loader_output("one/pre/3") );
+    }
+
+    // modified files are loaded again
+    write_lookup("second");
+    BOOST_CHECK_EQUAL( transform_to_string(style), loader_output("second/pre/3") );
+    BOOST_CHECK_EQUAL( loader.size(), 2 );
+
+    BOOST_CHECK( loader.remove("urn:xmlwrapp:preloaded") );
+    BOOST_CHECK( !loader.remove("urn:xmlwrapp:preloaded") );
+    BOOST_CHECK_EQUAL( loader.size(), 1 );
+
+    loader.clear();
+    BOOST_CHECK_EQUAL( loader.size(), 0 );
+
+    // the default loader is used for the stylesheets without one and it
+    // doesn't know about the preloaded documents
+    xslt::stylesheet style_default(LOADER_STYLESHEET_FILE);
+    BOOST_CHECK_EQUAL( transform_to_string(style_default), loader_output("second//3") );
+
+    style.set_document_loader(0);
+    BOOST_CHECK_EQUAL( transform_to_string(style), loader_output("second//3") );
+    BOOST_CHECK_EQUAL( loader.size(), 0 );
+
+    remove(LOADER_STYLESHEET_FILE);
+    remove(LOADER_LOOKUP_FILE);
+}
+
+BOOST_AUTO_TEST_CASE( loader_strip_space )
+{
+    write_loader_stylesheet(LOADER_STRIP_FILE,
+        "<xsl:strip-space elements=\"*\"/>\n",
+        "count(document('test_loader_lookup.xml')/lookup/node())");
+    write_loader_stylesheet(LOADER_STYLESHEET_FILE, "",
+        "count(document('test_loader_lookup.xml')/lookup/node())");
+    write_lookup("one");
+
+    xslt::document_loader loader;
+
+    xslt::stylesheet style_strip(LOADER_STRIP_FILE);
+    style_strip.set_document_loader(&loader);
+    xslt::stylesheet style(LOADER_STYLESHEET_FILE);
+    style.set_document_loader(&loader);
+
+    // stripping the whitespace must not affect the cached document
+    for ( int i = 0; i < 2; ++i )
+    {
+        BOOST_CHECK_EQUAL( transform_to_string(style_strip), loader_output("1") );
+        BOOST_CHECK_EQUAL( transform_to_string(style), loader_output("3") );
+    }
+    BOOST_CHECK_EQUAL( loader.size(), 1 );
+
+    remove(LOADER_STRIP_FILE);
+    remove(LOADER_STYLESHEET_FILE);
+    remove(LOADER_LOOKUP_FILE);
+}
+
+
+/*
+ * Test xslt::transform_limits
+ */
+
+namespace
+{
+
+xslt::transform_result
+transform_with_limits(const char *name, int n, const xslt::transform_limits& limits)
+{
+    const xslt::stylesheet style(test_file_path("xslt/data/08a.xsl").c_str());
+    xml::tree_parser parser(test_file_path("xslt/data/input.xml").c_str());
+
+    std::ostringstream value;
+    value << n;
+    xslt::params params;
+    params.set(name, value.str().c_str());
+
+    return style.transform(parser.get_document(), params, limits);
+}
+
+struct delayed_canceller
+{
+    delayed_canceller(xslt::cancellation_token& token) : token_(token) { }
+
+    void operator()()
+    {
+        boost::this_thread::sleep(boost::posix_time::milliseconds(100));
+        token_.cancel();
+    }
+
+    xslt::cancellation_token& token_;
+};
+
+} // anonymous namespace
+
+BOOST_AUTO_TEST_CASE( limits_defaults )
+{
+    xslt::transform_limits limits;
+    BOOST_CHECK_EQUAL( limits.get_max_template_depth(), 0 );
+    BOOST_CHECK_EQUAL( limits.get_max_variable_depth(), 0 );
+    BOOST_CHECK_EQUAL( limits.get_time_limit(), 0 );
+    BOOST_CHECK( limits.get_cancellation_token() == NULL );
+
+    xslt::transform_result r = transform_with_limits("depth", 1000, limits);
+    BOOST_CHECK( r.is_successful() );
+    BOOST_CHECK_EQUAL( r.get_error_type(), xslt::transform_result::error_none );
+
+    const xslt::stylesheet
+        style_with_errors(test_file_path("xslt/data/with_errors.xsl").c_str());
+    xml::tree_parser parser(test_file_path("xslt/data/input.xml").c_str());
+    r = style_with_errors.transform(parser.get_document());
+    BOOST_CHECK( !r.is_successful() );
+    BOOST_CHECK_EQUAL( r.get_error_type(), xslt::transform_result::error_transform );
+}
+
+BOOST_AUTO_TEST_CASE( limits_template_depth )
+{
+    xslt::transform_limits limits;
+    limits.set_max_template_depth(100);
+
+    xslt::transform_result r = transform_with_limits("depth", 1000, limits);
+    BOOST_CHECK( !r.is_successful() );
+    BOOST_CHECK_EQUAL( r.get_error_type(), xslt::transform_result::error_template_depth );
+
+    r = transform_with_limits("depth", 10, limits);
+    BOOST_CHECK( r.is_successful() );
+}
+
+BOOST_AUTO_TEST_CASE( limits_variable_depth )
+{
+    xslt::transform_limits limits;
+    limits.set_max_variable_depth(50);
+
+    xslt::transform_result r = transform_with_limits("vars", 100, limits);
+    BOOST_CHECK( !r.is_successful() );
+    BOOST_CHECK_EQUAL( r.get_error_type(), xslt::transform_result::error_variable_depth );
+
+    r = transform_with_limits("vars", 5, limits);
+    BOOST_CHECK( r.is_successful() );
+}
+
+BOOST_AUTO_TEST_CASE( limits_time )
+{
+    xslt::transform_limits limits;
+    limits.set_time_limit(0.2);
+
+    // this would take years without the limit
+    xslt::transform_result r = transform_with_limits("calls", 100, limits);
+    BOOST_CHECK( !r.is_successful() );
+    BOOST_CHECK_EQUAL( r.get_error_type(), xslt::transform_result::error_time_limit );
+
+    r = transform_with_limits("calls", 3, limits);
+    BOOST_CHECK( r.is_successful() );
+}
+
+BOOST_AUTO_TEST_CASE( limits_cancel )
+{
+    xslt::cancellation_token token;
+    xslt::transform_limits limits;
+    limits.set_cancellation_token(&token);
+
+    xslt::transform_result r = transform_with_limits("calls", 3, limits);
+    BOOST_CHECK( r.is_successful() );
+
+    boost::thread canceller((delayed_canceller(token)));
+    r = transform_with_limits("calls", 100, limits);
+    canceller.join();
+    BOOST_CHECK( token.is_cancelled() );
+    BOOST_CHECK( !r.is_successful() );
+    BOOST_CHECK_EQUAL( r.get_error_type(), xslt::transform_result::error_cancelled );
+
+    // already cancelled token stops the transformation immediately
+    const xslt::stylesheet style(test_file_path("xslt/data/08a.xsl").c_str());
+    xml::tree_parser parser(test_file_path("xslt/data/input.xml").c_str());
+    std::ostringstream out;
+    r = style.transform_to(parser.get_document(), out, xslt::params(), limits);
+    BOOST_CHECK( !r.is_successful() );
+    BOOST_CHECK_EQUAL( r.get_error_type(), xslt::transform_result::error_cancelled );
+}
+
+BOOST_AUTO_TEST_CASE( exslt_on_demand )
+{
+    xslt::init::exslt_modules(xslt::init::exslt_math | xslt::init::exslt_strings);
+    xslt::init::exslt_on_demand(true);
+
+    // the EXSLT namespaces are only declared in the imported stylesheet
+    const xslt::stylesheet style(test_file_path("xslt/data/10a.xsl").c_str());
+
+    xslt::init::exslt_modules(xslt::init::exslt_all);
+    xslt::init::exslt_on_demand(false);
+
+    xml::tree_parser parser(test_file_path("xslt/data/input.xml").c_str());
+    xslt::transform_result r = style.transform(parser.get_document());
+    BOOST_REQUIRE( r.is_successful() );
+
+    std::string output;
+    r.get_document().save_to_string(output);
+    BOOST_CHECK( is_same_as_file(output, "xslt/data/10a.out") );
+}
+
 BOOST_AUTO_TEST_SUITE_END()